@@ -0,0 +1,167 @@
+/*
+ * File twi_regs.h
+ * Author: Tycho Jöbsis
+ * Date: 16-10-2026
+ */ 
+
+/*
+*	MIT License
+*
+*	Copyright (c) 2021 TychoJ
+*
+*	Permission is hereby granted, free of charge, to any person obtaining a copy
+*	of this software and associated documentation files (the "Software"), to deal
+*	in the Software without restriction, including without limitation the rights
+*	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*	copies of the Software, and to permit persons to whom the Software is
+*	furnished to do so, subject to the following conditions:
+*
+*	The above copyright notice and this permission notice shall be included in all
+*	copies or substantial portions of the Software.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*	SOFTWARE.
+*/
+
+#include <avr/io.h>
+
+#ifndef TWI_REGS_H_
+#define TWI_REGS_H_
+
+/*
+ * Register mapping of the tinyAVR 0/1-series TWI master for the common TWI core.
+ * Registers are changed with a read and a write, twi.hpp includes this file and C++20 deprecates |= on volatile.
+ */
+
+//enable and interrupts
+#define TWI_M_CTRL(twi)		((twi)->MCTRLA)
+//timeout, smart mode and quick command, the same register as enable on this family
+#define TWI_M_MODE(twi)		((twi)->MCTRLA)
+//acknowledge action and command
+#define TWI_M_CMD(twi)		((twi)->MCTRLB)
+#define TWI_M_STATUS(twi)	((twi)->MSTATUS)
+#define TWI_M_BAUD(twi)		((twi)->MBAUD)
+#define TWI_M_ADDR(twi)		((twi)->MADDR)
+#define TWI_M_DATA(twi)		((twi)->MDATA)
+
+#define TWI_M_ENABLE_bm		TWI_ENABLE_bm
+#define TWI_M_RIEN_bm		TWI_RIEN_bm
+#define TWI_M_WIEN_bm		TWI_WIEN_bm
+
+#define TWI_M_TIMEOUT_gm				TWI_TIMEOUT_gm
+#define TWI_M_TIMEOUT_DISABLED_gc		(0x00 << 2)
+#define TWI_M_TIMEOUT_50US_gc			(0x01 << 2)
+#define TWI_M_TIMEOUT_100US_gc			(0x02 << 2)
+#define TWI_M_TIMEOUT_200US_gc			(0x03 << 2)
+#define TWI_M_SMEN_bm		TWI_SMEN_bm
+#define TWI_M_QCEN_bm		TWI_QCEN_bm
+
+#define TWI_M_ACKACT_bm				TWI_ACKACT_bm
+#define TWI_M_CMD_RECVTRANS_gc		TWI_MCMD_RECVTRANS_gc
+#define TWI_M_CMD_STOP_gc			TWI_MCMD_STOP_gc
+
+#define TWI_M_RIF_bm		TWI_RIF_bm
+#define TWI_M_WIF_bm		TWI_WIF_bm
+#define TWI_M_RXACK_bm		TWI_RXACK_bm
+#define TWI_M_ARBLOST_bm	TWI_ARBLOST_bm
+#define TWI_M_BUSERR_bm		TWI_BUSERR_bm
+#define TWI_M_BUSSTATE_gm			TWI_BUSSTATE_gm
+#define TWI_M_BUSSTATE_UNKNOWN_gc	TWI_BUSSTATE_UNKNOWN_gc
+#define TWI_M_BUSSTATE_IDLE_gc		TWI_BUSSTATE_IDLE_gc
+#define TWI_M_BUSSTATE_OWNER_gc		TWI_BUSSTATE_OWNER_gc
+#define TWI_M_BUSSTATE_BUSY_gc		TWI_BUSSTATE_BUSY_gc
+
+//this family has no interrupt levels, the level of twi_async_init is ignored
+#define TWI_INTLVL_LO		0
+#define TWI_INTLVL_MED		0
+#define TWI_INTLVL_HI		0
+
+static inline void twi_regs_enable_interrupts(TWI_t *twi, uint8_t intlvl){
+	(void)intlvl;
+	twi->MCTRLA = twi->MCTRLA | TWI_RIEN_bm | TWI_WIEN_bm;
+}
+
+//Fast-mode Plus drive strength of the pins
+#define TWI_HAS_FMPLUS 1
+
+static inline void twi_regs_set_fmplus(TWI_t *twi, uint8_t on){
+	if(on) twi->CTRLA = twi->CTRLA | TWI_FMPEN_bm;
+	else twi->CTRLA = twi->CTRLA & ~TWI_FMPEN_bm;
+}
+
+static inline uint8_t twi_regs_fmplus(TWI_t *twi){
+	return (twi->CTRLA & TWI_FMPEN_bm) ? 1 : 0;
+}
+
+//free running 16 bit timer for the deadlines, it counts at F_CPU / TWI_TIMER_DIV
+typedef TCB_t TWI_TIMER_t;
+#define TWI_TIMER_DIV		2
+#define TWI_TIMER_CNT(tc)	((tc)->CNT)
+
+static inline void twi_regs_timer_start(TWI_TIMER_t *tc){
+	tc->CTRLB = TCB_CNTMODE_INT_gc;
+	tc->CCMP = 0xFFFF;
+	tc->CTRLA = TCB_CLKSEL_CLKDIV2_gc | TCB_ENABLE_bm;
+}
+
+//periodic interrupt for twi_sampler.c, the INT vector of the timer comes every period counts
+//of F_CPU / TWI_TICK_DIV, the TCB has no larger prescaler without TCA
+#define TWI_TICK_DIV		2
+
+static inline void twi_regs_tick_start(TWI_TIMER_t *tc, uint16_t period){
+	tc->CTRLB = TCB_CNTMODE_INT_gc;
+	tc->CCMP = period - 1;
+	tc->INTFLAGS = TCB_CAPT_bm;
+	tc->INTCTRL = TCB_CAPT_bm;
+	tc->CTRLA = TCB_CLKSEL_CLKDIV2_gc | TCB_ENABLE_bm;
+}
+
+//the CAPT flag stays set until it is written, called from the vector
+static inline void twi_regs_tick_clear(TWI_TIMER_t *tc){
+	tc->INTFLAGS = TCB_CAPT_bm;
+}
+
+
+/*
+ * Slave registers
+ */
+#define TWI_S_CTRL(twi)		((twi)->SCTRLA)
+#define TWI_S_CMD(twi)		((twi)->SCTRLB)
+#define TWI_S_STATUS(twi)	((twi)->SSTATUS)
+#define TWI_S_ADDR(twi)		((twi)->SADDR)
+#define TWI_S_DATA(twi)		((twi)->SDATA)
+#define TWI_S_ADDRMASK(twi)	((twi)->SADDRMASK)
+
+#define TWI_S_ENABLE_bm		TWI_ENABLE_bm
+#define TWI_S_DIEN_bm		TWI_DIEN_bm
+#define TWI_S_APIEN_bm		TWI_APIEN_bm
+#define TWI_S_PIEN_bm		TWI_PIEN_bm
+
+#define TWI_S_ACKACT_bm				TWI_ACKACT_bm
+#define TWI_S_CMD_COMPTRANS_gc		TWI_SCMD_COMPTRANS_gc
+#define TWI_S_CMD_RESPONSE_gc		TWI_SCMD_RESPONSE_gc
+
+#define TWI_S_DIF_bm		TWI_DIF_bm
+#define TWI_S_APIF_bm		TWI_APIF_bm
+#define TWI_S_RXACK_bm		TWI_RXACK_bm
+#define TWI_S_COLL_bm		TWI_COLL_bm
+#define TWI_S_BUSERR_bm		TWI_BUSERR_bm
+#define TWI_S_DIR_bm		TWI_DIR_bm
+#define TWI_S_AP_bm			TWI_AP_bm
+
+//ADDRMASK holds a second address instead of a mask
+#define TWI_S_ADDREN_bm		TWI_ADDREN_bm
+
+//enables the slave with its interrupts, this family has no interrupt levels
+static inline void twi_regs_enable_slave(TWI_t *twi, uint8_t intlvl){
+	(void)intlvl;
+	twi->SCTRLA = TWI_DIEN_bm | TWI_APIEN_bm | TWI_PIEN_bm | TWI_ENABLE_bm;
+}
+
+
+#endif /* TWI_REGS_H_ */
@@ -0,0 +1,203 @@
+/*
+ * File twi_regs.h
+ * Author: Tycho Jöbsis
+ * Date: 16-10-2026
+ */ 
+
+/*
+*	MIT License
+*
+*	Copyright (c) 2021 TychoJ
+*
+*	Permission is hereby granted, free of charge, to any person obtaining a copy
+*	of this software and associated documentation files (the "Software"), to deal
+*	in the Software without restriction, including without limitation the rights
+*	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*	copies of the Software, and to permit persons to whom the Software is
+*	furnished to do so, subject to the following conditions:
+*
+*	The above copyright notice and this permission notice shall be included in all
+*	copies or substantial portions of the Software.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*	SOFTWARE.
+*/
+
+#include <avr/io.h>
+
+#ifndef TWI_REGS_H_
+#define TWI_REGS_H_
+
+/*
+ * Register mapping of the Xmega TWI master for the common TWI core.
+ * Registers are changed with a read and a write, twi.hpp includes this file and C++20 deprecates |= on volatile.
+ */
+
+//enable and interrupts
+#define TWI_M_CTRL(twi)		((twi)->MASTER.CTRLA)
+//timeout, smart mode and quick command
+#define TWI_M_MODE(twi)		((twi)->MASTER.CTRLB)
+//acknowledge action and command
+#define TWI_M_CMD(twi)		((twi)->MASTER.CTRLC)
+#define TWI_M_STATUS(twi)	((twi)->MASTER.STATUS)
+#define TWI_M_BAUD(twi)		((twi)->MASTER.BAUD)
+#define TWI_M_ADDR(twi)		((twi)->MASTER.ADDR)
+#define TWI_M_DATA(twi)		((twi)->MASTER.DATA)
+
+#define TWI_M_ENABLE_bm		TWI_MASTER_ENABLE_bm
+#define TWI_M_RIEN_bm		TWI_MASTER_RIEN_bm
+#define TWI_M_WIEN_bm		TWI_MASTER_WIEN_bm
+
+#define TWI_M_TIMEOUT_gm				TWI_MASTER_TIMEOUT_gm
+#define TWI_M_TIMEOUT_DISABLED_gc		TWI_MASTER_TIMEOUT_DISABLED_gc
+#define TWI_M_TIMEOUT_50US_gc			TWI_MASTER_TIMEOUT_50US_gc
+#define TWI_M_TIMEOUT_100US_gc			TWI_MASTER_TIMEOUT_100US_gc
+#define TWI_M_TIMEOUT_200US_gc			TWI_MASTER_TIMEOUT_200US_gc
+#define TWI_M_SMEN_bm		TWI_MASTER_SMEN_bm
+#define TWI_M_QCEN_bm		TWI_MASTER_QCEN_bm
+
+#define TWI_M_ACKACT_bm				TWI_MASTER_ACKACT_bm
+#define TWI_M_CMD_RECVTRANS_gc		TWI_MASTER_CMD_RECVTRANS_gc
+#define TWI_M_CMD_STOP_gc			TWI_MASTER_CMD_STOP_gc
+
+#define TWI_M_RIF_bm		TWI_MASTER_RIF_bm
+#define TWI_M_WIF_bm		TWI_MASTER_WIF_bm
+#define TWI_M_RXACK_bm		TWI_MASTER_RXACK_bm
+#define TWI_M_ARBLOST_bm	TWI_MASTER_ARBLOST_bm
+#define TWI_M_BUSERR_bm		TWI_MASTER_BUSERR_bm
+#define TWI_M_BUSSTATE_gm			TWI_MASTER_BUSSTATE_gm
+#define TWI_M_BUSSTATE_UNKNOWN_gc	TWI_MASTER_BUSSTATE_UNKNOWN_gc
+#define TWI_M_BUSSTATE_IDLE_gc		TWI_MASTER_BUSSTATE_IDLE_gc
+#define TWI_M_BUSSTATE_OWNER_gc		TWI_MASTER_BUSSTATE_OWNER_gc
+#define TWI_M_BUSSTATE_BUSY_gc		TWI_MASTER_BUSSTATE_BUSY_gc
+
+//interrupt levels for twi_async_init
+#define TWI_INTLVL_LO		TWI_MASTER_INTLVL_LO_gc
+#define TWI_INTLVL_MED		TWI_MASTER_INTLVL_MED_gc
+#define TWI_INTLVL_HI		TWI_MASTER_INTLVL_HI_gc
+
+//enables a level of the interrupt controller
+static inline void twi_regs_enable_level(uint8_t intlvl){
+	switch(intlvl){
+		case TWI_MASTER_INTLVL_LO_gc:
+		PMIC.CTRL = PMIC.CTRL | PMIC_LOLVLEN_bm;
+		break;
+		
+		case TWI_MASTER_INTLVL_MED_gc:
+		PMIC.CTRL = PMIC.CTRL | PMIC_MEDLVLEN_bm;
+		break;
+		
+		case TWI_MASTER_INTLVL_HI_gc:
+		PMIC.CTRL = PMIC.CTRL | PMIC_HILVLEN_bm;
+		break;
+		
+		default:
+		break;
+	}
+}
+
+//enables the master interrupts at a level of the interrupt controller
+static inline void twi_regs_enable_interrupts(TWI_t *twi, uint8_t intlvl){
+	twi->MASTER.CTRLA = (twi->MASTER.CTRLA & ~TWI_MASTER_INTLVL_gm) | intlvl | TWI_MASTER_RIEN_bm | TWI_MASTER_WIEN_bm;
+	twi_regs_enable_level(intlvl);
+}
+
+//Fast-mode Plus drive strength, only the Xmega devices with FMPLUSEN have it
+#ifdef TWI_FMPLUSEN_bm
+#define TWI_HAS_FMPLUS 1
+#else
+#define TWI_HAS_FMPLUS 0
+#endif
+
+static inline void twi_regs_set_fmplus(TWI_t *twi, uint8_t on){
+#ifdef TWI_FMPLUSEN_bm
+	if(on) twi->CTRL = twi->CTRL | TWI_FMPLUSEN_bm;
+	else twi->CTRL = twi->CTRL & ~TWI_FMPLUSEN_bm;
+#else
+	(void)twi;
+	(void)on;
+#endif
+}
+
+static inline uint8_t twi_regs_fmplus(TWI_t *twi){
+#ifdef TWI_FMPLUSEN_bm
+	return (twi->CTRL & TWI_FMPLUSEN_bm) ? 1 : 0;
+#else
+	(void)twi;
+	return 0;
+#endif
+}
+
+//free running 16 bit timer for the deadlines, it counts at F_CPU / TWI_TIMER_DIV
+typedef TC0_t TWI_TIMER_t;
+#define TWI_TIMER_DIV		8
+#define TWI_TIMER_CNT(tc)	((tc)->CNT)
+
+static inline void twi_regs_timer_start(TWI_TIMER_t *tc){
+	tc->CTRLB = TC_WGMODE_NORMAL_gc;
+	tc->PER = 0xFFFF;
+	tc->CTRLA = TC_CLKSEL_DIV8_gc;
+}
+
+//periodic interrupt for twi_sampler.c, the overflow vector of the timer comes every period counts
+//of F_CPU / TWI_TICK_DIV at the low level
+#define TWI_TICK_DIV		64
+
+static inline void twi_regs_tick_start(TWI_TIMER_t *tc, uint16_t period){
+	tc->CTRLB = TC_WGMODE_NORMAL_gc;
+	tc->PER = period - 1;
+	tc->INTCTRLA = TC_OVFINTLVL_LO_gc;
+	twi_regs_enable_level(TWI_MASTER_INTLVL_LO_gc);
+	tc->CTRLA = TC_CLKSEL_DIV64_gc;
+}
+
+//the overflow flag is cleared when its vector runs
+static inline void twi_regs_tick_clear(TWI_TIMER_t *tc){
+	(void)tc;
+}
+
+
+/*
+ * Slave registers
+ */
+#define TWI_S_CTRL(twi)		((twi)->SLAVE.CTRLA)
+#define TWI_S_CMD(twi)		((twi)->SLAVE.CTRLB)
+#define TWI_S_STATUS(twi)	((twi)->SLAVE.STATUS)
+#define TWI_S_ADDR(twi)		((twi)->SLAVE.ADDR)
+#define TWI_S_DATA(twi)		((twi)->SLAVE.DATA)
+#define TWI_S_ADDRMASK(twi)	((twi)->SLAVE.ADDRMASK)
+
+#define TWI_S_ENABLE_bm		TWI_SLAVE_ENABLE_bm
+#define TWI_S_DIEN_bm		TWI_SLAVE_DIEN_bm
+#define TWI_S_APIEN_bm		TWI_SLAVE_APIEN_bm
+#define TWI_S_PIEN_bm		TWI_SLAVE_PIEN_bm
+
+#define TWI_S_ACKACT_bm				TWI_SLAVE_ACKACT_bm
+#define TWI_S_CMD_COMPTRANS_gc		TWI_SLAVE_CMD_COMPTRANS_gc
+#define TWI_S_CMD_RESPONSE_gc		TWI_SLAVE_CMD_RESPONSE_gc
+
+#define TWI_S_DIF_bm		TWI_SLAVE_DIF_bm
+#define TWI_S_APIF_bm		TWI_SLAVE_APIF_bm
+#define TWI_S_RXACK_bm		TWI_SLAVE_RXACK_bm
+#define TWI_S_COLL_bm		TWI_SLAVE_COLL_bm
+#define TWI_S_BUSERR_bm		TWI_SLAVE_BUSERR_bm
+#define TWI_S_DIR_bm		TWI_SLAVE_DIR_bm
+#define TWI_S_AP_bm			TWI_SLAVE_AP_bm
+
+//ADDRMASK holds a second address instead of a mask
+#define TWI_S_ADDREN_bm		TWI_SLAVE_ADDREN_bm
+
+//enables the slave with its interrupts at a level of the interrupt controller
+static inline void twi_regs_enable_slave(TWI_t *twi, uint8_t intlvl){
+	//the master and slave interrupt levels use the same bits
+	twi->SLAVE.CTRLA = intlvl | TWI_SLAVE_DIEN_bm | TWI_SLAVE_APIEN_bm | TWI_SLAVE_PIEN_bm | TWI_SLAVE_ENABLE_bm;
+	twi_regs_enable_level(intlvl);
+}
+
+
+#endif /* TWI_REGS_H_ */
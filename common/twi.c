@@ -0,0 +1,1010 @@
+/*
+ * File TWI.c
+ * Author: Tycho J�bsis
+ * Date: 13-02-2021
+ */ 
+
+
+/*
+*	MIT License
+*
+*	Copyright (c) 2021 TychoJ
+*
+*	Permission is hereby granted, free of charge, to any person obtaining a copy
+*	of this software and associated documentation files (the "Software"), to deal
+*	in the Software without restriction, including without limitation the rights
+*	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*	copies of the Software, and to permit persons to whom the Software is
+*	furnished to do so, subject to the following conditions:
+*
+*	The above copyright notice and this permission notice shall be included in all
+*	copies or substantial portions of the Software.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*	SOFTWARE.
+*/
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+#include <util/delay.h>
+#include "twi.h"
+#include "twi_stats.h"
+#include "twi_trace.h"
+
+#ifdef TWI_ASYNC
+#include "twi_async.h"
+#define TWI_CLAIM(twi)		twi_async_claim(twi)
+#define TWI_RELEASE(twi)	twi_async_release(twi)
+#else
+#define TWI_CLAIM(twi)		((void)0)
+#define TWI_RELEASE(twi)	((void)0)
+#endif
+
+uint8_t enable_TWI(TWI_t *twi, uint32_t TWI_speed, uint8_t timeout){
+	//the module stays off when the speed can't be made
+	if(set_baud(twi, TWI_speed) != TWI_STATUS_OK) return TWI_INVALID_BAUD;
+	
+	set_acknowledge(twi, ACK);
+	TWI_M_CTRL(twi) |= TWI_M_ENABLE_bm;
+	set_timeout(twi, timeout);
+	return TWI_STATUS_OK;
+}
+
+void disable_TWI(TWI_t *twi){
+	TWI_M_CTRL(twi) &= ~TWI_M_ENABLE_bm;
+}
+
+void set_timeout(TWI_t *twi, uint8_t time_out){
+	//on some devices the enable bit shares this register, so only the mode bits are changed
+	uint8_t mode = TWI_M_MODE(twi) & ~(TWI_M_TIMEOUT_gm | TWI_M_SMEN_bm | TWI_M_QCEN_bm);
+	
+	switch(time_out & TWI_M_TIMEOUT_gm){
+		case TIMEOUT_DIS:
+		mode |= TIMEOUT_DIS;
+		TWI_M_STATUS(twi) = TWI_M_BUSSTATE_IDLE_gc;
+		break;
+		
+		case TIMEOUT_50US:
+		mode |= TIMEOUT_50US;
+		TWI_M_STATUS(twi) = TWI_M_BUSSTATE_UNKNOWN_gc;
+		break;
+		
+		case TIMEOUT_100US:
+		mode |= TIMEOUT_100US;
+		TWI_M_STATUS(twi) = TWI_M_BUSSTATE_UNKNOWN_gc;
+		break;
+		
+		case TIMEOUT_200US:
+		mode |= TIMEOUT_200US;
+		TWI_M_STATUS(twi) = TWI_M_BUSSTATE_UNKNOWN_gc;
+		break;
+		
+		default:
+		mode |= TIMEOUT_DIS;
+		TWI_M_STATUS(twi) = TWI_M_BUSSTATE_IDLE_gc;
+		break;
+	}
+	
+	//smart mode lives in the same register, quick command is only turned on by quick_command_TWI
+	TWI_M_MODE(twi) = mode | (time_out & TWI_SMART_MODE);
+}
+
+void set_acknowledge(TWI_t *twi, uint8_t ack){
+	(ack == ACK) ? (TWI_M_CMD(twi) = 0) : (TWI_M_CMD(twi) = TWI_M_ACKACT_bm);
+}
+
+uint8_t bus_state(TWI_t *twi){
+	switch(TWI_M_STATUS(twi) & TWI_M_BUSSTATE_gm){
+		case TWI_M_BUSSTATE_IDLE_gc:
+		return BUS_NOT_IN_USE;
+		
+		case TWI_M_BUSSTATE_OWNER_gc:
+		return OWNER_OF_BUS;
+		
+		case TWI_M_BUSSTATE_BUSY_gc:
+		return BUS_IN_USE;
+		
+		default:
+		return UNKNOWN_BUS_STATE;
+	}
+}
+
+void set_bus_state_TWI(TWI_t *twi, uint8_t state){
+	TWI_M_STATUS(twi) = state;
+}
+
+static uint8_t multi_master = 0;
+static uint8_t arb_retries = 0;
+static uint16_t arb_backoff_us = 0;
+
+void set_retries_TWI(uint8_t retries, uint16_t backoff_us){
+	arb_retries = retries;
+	arb_backoff_us = (backoff_us > TWI_BACKOFF_MAX_US) ? TWI_BACKOFF_MAX_US : backoff_us;
+}
+
+uint8_t recover_bus_TWI(TWI_t *twi, PORT_t *port, uint8_t sda_bm, uint8_t scl_bm){
+	uint8_t ctrla = TWI_M_CTRL(twi);
+	uint8_t i;
+	
+	//give the pins to the port, a pin is pulled low by making it an output
+	TWI_M_CTRL(twi) = ctrla & ~TWI_M_ENABLE_bm;
+	port->OUTCLR = sda_bm | scl_bm;
+	port->DIRCLR = sda_bm | scl_bm;
+	TWI_DELAY_US(5);
+	
+	//clock until the slave releases SDA, at most 9 clocks finish any byte and its ACK
+	for(i = 0; i < 9; i++){
+		if(port->IN & sda_bm) break;
+		
+		port->DIRSET = scl_bm;
+		TWI_DELAY_US(5);
+		port->DIRCLR = scl_bm;
+		TWI_DELAY_US(5);
+	}
+	
+	//stop condition: SDA goes high while SCL is high
+	port->DIRSET = sda_bm;
+	TWI_DELAY_US(5);
+	port->DIRCLR = scl_bm;
+	TWI_DELAY_US(5);
+	port->DIRCLR = sda_bm;
+	TWI_DELAY_US(5);
+	
+	TWI_M_CTRL(twi) = ctrla;
+	TWI_M_STATUS(twi) = TWI_M_ARBLOST_bm | TWI_M_BUSERR_bm;
+	set_bus_state_TWI(twi, BUS_NOT_IN_USE_GR);
+	TWI_STATS_RECOVERY(twi);
+	TWI_TRACE_EVENT(TWI_EV_RECOVERY, 0);
+	
+	if( !(port->IN & sda_bm) || !(port->IN & scl_bm) ) return TWI_BUS_ERROR;
+	return TWI_STATUS_OK;
+}
+
+static TWI_TIMER_t *deadline_tc = 0;
+static uint16_t deadline_us = TWI_DEADLINE_DEFAULT_US;
+static uint32_t deadline_ticks;
+
+//converts the deadline to ticks of the timer, rounded up
+//65535 us are 262140 ticks at 32 MHz, longer than a turn of the timer, so the ticks are not clamped
+static void update_deadline_ticks(void){
+	deadline_ticks = ( (uint32_t)deadline_us * (F_CPU / TWI_TIMER_DIV / 1000) + 999 ) / 1000;
+}
+
+void set_deadline_timer_TWI(TWI_TIMER_t *tc){
+	deadline_tc = tc;
+	if(tc == 0) return;
+	
+	twi_regs_timer_start(tc);
+	update_deadline_ticks();
+}
+
+void set_deadline_TWI(uint16_t us){
+	deadline_us = us;
+	update_deadline_ticks();
+}
+
+uint16_t get_deadline_TWI(void){
+	return deadline_us;
+}
+
+uint16_t time_TWI(void){
+	return (deadline_tc != 0) ? TWI_TIMER_CNT(deadline_tc) : 0;
+}
+
+//starts measuring a deadline
+static void deadline_start(twi_deadline_t *d){
+	d->start = (deadline_tc != 0) ? TWI_TIMER_CNT(deadline_tc) : 0;
+	d->laps = 0;
+}
+
+//returns the time since deadline_start, in timer ticks or counted us
+//every half turn of the timer is moved from start to laps, so the time can be longer than a turn
+//as long as it is read at least once every TWI_DEADLINE_LAP ticks
+static uint32_t deadline_elapsed(twi_deadline_t *d){
+	uint16_t ticks;
+	
+	if(deadline_tc == 0) return d->start;
+	
+	ticks = TWI_TIMER_CNT(deadline_tc) - d->start;
+	if(ticks >= TWI_DEADLINE_LAP){
+		d->start += TWI_DEADLINE_LAP;
+		ticks -= TWI_DEADLINE_LAP;
+		if(d->laps < 0xFF) d->laps++;
+	}
+	return (uint32_t)d->laps * TWI_DEADLINE_LAP + ticks;
+}
+
+#ifdef TWI_STATS
+//returns the time for the stats, which count up to 65535
+static uint16_t deadline_spent(twi_deadline_t *d){
+	uint32_t elapsed = deadline_elapsed(d);
+	
+	return (elapsed > 0xFFFF) ? 0xFFFF : elapsed;
+}
+#endif
+
+//returns 1 when the deadline has passed
+//without a timer every call waits 1 us and counts it
+static uint8_t deadline_passed(twi_deadline_t *d){
+	if(deadline_tc != 0) return deadline_elapsed(d) > deadline_ticks;
+	
+	if(d->start >= deadline_us) return 1;
+	TWI_DELAY_US(1);
+	d->start++;
+	return 0;
+}
+
+void deadline_start_TWI(twi_deadline_t *d){
+	deadline_start(d);
+}
+
+uint8_t deadline_passed_TWI(twi_deadline_t *d){
+	return deadline_passed(d);
+}
+
+//address of the entry with the speed of a module, no 7 bit address can match it
+#define TWI_BASE_SPEED 0xFF
+
+typedef struct {
+	TWI_t *twi;
+	uint8_t addr;
+	twi_speed_t speed;
+} twi_device_speed_t;
+
+static uint16_t rise_time_ns = TWI_RISE_TIME_NS;
+static twi_device_speed_t device_speeds[TWI_SPEED_DEVICES];
+
+//returns the speed entry of a device or 0
+//with claim a free entry is used for a new device
+static twi_device_speed_t *find_speed(TWI_t *twi, uint8_t addr, uint8_t claim){
+	uint8_t i;
+	
+	for(i = 0; i < TWI_SPEED_DEVICES; i++){
+		if( (device_speeds[i].twi == twi) && (device_speeds[i].addr == addr) ) return &device_speeds[i];
+		
+		if(device_speeds[i].twi == 0){
+			if( !claim ) return 0;
+			
+			device_speeds[i].twi = twi;
+			device_speeds[i].addr = addr;
+			return &device_speeds[i];
+		}
+	}
+	return 0;
+}
+
+void set_rise_time_TWI(uint16_t ns){
+	rise_time_ns = ns;
+}
+
+uint8_t make_speed_TWI(twi_speed_t *speed, uint32_t TWI_speed){
+	int32_t period;
+	int32_t rise;
+	
+	if( (TWI_speed == 0) || (TWI_speed > BAUD_1M) ) return TWI_INVALID_BAUD;
+	
+	//above 400 kHz the pins need the Fast-mode Plus drive strength
+	if( (TWI_speed > BAUD_400K) && !TWI_HAS_FMPLUS ) return TWI_INVALID_BAUD;
+	
+	//clock cycles of one SCL period, rounded up so the bus is never faster than asked
+	period = (F_CPU + TWI_speed - 1) / TWI_speed;
+	rise = ( (F_CPU / 1000UL) * rise_time_ns ) / 1000000UL;
+	
+	//f_scl = F_CPU / (10 + 2 * BAUD + F_CPU * t_rise)
+	period = period - 10 - rise;
+	if( (period < 0) || (period > (2 * 255)) ) return TWI_INVALID_BAUD;
+	
+	speed->baud = (period + 1) / 2;
+	speed->fmplus = (TWI_speed > BAUD_400K) ? 1 : 0;
+	return TWI_STATUS_OK;
+}
+
+uint8_t set_baud(TWI_t *twi, uint32_t TWI_speed){
+	twi_speed_t speed;
+	twi_device_speed_t *base;
+	
+	if(make_speed_TWI(&speed, TWI_speed) != TWI_STATUS_OK) return TWI_INVALID_BAUD;
+	
+	TWI_M_BAUD(twi) = speed.baud;
+	twi_regs_set_fmplus(twi, speed.fmplus);
+	
+	base = find_speed(twi, TWI_BASE_SPEED, 0);
+	if(base != 0) base->speed = speed;
+	return TWI_STATUS_OK;
+}
+
+uint8_t use_speed_TWI(TWI_t *twi, const twi_speed_t *speed){
+	uint8_t state;
+	uint8_t ctrl;
+	
+	if( (TWI_M_BAUD(twi) == speed->baud) && (twi_regs_fmplus(twi) == speed->fmplus) ) return TWI_STATUS_OK;
+	
+	state = TWI_M_STATUS(twi) & TWI_M_BUSSTATE_gm;
+	if( (state == OWNER_OF_BUS_GR) || (state == BUS_IN_USE_GR) ) return BUS_IN_USE;
+	
+	//the baud register is only written while the master is off, the other settings stay as they are
+	ctrl = TWI_M_CTRL(twi);
+	TWI_M_CTRL(twi) = ctrl & ~TWI_M_ENABLE_bm;
+	TWI_M_BAUD(twi) = speed->baud;
+	twi_regs_set_fmplus(twi, speed->fmplus);
+	TWI_M_CTRL(twi) = ctrl;
+	
+	//turning the master off forgets the bus state
+	if(state == BUS_NOT_IN_USE_GR) set_bus_state_TWI(twi, BUS_NOT_IN_USE_GR);
+	return TWI_STATUS_OK;
+}
+
+uint8_t set_device_speed_TWI(TWI_t *twi, uint8_t addr, uint32_t TWI_speed){
+	twi_speed_t speed;
+	twi_device_speed_t *dev;
+	
+	if(make_speed_TWI(&speed, TWI_speed) != TWI_STATUS_OK) return TWI_INVALID_BAUD;
+	
+	//the first device of a module keeps the current speed for all other devices
+	if(find_speed(twi, TWI_BASE_SPEED, 0) == 0){
+		dev = find_speed(twi, TWI_BASE_SPEED, 1);
+		if(dev == 0) return TWI_BUSY;
+		
+		dev->speed.baud = TWI_M_BAUD(twi);
+		dev->speed.fmplus = twi_regs_fmplus(twi);
+	}
+	
+	dev = find_speed(twi, addr, 1);
+	if(dev == 0) return TWI_BUSY;
+	
+	dev->speed = speed;
+	return TWI_STATUS_OK;
+}
+
+//returns the speed a device has to use or 0 when no device of the module has its own speed
+static const twi_speed_t *device_speed(TWI_t *twi, uint8_t addr){
+	twi_device_speed_t *dev;
+	
+	//no device has its own speed
+	if(device_speeds[0].twi == 0) return 0;
+	
+	dev = find_speed(twi, addr, 0);
+	if(dev == 0) dev = find_speed(twi, TWI_BASE_SPEED, 0);
+	if(dev == 0) return 0;
+	return &dev->speed;
+}
+
+uint8_t select_speed_TWI(TWI_t *twi, uint8_t addr){
+	const twi_speed_t *speed = device_speed(twi, addr);
+	twi_deadline_t start;
+	
+	if(speed == 0) return TWI_STATUS_OK;
+	if( (TWI_M_BAUD(twi) == speed->baud) && (twi_regs_fmplus(twi) == speed->fmplus) ) return TWI_STATUS_OK;
+	
+	//the stop of the previous transaction may still be on the bus
+	deadline_start(&start);
+	while( (TWI_M_STATUS(twi) & TWI_M_BUSSTATE_gm) == OWNER_OF_BUS_GR ){
+		if(deadline_passed(&start)) return BUS_IN_USE;
+	}
+	
+	return use_speed_TWI(twi, speed);
+}
+
+uint8_t switch_speed_TWI(TWI_t *twi, uint8_t addr){
+	const twi_speed_t *speed = device_speed(twi, addr);
+	
+	if(speed == 0) return TWI_STATUS_OK;
+	return use_speed_TWI(twi, speed);
+}
+
+//waits until one of the flags in mask is set
+static uint8_t sleep_on = 0;
+static uint8_t sleep_intlvl;
+
+void set_sleep_TWI(uint8_t enable, uint8_t intlvl){
+	sleep_on = enable;
+	sleep_intlvl = intlvl;
+}
+
+uint8_t may_sleep_TWI(void){
+	return sleep_on && (SREG & CPU_I_bm);
+}
+
+void twi_sleep_wake(TWI_t *twi){
+	//the flags stay set until the waiting code handles them, so the interrupt is turned off
+	TWI_M_CTRL(twi) &= ~(TWI_M_RIEN_bm | TWI_M_WIEN_bm);
+}
+
+//sleeps until the master interrupt of the module or another interrupt fires
+//returns right away when a flag in mask is already set
+static void sleep_for_flags(TWI_t *twi, uint8_t mask){
+	cli();
+	if( !(TWI_M_STATUS(twi) & mask) ){
+		twi_regs_enable_interrupts(twi, sleep_intlvl);
+		set_sleep_mode(SLEEP_MODE_IDLE);
+		sleep_enable();
+		sei();	//the instruction after sei is always executed, the interrupt can't fire before the sleep
+		sleep_cpu();
+		sleep_disable();
+	}
+	sei();
+}
+
+static uint8_t wait_for_flags(TWI_t *twi, uint8_t mask){
+	uint8_t sleep = may_sleep_TWI();
+	twi_deadline_t start;
+	
+	//most of the time the flag is already set
+	if(TWI_M_STATUS(twi) & mask){
+		TWI_STATS_SPIN(twi, 0);
+		return TWI_STATUS_OK;
+	}
+	
+	deadline_start(&start);
+	while( !(TWI_M_STATUS(twi) & mask) ){
+		if(sleep){
+			sleep_for_flags(twi, mask);
+			if(TWI_M_STATUS(twi) & mask) break;
+		}
+		
+		if(deadline_passed(&start)){
+			TWI_STATS_SPIN(twi, deadline_spent(&start));
+			return DATA_NOT_SEND;
+		}
+	}
+	TWI_STATS_SPIN(twi, deadline_spent(&start));
+	return TWI_STATUS_OK;
+}
+
+void set_multi_master_TWI(uint8_t enable){
+	multi_master = enable;
+}
+
+uint8_t wait_bus_idle_TWI(TWI_t *twi){
+	twi_deadline_t start;
+	uint8_t state;
+	
+	deadline_start(&start);
+	
+	//with a bus timeout the module goes to idle by itself when the other master is silent
+	while( (state = bus_state(twi)) != BUS_NOT_IN_USE ){
+		if(state == OWNER_OF_BUS) return OWNER_OF_BUS;
+		if(deadline_passed(&start)) return state;
+	}
+	return BUS_NOT_IN_USE;
+}
+
+uint8_t wait_till_send(TWI_t *twi, uint8_t rw){
+	return wait_for_flags(twi, TWI_M_WIF_bm << rw);
+}
+
+uint8_t wait_till_received(TWI_t *twi, uint8_t rw){
+	if(wait_till_send(twi, rw) == TWI_STATUS_OK) return TWI_STATUS_OK;
+	return DATA_NOT_RECEIVED;
+}
+
+uint8_t start_TWI(TWI_t *twi, uint8_t addr, uint8_t rw){
+	uint8_t state;
+	uint8_t status;
+	uint8_t tries = 0;
+	uint16_t backoff = arb_backoff_us;
+	uint16_t i;
+	
+	//the interrupt engine finishes its queue and keeps off the module until the stop
+	TWI_CLAIM(twi);
+	state = multi_master ? wait_bus_idle_TWI(twi) : bus_state(twi);	//read the status register only once
+	
+	//a bus that is still owned belongs to a sequence that isn't stopped yet
+	if(state != BUS_NOT_IN_USE){
+		if(state != OWNER_OF_BUS) TWI_RELEASE(twi);
+		return state;
+	}
+	
+	if( !( (rw == READ) || (rw == WRITE) ) ){
+		TWI_RELEASE(twi);
+		return INVALID_RW;
+	}
+	
+	//a start at the speed of the previous device could be too fast for this one
+	status = select_speed_TWI(twi, addr);
+	if(status != TWI_STATUS_OK){
+		TWI_RELEASE(twi);
+		return status;
+	}
+	TWI_STATS_START(twi);
+	
+	while(1){
+		TWI_M_ADDR(twi) = (addr << 1) | rw;	//send slave address
+		TWI_TRACE_EVENT(TWI_EV_START, (addr << 1) | rw);
+		
+		//a NACK or a lost arbitration on a read address sets WIF instead of RIF
+		if(wait_for_flags(twi, TWI_M_WIF_bm | TWI_M_RIF_bm) == DATA_NOT_SEND){
+			TWI_STATS_ERROR(twi, DATA_NOT_SEND);
+			TWI_TRACE_EVENT(TWI_EV_ERROR, DATA_NOT_SEND);
+			stop_TWI(twi);	//the start is ours, don't leave the bus owned
+			return DATA_NOT_SEND; // wait until sent
+		}
+		
+		status = TWI_M_STATUS(twi);
+		
+		if(status & TWI_M_BUSERR_bm){
+			TWI_M_STATUS(twi) = TWI_M_BUSERR_bm;
+			TWI_STATS_ERROR(twi, TWI_BUS_ERROR);
+			TWI_TRACE_EVENT(TWI_EV_ERROR, TWI_BUS_ERROR);
+			TWI_RELEASE(twi);
+			return TWI_BUS_ERROR;
+		}
+		
+		if( !(status & TWI_M_ARBLOST_bm) ) break;
+		
+		//another master won the bus, wait a bit longer every time and try again
+		TWI_M_STATUS(twi) = TWI_M_ARBLOST_bm;
+		TWI_STATS_ERROR(twi, TWI_ARB_LOST);
+		TWI_TRACE_EVENT(TWI_EV_ERROR, TWI_ARB_LOST);
+		if(tries >= arb_retries){
+			TWI_RELEASE(twi);
+			return TWI_ARB_LOST;
+		}
+		tries++;
+		
+		for(i = 0; i < backoff; i++) TWI_DELAY_US(1);
+		if(backoff < (TWI_BACKOFF_MAX_US / 2)) backoff <<= 1;
+		else backoff = TWI_BACKOFF_MAX_US;
+	}
+	
+	//when RXACK is 0 an ACK has been received
+	if( (status & TWI_M_WIF_bm) && (status & TWI_M_RXACK_bm) ){
+		TWI_STATS_NACK(twi, addr);
+		TWI_TRACE_EVENT(TWI_EV_NACK, 0);
+		stop_TWI(twi);
+		return NACK;
+		} 
+	
+	TWI_TRACE_EVENT(TWI_EV_ACK, 0);
+	return ACK;
+}
+
+uint8_t repeated_start_TWI(TWI_t *twi, uint8_t addr, uint8_t rw){
+	if( (TWI_M_STATUS(twi) & TWI_M_BUSSTATE_gm) != TWI_M_BUSSTATE_OWNER_gc ) return BUS_IN_USE;
+	
+	if( !( (rw == READ) || (rw == WRITE) ) ) return INVALID_RW;
+	
+	//the acknowledge action of a previous read is sent before the repeated start
+	TWI_M_ADDR(twi) = (addr << 1) | rw;
+	TWI_TRACE_EVENT(TWI_EV_RSTART, (addr << 1) | rw);
+	
+	//a NACK on a read address sets WIF instead of RIF
+	if(wait_for_flags(twi, TWI_M_WIF_bm | TWI_M_RIF_bm) == DATA_NOT_SEND){
+		TWI_STATS_ERROR(twi, DATA_NOT_SEND);
+		TWI_TRACE_EVENT(TWI_EV_ERROR, DATA_NOT_SEND);
+		return DATA_NOT_SEND;
+	}
+	
+	//when RXACK is 0 an ACK has been received
+	if( (TWI_M_STATUS(twi) & TWI_M_WIF_bm) && (TWI_M_STATUS(twi) & TWI_M_RXACK_bm) ){
+		TWI_STATS_NACK(twi, addr);
+		TWI_TRACE_EVENT(TWI_EV_NACK, 0);
+		stop_TWI(twi);
+		return NACK;
+	}
+	
+	TWI_TRACE_EVENT(TWI_EV_ACK, 0);
+	return ACK;
+}
+
+void stop_TWI(TWI_t *twi){
+	TWI_M_CMD(twi) = TWI_M_CMD_STOP_gc;
+	TWI_STATS_STOP(twi);
+	TWI_TRACE_EVENT(TWI_EV_STOP, 0);
+	TWI_RELEASE(twi);
+}
+
+uint8_t send_TWI(TWI_t *twi, uint8_t data){
+	TWI_M_DATA(twi) = data;
+	
+	if( wait_till_send(twi, WRITE) == DATA_NOT_SEND){
+		TWI_STATS_ERROR(twi, DATA_NOT_SEND);
+		TWI_TRACE_EVENT(TWI_EV_ERROR, DATA_NOT_SEND);
+		return DATA_NOT_SEND;
+	}
+	
+	if(TWI_M_STATUS(twi) & TWI_M_ARBLOST_bm){
+		TWI_M_STATUS(twi) = TWI_M_ARBLOST_bm;
+		TWI_STATS_ERROR(twi, TWI_ARB_LOST);
+		TWI_TRACE_EVENT(TWI_EV_ERROR, TWI_ARB_LOST);
+		return TWI_ARB_LOST;
+	}
+	
+	if(TWI_M_STATUS(twi) & TWI_M_BUSERR_bm){
+		TWI_M_STATUS(twi) = TWI_M_BUSERR_bm;
+		TWI_STATS_ERROR(twi, TWI_BUS_ERROR);
+		TWI_TRACE_EVENT(TWI_EV_ERROR, TWI_BUS_ERROR);
+		return TWI_BUS_ERROR;
+	}
+	
+	//when RXACK is 0 an ACK has been received
+	if(TWI_M_STATUS(twi) & TWI_M_RXACK_bm){
+		TWI_STATS_ERROR(twi, NACK);
+		TWI_TRACE_EVENT(TWI_EV_NACK, 0);
+		return NACK;
+	}
+	
+	TWI_STATS_BYTE_OUT(twi);
+	TWI_TRACE_EVENT(TWI_EV_BYTE_OUT, data);
+	return ACK;
+}
+
+uint8_t read_TWI(TWI_t *twi, uint8_t *data, uint8_t go_on){
+	uint8_t smart = TWI_M_MODE(twi) & TWI_M_SMEN_bm;
+	
+	if(wait_till_received(twi, READ) == DATA_NOT_RECEIVED){
+		TWI_STATS_ERROR(twi, DATA_NOT_RECEIVED);
+		TWI_TRACE_EVENT(TWI_EV_ERROR, DATA_NOT_RECEIVED);
+		return DATA_NOT_RECEIVED;
+	}
+	
+	TWI_STATS_BYTE_IN(twi);
+	
+	if(go_on == ACK){
+		(*data) = TWI_M_DATA(twi);	//in smart mode this sends the ACK and receives the next byte
+		if( !smart ) TWI_M_CMD(twi) = TWI_M_CMD_RECVTRANS_gc;	// send ack (go on)
+		TWI_TRACE_EVENT(TWI_EV_BYTE_IN, *data);
+		return TWI_STATUS_OK;
+	}
+	
+	//nack (and stop) before DATA is read, so smart mode doesn't send an ACK
+	TWI_M_CMD(twi) = TWI_M_ACKACT_bm | TWI_M_CMD_STOP_gc;
+	(*data) = TWI_M_DATA(twi);
+	if(smart) TWI_M_CMD(twi) = 0;	//ACK again for the next read
+	TWI_TRACE_EVENT(TWI_EV_BYTE_IN, *data);
+	TWI_STATS_STOP(twi);
+	TWI_TRACE_EVENT(TWI_EV_STOP, 0);
+	TWI_RELEASE(twi);
+	return TWI_STATUS_OK;
+}
+
+uint8_t send_8bit_TWI(TWI_t *twi, uint8_t addr, uint8_t data){
+	uint8_t err;
+	
+#ifdef TWI_ASYNC
+	//use the interrupt driven engine when it is enabled for this module, a blocking sequence on it gets OWNER_OF_BUS below
+	twi_async_bus_t *bus = twi_async_bus(twi);
+	if( (bus != 0) && !bus->blocking ){
+		twi_transaction_t t;
+		twi_async_prepare(&t, addr, &data, 1, 0, 0, 0);
+		return twi_async_transfer(bus, &t);
+	}
+#endif
+	
+	err = start_TWI(twi, addr, WRITE);
+	
+	//check for errors, without an ACK the bus is not ours (a NACK has already stopped it)
+	if(err != ACK) return err;
+	
+	err = send_TWI(twi, data);
+	
+	//check for errors, the bus is still ours
+	if(err != ACK){
+		stop_TWI(twi);
+		return err;
+	}
+	
+	stop_TWI(twi);
+	
+	return TWI_STATUS_OK;	
+}
+
+uint8_t write_8bit_register_TWI(TWI_t *twi, uint8_t addr, uint8_t data, uint8_t reg){
+	uint8_t err;
+	
+#ifdef TWI_ASYNC
+	//use the interrupt driven engine when it is enabled for this module, a blocking sequence on it gets OWNER_OF_BUS below
+	twi_async_bus_t *bus = twi_async_bus(twi);
+	if( (bus != 0) && !bus->blocking ){
+		twi_transaction_t t;
+		twi_async_prepare_bulk(&t, addr, &reg, 1, &data, 1, WRITE, 0);
+		return twi_async_transfer(bus, &t);
+	}
+#endif
+	
+	err = start_TWI(twi, addr, WRITE);
+	
+	//check for errors, without an ACK the bus is not ours (a NACK has already stopped it)
+	if(err != ACK) return err;
+	
+	err = send_TWI(twi, reg);
+	
+	//check for errors, the bus is still ours
+	if(err != ACK){
+		stop_TWI(twi);
+		return err;
+	}
+	
+	err = send_TWI(twi, data);
+	
+	//check for errors, the bus is still ours
+	if(err != ACK){
+		stop_TWI(twi);
+		return err;
+	}
+	
+	stop_TWI(twi);
+	
+	return TWI_STATUS_OK;
+}
+
+uint8_t read_8bit_register_TWI(TWI_t *twi, uint8_t addr, uint8_t *data, uint8_t reg){
+	uint8_t err;
+	
+#ifdef TWI_ASYNC
+	//use the interrupt driven engine when it is enabled for this module, a blocking sequence on it gets OWNER_OF_BUS below
+	twi_async_bus_t *bus = twi_async_bus(twi);
+	if( (bus != 0) && !bus->blocking ){
+		twi_transaction_t t;
+		twi_async_prepare(&t, addr, &reg, 1, data, 1, 0);
+		return twi_async_transfer(bus, &t);
+	}
+#endif
+	
+	err = start_TWI(twi, addr, WRITE);
+	
+	//check for errors, without an ACK the bus is not ours (a NACK has already stopped it)
+	if(err != ACK) return err;
+	
+	err = send_TWI(twi, reg);
+	
+	//check for errors, the bus is still ours
+	if(err != ACK){
+		stop_TWI(twi);
+		return err;
+	}
+	
+	err = repeated_start_TWI(twi, addr, READ);
+	
+	//check for errors, a NACK has already stopped the bus
+	if(err == NACK) return NACK;
+	if(err != ACK){
+		stop_TWI(twi);
+		return err;
+	}
+	
+	err = read_TWI(twi, data, NACK);
+	
+	if(err == DATA_NOT_RECEIVED){
+		stop_TWI(twi);
+		return DATA_NOT_RECEIVED;
+	}
+	
+	return TWI_STATUS_OK;
+}
+
+uint8_t write_registers_TWI(TWI_t *twi, uint8_t addr, const uint8_t *data, uint8_t reg, uint8_t len){
+	uint8_t err;
+	uint8_t i;
+	
+#ifdef TWI_ASYNC
+	//use the interrupt driven engine when it is enabled for this module, a blocking sequence on it gets OWNER_OF_BUS below
+	twi_async_bus_t *bus = twi_async_bus(twi);
+	if( (bus != 0) && !bus->blocking ){
+		twi_transaction_t t;
+		twi_async_prepare_bulk(&t, addr, &reg, 1, (uint8_t *)data, len, WRITE, 0);
+		return twi_async_transfer(bus, &t);
+	}
+#endif
+	
+	err = start_TWI(twi, addr, WRITE);
+	
+	//check for errors, without an ACK the bus is not ours (a NACK has already stopped it)
+	if(err != ACK) return err;
+	
+	//the register pointer is only send once
+	err = send_TWI(twi, reg);
+	
+	//check for errors, the bus is still ours
+	if(err != ACK){
+		stop_TWI(twi);
+		return err;
+	}
+	
+	for(i = 0; i < len; i++){
+		err = send_TWI(twi, data[i]);
+		
+		//check for errors, the bus is still ours
+		if(err != ACK){
+			stop_TWI(twi);
+			return err;
+		}
+	}
+	
+	stop_TWI(twi);
+	
+	return TWI_STATUS_OK;
+}
+
+uint8_t read_registers_TWI(TWI_t *twi, uint8_t addr, uint8_t *data, uint8_t reg, uint8_t len){
+	uint8_t err;
+	uint8_t i;
+	
+	if(len == 0) return TWI_STATUS_OK;
+	
+#ifdef TWI_ASYNC
+	//use the interrupt driven engine when it is enabled for this module, a blocking sequence on it gets OWNER_OF_BUS below
+	twi_async_bus_t *bus = twi_async_bus(twi);
+	if( (bus != 0) && !bus->blocking ){
+		twi_transaction_t t;
+		twi_async_prepare(&t, addr, &reg, 1, data, len, 0);
+		return twi_async_transfer(bus, &t);
+	}
+#endif
+	
+	err = start_TWI(twi, addr, WRITE);
+	
+	//check for errors, without an ACK the bus is not ours (a NACK has already stopped it)
+	if(err != ACK) return err;
+	
+	err = send_TWI(twi, reg);
+	
+	//check for errors, the bus is still ours
+	if(err != ACK){
+		stop_TWI(twi);
+		return err;
+	}
+	
+	err = repeated_start_TWI(twi, addr, READ);
+	
+	//check for errors, a NACK has already stopped the bus
+	if(err == NACK) return NACK;
+	if(err != ACK){
+		stop_TWI(twi);
+		return err;
+	}
+	
+	//ACK every byte but the last one
+	for(i = 0; i < len; i++){
+		err = read_TWI(twi, &data[i], (i < (len - 1)) ? ACK : NACK);
+		
+		if(err == DATA_NOT_RECEIVED){
+			stop_TWI(twi);
+			return DATA_NOT_RECEIVED;
+		}
+	}
+	
+	return TWI_STATUS_OK;
+}
+
+uint8_t transfer_TWI(TWI_t *twi, const twi_segment_t *seg, uint8_t count){
+	uint8_t smart = TWI_M_MODE(twi) & TWI_M_SMEN_bm;
+	uint8_t err;
+	uint8_t i;
+	uint8_t j;
+	
+	for(i = 0; i < count; i++){
+		//only the first segment needs a start, the others use a repeated start
+		if(i == 0) err = start_TWI(twi, seg[i].addr, seg[i].rw);
+		else err = repeated_start_TWI(twi, seg[i].addr, seg[i].rw);
+		
+		//check for errors, a NACK has already stopped the bus
+		if(err == NACK) return NACK;
+		if(err == TWI_ARB_LOST) return TWI_ARB_LOST;
+		if(err == TWI_BUS_ERROR) return TWI_BUS_ERROR;
+		if(err != ACK){
+			if(i != 0) stop_TWI(twi);
+			return err;
+		}
+		
+		if(seg[i].rw == WRITE){
+			for(j = 0; j < seg[i].len; j++){
+				err = send_TWI(twi, seg[i].data[j]);
+				
+				//check for errors
+				if(err != ACK){
+					stop_TWI(twi);
+					return err;
+				}
+			}
+			continue;
+		}
+		
+		for(j = 0; j < seg[i].len; j++){
+			//ACK every byte but the last one, the last byte of the last segment also stops
+			if(j < (seg[i].len - 1)) err = read_TWI(twi, &seg[i].data[j], ACK);
+			else if(i == (count - 1)) err = read_TWI(twi, &seg[i].data[j], NACK);
+			else{
+				err = wait_till_received(twi, READ);
+				if(err == TWI_STATUS_OK){
+					//NACK is sent with the next repeated start, in smart mode reading DATA sends it
+					TWI_M_CMD(twi) = TWI_M_ACKACT_bm;
+					seg[i].data[j] = TWI_M_DATA(twi);
+					if(smart) TWI_M_CMD(twi) = 0;	//ACK again for the next read
+				}
+			}
+			
+			if(err == DATA_NOT_RECEIVED){
+				stop_TWI(twi);
+				return DATA_NOT_RECEIVED;
+			}
+		}
+	}
+	
+	//a read as last segment has already stopped the bus
+	if( (count != 0) && (seg[count - 1].rw == WRITE) ) stop_TWI(twi);
+	
+	return TWI_STATUS_OK;
+}
+
+uint8_t quick_command_TWI(TWI_t *twi, uint8_t addr, uint8_t rw){
+	uint8_t state;
+	uint8_t status;
+	uint8_t qcen;
+	
+	TWI_CLAIM(twi);
+	state = bus_state(twi);
+	
+	if(state != BUS_NOT_IN_USE){
+		if(state != OWNER_OF_BUS) TWI_RELEASE(twi);
+		return state;
+	}
+	
+	if( !( (rw == READ) || (rw == WRITE) ) ){
+		TWI_RELEASE(twi);
+		return INVALID_RW;
+	}
+	
+	//a start at the speed of the previous device could be too fast for this one
+	status = select_speed_TWI(twi, addr);
+	if(status != TWI_STATUS_OK){
+		TWI_RELEASE(twi);
+		return status;
+	}
+	
+	//quick command ends a read right after its address, it is only on for this transaction
+	qcen = TWI_M_MODE(twi) & TWI_M_QCEN_bm;
+	TWI_M_MODE(twi) |= TWI_M_QCEN_bm;
+	TWI_M_ADDR(twi) = (addr << 1) | rw;
+	
+	if(wait_for_flags(twi, TWI_M_WIF_bm | TWI_M_RIF_bm) == DATA_NOT_SEND) status = 0;
+	else status = TWI_M_STATUS(twi);
+	
+	if( !qcen ) TWI_M_MODE(twi) &= ~TWI_M_QCEN_bm;
+	
+	if( !(status & (TWI_M_WIF_bm | TWI_M_RIF_bm)) ){
+		TWI_STATS_ERROR(twi, DATA_NOT_SEND);
+		TWI_TRACE_EVENT(TWI_EV_ERROR, DATA_NOT_SEND);
+		stop_TWI(twi);	//the start is ours, don't leave the bus owned
+		return DATA_NOT_SEND;
+	}
+	
+	//the bus isn't ours after an error, no stop is send
+	if(status & TWI_M_BUSERR_bm){
+		TWI_M_STATUS(twi) = TWI_M_BUSERR_bm;
+		TWI_STATS_ERROR(twi, TWI_BUS_ERROR);
+		TWI_TRACE_EVENT(TWI_EV_ERROR, TWI_BUS_ERROR);
+		TWI_RELEASE(twi);
+		return TWI_BUS_ERROR;
+	}
+	
+	if(status & TWI_M_ARBLOST_bm){
+		TWI_M_STATUS(twi) = TWI_M_ARBLOST_bm;
+		TWI_STATS_ERROR(twi, TWI_ARB_LOST);
+		TWI_TRACE_EVENT(TWI_EV_ERROR, TWI_ARB_LOST);
+		TWI_RELEASE(twi);
+		return TWI_ARB_LOST;
+	}
+	
+	stop_TWI(twi);
+	
+	//when RXACK is 0 an ACK has been received
+	if(status & TWI_M_RXACK_bm){
+		TWI_STATS_NACK(twi, addr);
+		TWI_TRACE_EVENT(TWI_EV_NACK, 0);
+		return NACK;
+	}
+	
+	TWI_TRACE_EVENT(TWI_EV_ACK, 0);
+	return ACK;
+}
+
+uint8_t probe_TWI(TWI_t *twi, uint8_t addr){
+	return quick_command_TWI(twi, addr, WRITE);
+}
@@ -0,0 +1,362 @@
+/*
+ * File TWI.h
+ * Author: Tycho Jbsis
+ * Date: 13-02-2021
+ */ 
+
+/*
+*	MIT License
+*
+*	Copyright (c) 2021 TychoJ
+*
+*	Permission is hereby granted, free of charge, to any person obtaining a copy
+*	of this software and associated documentation files (the "Software"), to deal
+*	in the Software without restriction, including without limitation the rights
+*	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*	copies of the Software, and to permit persons to whom the Software is
+*	furnished to do so, subject to the following conditions:
+*
+*	The above copyright notice and this permission notice shall be included in all
+*	copies or substantial portions of the Software.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*	SOFTWARE.
+*/
+
+
+#include <avr/io.h>
+#include "twi_regs.h"
+
+#ifndef F_CPU
+#define F_CPU 2000000UL
+#endif
+
+#ifndef TWI_H_
+#define TWI_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//delay used while polling the TWI flags
+//a host build can define it to advance a simulated clock instead
+#ifndef TWI_DELAY_US
+#define TWI_DELAY_US(us)	_delay_us(us)
+#endif
+
+#define BAUD_100K        100000UL
+#define BAUD_400K        400000UL
+#define BAUD_1M          1000000UL	//Fast-mode Plus, the devices on the bus have to support it
+
+//rise time of SCL in ns, it depends on the pull-up resistors and the capacitance of the bus
+//the I2C maximum is 1000 ns at 100 kHz, 300 ns at 400 kHz and 120 ns at 1 MHz
+#ifndef TWI_RISE_TIME_NS
+#define TWI_RISE_TIME_NS 100
+#endif
+
+#define TIMEOUT_DIS   TWI_M_TIMEOUT_DISABLED_gc
+#define TIMEOUT_50US  TWI_M_TIMEOUT_50US_gc
+#define TIMEOUT_100US TWI_M_TIMEOUT_100US_gc
+#define TIMEOUT_200US TWI_M_TIMEOUT_200US_gc
+
+//options that can be added to the timeout of enable_TWI
+//smart mode: reading DATA sends the ACK and receives the next byte by itself
+//quick command: the transaction ends right after the address has been acknowledged,
+//quick_command_TWI turns it on for its own transaction only, so it is ignored by enable_TWI
+#define TWI_SMART_MODE    TWI_M_SMEN_bm
+#define TWI_QUICK_COMMAND TWI_M_QCEN_bm
+
+#define	UNKNOWN_BUS_STATE	0
+#define	BUS_NOT_IN_USE		1
+#define	OWNER_OF_BUS		2
+#define	BUS_IN_USE			3
+
+#define	UNKNOWN_BUS_STATE_GR	TWI_M_BUSSTATE_UNKNOWN_gc
+#define	BUS_NOT_IN_USE_GR		TWI_M_BUSSTATE_IDLE_gc
+#define	OWNER_OF_BUS_GR			TWI_M_BUSSTATE_OWNER_gc
+#define	BUS_IN_USE_GR			TWI_M_BUSSTATE_BUSY_gc
+
+#define INVALID_RW	4
+
+#define WRITE 0 
+#define READ  1
+
+#define NACK 0
+#define ACK	 1
+#define DATA_NOT_SEND 10
+#define DATA_NOT_RECEIVED 7
+#define TWI_STATUS_OK 5
+#define TWI_BUSY 6
+#define TWI_ARB_LOST 8
+#define TWI_BUS_ERROR 9
+#define TWI_INVALID_BAUD 11
+#define TWI_OUT_OF_RANGE 12
+#define TWI_PEC_ERROR 13
+
+//longest wait in us between two tries after a lost arbitration
+#ifndef TWI_BACKOFF_MAX_US
+#define TWI_BACKOFF_MAX_US 1000
+#endif
+
+//default time in us after which waiting for a TWI flag fails
+#ifndef TWI_DEADLINE_DEFAULT_US
+#define TWI_DEADLINE_DEFAULT_US 1000
+#endif
+
+//ticks of the deadline timer counted as one lap, a deadline must be checked at least this often
+//8.2 ms at 32 MHz (clk/8) and 3.3 ms at 20 MHz (clk/2 on the ATtiny)
+#define TWI_DEADLINE_LAP 0x8000
+
+//a deadline that is being measured, see deadline_start_TWI
+typedef struct {
+	uint16_t start;		//timer count at the start of the lap or counted us
+	uint8_t laps;		//laps of TWI_DEADLINE_LAP ticks that have passed
+} twi_deadline_t;
+
+//one part of a transfer_TWI sequence
+//addr is the address of the TWI device
+//rw is WRITE or READ
+//data is the buffer to send from or to store the read data in
+//len is the number of bytes, a read segment needs at least 1 byte
+typedef struct {
+	uint8_t addr;
+	uint8_t rw;
+	uint8_t *data;
+	uint8_t len;
+} twi_segment_t;
+
+//speed of a TWI module, made with make_speed_TWI
+//baud is the value of the baud register, fmplus is 1 for the Fast-mode Plus drive strength
+typedef struct {
+	uint8_t baud;
+	uint8_t fmplus;
+} twi_speed_t;
+
+//number of devices that can have their own speed, see set_device_speed_TWI
+#ifndef TWI_SPEED_DEVICES
+#define TWI_SPEED_DEVICES 4
+#endif
+
+//inline function to calculate the baud value
+//f_scl = F_SYS / (10 + 2 * BAUD + F_SYS * t_rise), rounded so SCL is never faster than F_TWI
+//only for constants, use make_speed_TWI to check the range
+#define TWI_BAUD_RISE(F_SYS, F_TWI, T_RISE_NS)   (((((F_SYS) + (F_TWI) - 1) / (F_TWI)) - 10 - ((F_SYS) / 1000UL) * (T_RISE_NS) / 1000000UL + 1) / 2)
+#define TWI_BAUD(F_SYS, F_TWI)   TWI_BAUD_RISE(F_SYS, F_TWI, TWI_RISE_TIME_NS)
+
+//sets the rise time of SCL in ns used by the following baud calculations, the default is TWI_RISE_TIME_NS
+void set_rise_time_TWI(uint16_t ns);
+
+//calculates the baud value and Fast-mode Plus setting for TWI_speed (at most BAUD_1M)
+//above BAUD_400K the device needs Fast-mode Plus (TWI_HAS_FMPLUS in twi_regs.h)
+//returns 5 (TWI_STATUS_OK) or 11 (TWI_INVALID_BAUD) when the baud value doesn't fit in 0 - 255 at F_CPU
+uint8_t make_speed_TWI(twi_speed_t *speed, uint32_t TWI_speed);
+
+//set the baud rate of a TWI module
+//returns 5 (TWI_STATUS_OK) or 11 (TWI_INVALID_BAUD), the baud rate is not changed then
+uint8_t set_baud(TWI_t *twi, uint32_t TWI_speed);
+
+//switches an enabled TWI module to another speed without a disable_TWI and enable_TWI
+//nothing is written when the module already runs at this speed
+//returns 5 (TWI_STATUS_OK) or 3 (BUS_IN_USE) while a transaction is running
+uint8_t use_speed_TWI(TWI_t *twi, const twi_speed_t *speed);
+
+//gives a device its own speed, used for every following transaction with addr on this module
+//other devices keep the speed set with enable_TWI or set_baud
+//the devices of one transfer_TWI or held twi_async chain all run at the speed of the first device
+//returns 5 (TWI_STATUS_OK), 11 (TWI_INVALID_BAUD) or 6 (TWI_BUSY) when all TWI_SPEED_DEVICES are used
+uint8_t set_device_speed_TWI(TWI_t *twi, uint8_t addr, uint32_t TWI_speed);
+
+//switches to the speed of a device, done by start_TWI and the interrupt engine
+//waits (at most the deadline) for the stop of the previous transaction when the speed changes
+//returns 5 (TWI_STATUS_OK) or 3 (BUS_IN_USE) when the speed could not be changed
+uint8_t select_speed_TWI(TWI_t *twi, uint8_t addr);
+
+//switches to the speed of a device without waiting, used by the interrupt engine
+//returns 3 (BUS_IN_USE) while the stop of the previous transaction is still on the bus, try again later
+uint8_t switch_speed_TWI(TWI_t *twi, uint8_t addr);
+
+//enables a TWI module
+//TWI_speed is used to calculate the baud rate
+//timeout: if you are the only master you should use TIMEOUT_DIS
+//TWI_SMART_MODE can be added to timeout, example: TIMEOUT_DIS | TWI_SMART_MODE
+//returns 5 (TWI_STATUS_OK) or 11 (TWI_INVALID_BAUD), the module is not enabled then
+uint8_t enable_TWI(TWI_t *twi, uint32_t TWI_speed, uint8_t timeout);
+
+//disables a TWI module
+void disable_TWI(TWI_t *twi);
+
+//time in us after which it's assumed the TWI bus is free
+
+// disabled(normally used for i2c), 50us, 100us, 200us  
+void set_timeout(TWI_t *twi, uint8_t time_out);
+
+//selects if ACK or NACK will be used
+void set_acknowledge(TWI_t *twi, uint8_t ack);
+
+//returns in what state the bus is
+//UNKNOWN_BUS_STATE, BUS_NOT_IN_USE, OWNER_OF_BUS or BUS_IN_USE
+uint8_t bus_state(TWI_t *twi);  
+
+//waits until the bus is free, at most the deadline set with set_deadline_TWI
+//use a bus timeout (TIMEOUT_50US, TIMEOUT_100US or TIMEOUT_200US) so the module can detect a free bus
+//returns BUS_NOT_IN_USE or OWNER_OF_BUS, otherwise the state at the deadline
+uint8_t wait_bus_idle_TWI(TWI_t *twi);
+
+//with more masters on the bus start_TWI waits until the bus is free instead of returning BUS_IN_USE
+//enable 1 on 0 off
+void set_multi_master_TWI(uint8_t enable);
+
+//function used for setting the bus state
+void set_bus_state_TWI(TWI_t *twi, uint8_t state);
+
+//number of times start_TWI tries again after losing the arbitration
+//backoff_us is the wait before the first retry, it doubles every retry up to TWI_BACKOFF_MAX_US
+//returns TWI_ARB_LOST when all retries are used
+void set_retries_TWI(uint8_t retries, uint16_t backoff_us);
+
+//frees a bus where a slave holds SDA low
+//clocks SCL up to 9 times, sends a stop and sets the bus state back to idle
+//port is the port with the TWI pins, sda_bm and scl_bm are their pin masks (PIN0_bm and PIN1_bm of the port of the module)
+//returns 5 when SDA and SCL are released, 9 if the bus is still stuck
+uint8_t recover_bus_TWI(TWI_t *twi, PORT_t *port, uint8_t sda_bm, uint8_t scl_bm);
+
+//uses a free running 16 bit timer (clk/8) to measure the deadlines instead of counted delays
+//the timer is configured by this function and can't be used for anything else
+//pass 0 to go back to counted delays
+void set_deadline_timer_TWI(TWI_TIMER_t *tc);
+
+//time in us after which waiting for a TWI flag fails
+//used by every following transaction, the default is TWI_DEADLINE_DEFAULT_US
+//every deadline up to 65535 us works with a timer, the timer laps are counted while the deadline is checked
+void set_deadline_TWI(uint16_t us);
+
+//returns the deadline in us set with set_deadline_TWI
+uint16_t get_deadline_TWI(void);
+
+//puts the CPU in IDLE sleep while the blocking functions wait for the TWI module, 1 on 0 off
+//the master interrupt wakes it at every byte, define its vector with TWI_SLEEP_ISR
+//a module registered with twi_async_init has the vector of TWI_ASYNC_ISR instead, which only wakes the blocking functions
+//when twi.c is compiled with TWI_ASYNC
+//intlvl is one of the TWI_INTLVL_xx values, the CPU only sleeps while interrupts are enabled with sei()
+//the sleep mode is set to IDLE, set your own sleep mode again before using it
+//the deadline is checked after every wake up, a stuck bus only ends the wait when another interrupt (a timer tick) wakes the CPU
+void set_sleep_TWI(uint8_t enable, uint8_t intlvl);
+
+//returns 1 when the blocking functions sleep while waiting
+uint8_t may_sleep_TWI(void);
+
+//called from the master interrupt of a module when the blocking functions sleep
+void twi_sleep_wake(TWI_t *twi);
+
+//defines the master interrupt that wakes the CPU for a module
+//example: TWI_SLEEP_ISR(TWIE)
+#define TWI_SLEEP_ISR(module)	ISR(module##_TWIM_vect){ twi_sleep_wake(&(module)); }
+
+//starts measuring the deadline for code that can't wait in a loop, pass d to deadline_passed_TWI
+void deadline_start_TWI(twi_deadline_t *d);
+
+//returns 1 when the deadline set with set_deadline_TWI has passed since deadline_start_TWI
+//with a deadline timer it has to be called at least every TWI_DEADLINE_LAP ticks, a longer gap stretches the deadline
+//without a deadline timer every call counts as 1 us and waits that long
+uint8_t deadline_passed_TWI(twi_deadline_t *d);
+
+//returns the counter of the deadline timer (clk/8), 0 when there is no deadline timer
+uint16_t time_TWI(void);
+
+uint8_t wait_till_send(TWI_t *twi, uint8_t rw);
+
+uint8_t wait_till_received(TWI_t *twi, uint8_t rw);
+
+//issues an start condition and send an address
+//returns 1 if an acknowledge is received
+//returns 0 if a not acknowledge is received, the bus is stopped
+//returns 2 if this module already owns the bus, 3 if the bus is not free
+//returns 3 too when the bus was taken before the speed of the device was set, no start is made then
+//returns 10 (DATA_NOT_SEND) when the address is not send within the deadline, the bus is stopped
+//returns 8 (TWI_ARB_LOST) or 9 (TWI_BUS_ERROR)
+//every value but 1 means the transaction did not start
+uint8_t start_TWI(TWI_t *twi, uint8_t addr, uint8_t rw);
+
+//issues a repeated start condition and sends an address, the bus must be owned
+//returns 1 if an acknowledge is received
+//returns 0 if a not acknowledge is received, the bus is stopped
+//returns 3 if this module is not the owner of the bus
+uint8_t repeated_start_TWI(TWI_t *twi, uint8_t addr, uint8_t rw);
+
+//issues a stop condition
+void stop_TWI(TWI_t *twi);
+
+//internal function used for sending data
+uint8_t send_TWI(TWI_t *twi, uint8_t data);
+
+//internal function used to read data
+//twi for what twi module
+//data pointer to store read data
+//go_on to continue or stop reading data
+//returns 7 when data is not received
+//returns 5 if data is received and no errors have occurred
+//go_on 1 continue 0 stop reading
+uint8_t read_TWI(TWI_t *twi, uint8_t *data, uint8_t go_on);
+
+//send 8bits to the address 
+uint8_t send_8bit_TWI(TWI_t *twi, uint8_t addr, uint8_t data);
+
+//twi is the TWI port
+//addr is the address of the TWI device were you want to write to a register
+//data is the data that you want to write in the register
+//reg is the register to which you want to write the data
+uint8_t write_8bit_register_TWI(TWI_t *twi, uint8_t addr, uint8_t data, uint8_t reg);
+
+//twi is the TWI port
+//addr is the address of the TWI device were you want to read a register
+//data is the variable where you want to store the data 
+//reg is the register you want to read data from
+uint8_t read_8bit_register_TWI(TWI_t *twi, uint8_t addr, uint8_t *data, uint8_t reg);
+
+//twi is the TWI port
+//addr is the address of the TWI device were you want to write to the registers
+//data is the buffer with the data that you want to write in the registers
+//reg is the first register, the device increments the register pointer after every byte
+//len is the number of registers to write
+//the bus is stopped on every error after the start
+uint8_t write_registers_TWI(TWI_t *twi, uint8_t addr, const uint8_t *data, uint8_t reg, uint8_t len);
+
+//twi is the TWI port
+//addr is the address of the TWI device were you want to read the registers
+//data is the buffer where you want to store the data, it must hold len bytes
+//reg is the first register, the device increments the register pointer after every byte
+//len is the number of registers to read
+//the bus is stopped on every error after the start
+uint8_t read_registers_TWI(TWI_t *twi, uint8_t addr, uint8_t *data, uint8_t reg, uint8_t len);
+
+//twi is the TWI port
+//seg is a list of segments that are executed in order
+//count is the number of segments
+//every segment starts with a (repeated) start, a stop is only issued after the last one
+uint8_t transfer_TWI(TWI_t *twi, const twi_segment_t *seg, uint8_t count);
+
+//sends only an address and stops, the R/W bit is the data
+//quick command is turned on for this transaction and turned off again, a READ receives no byte
+//returns 1 if an acknowledge is received, 0 if not, the bus is stopped
+//returns 2 if this module already owns the bus, 3 if the bus is not free or the speed of the device can't be set, 4 (INVALID_RW) for a wrong rw
+//an unknown bus state (UNKNOWN_BUS_STATE) also returns 0, use a bus timeout or set_bus_state_TWI
+//returns 10 (DATA_NOT_SEND) when the address is not send within the deadline, the bus is stopped
+//returns 8 (TWI_ARB_LOST) or 9 (TWI_BUS_ERROR), the bus belongs to no one then and no stop is send
+uint8_t quick_command_TWI(TWI_t *twi, uint8_t addr, uint8_t rw);
+
+//a quick command write to addr
+//returns 1 if a device answers to addr, 0 if not
+//every other value is an error of quick_command_TWI, the address has not been probed then
+uint8_t probe_TWI(TWI_t *twi, uint8_t addr);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TWI_H_ */
\ No newline at end of file
@@ -0,0 +1,146 @@
+/*
+ * File twi.hpp
+ * Author: Tycho Jöbsis
+ * Date: 16-10-2026
+ */ 
+
+/*
+*	MIT License
+*
+*	Copyright (c) 2021 TychoJ
+*
+*	Permission is hereby granted, free of charge, to any person obtaining a copy
+*	of this software and associated documentation files (the "Software"), to deal
+*	in the Software without restriction, including without limitation the rights
+*	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*	copies of the Software, and to permit persons to whom the Software is
+*	furnished to do so, subject to the following conditions:
+*
+*	The above copyright notice and this permission notice shall be included in all
+*	copies or substantial portions of the Software.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*	SOFTWARE.
+*/
+
+
+#include <avr/io.h>
+#include "twi.h"
+
+#ifndef TWI_HPP_
+#define TWI_HPP_
+
+/*
+ * Header only C++ front-end for one TWI module that is known at compile time.
+ * The speed is range checked while compiling (Fsys is F_CPU of twi.c), that is all the template adds:
+ * every function is a call of the C function of twi.h, there are no inline register paths,
+ * so the deadline, smart mode, retries, device speeds and the interrupt engine work the same.
+ * The C functions of twi.h can still be used, Twi<...>::module() returns the TWI_t pointer for them.
+ *
+ * example:
+ *	typedef Twi<TwiModule::E, 400000> Bus;
+ *	Bus::enable();
+ *	uint8_t accel[6];
+ *	Bus::read_registers(0x1D, 0x28, accel);
+ */
+
+//address of the TWI modules
+namespace TwiModule {
+#ifdef TWIE
+	const uint16_t C = 0x0480;
+	const uint16_t D = 0x0490;
+	const uint16_t E = 0x04A0;
+	const uint16_t F = 0x04B0;
+#else
+	const uint16_t Twi0 = 0x0810;
+#endif
+}
+
+enum class Timeout : uint8_t {
+	Disabled = TIMEOUT_DIS,
+	Us50 = TIMEOUT_50US,
+	Us100 = TIMEOUT_100US,
+	Us200 = TIMEOUT_200US
+};
+
+template<uint16_t Module, uint32_t Speed, Timeout Time = Timeout::Disabled, uint32_t Fsys = F_CPU, uint16_t RiseNs = TWI_RISE_TIME_NS>
+class Twi {
+	static_assert(Speed > 0, "TWI speed must be larger than 0");
+	static_assert(Speed <= BAUD_1M, "TWI speed is above Fast-mode Plus");
+	static_assert(TWI_HAS_FMPLUS || (Speed <= BAUD_400K), "this part has no Fast-mode Plus");
+	
+	//the baud value enable_TWI will calculate, same rounding as make_speed_TWI, only used for the range check
+	static constexpr int32_t checked_baud = ((int32_t)((Fsys + Speed - 1) / Speed) - 10 - (int32_t)((Fsys / 1000UL) * RiseNs / 1000000UL) + 1) / 2;
+	
+	static_assert(checked_baud >= 0, "TWI speed is too high for this clock");
+	static_assert(checked_baud <= 255, "TWI speed is too low for this clock");
+	
+public:
+	//returns the module for the C functions of twi.h
+	static TWI_t *module(){
+		return reinterpret_cast<TWI_t *>(Module);
+	}
+	
+	//see enable_TWI, it calculates the baud value at run time, the same one as the check when RiseNs is the rise time of set_rise_time_TWI
+	static uint8_t enable(){
+		return enable_TWI(module(), Speed, (uint8_t)Time);
+	}
+	
+	static void disable(){
+		disable_TWI(module());
+	}
+	
+	//see start_TWI
+	static uint8_t start(uint8_t addr, uint8_t rw){
+		return start_TWI(module(), addr, rw);
+	}
+	
+	//see repeated_start_TWI
+	static uint8_t repeated_start(uint8_t addr, uint8_t rw){
+		return repeated_start_TWI(module(), addr, rw);
+	}
+	
+	static void stop(){
+		stop_TWI(module());
+	}
+	
+	//see send_TWI
+	static uint8_t write(uint8_t data){
+		return send_TWI(module(), data);
+	}
+	
+	//last is true for the last byte, it is NACKed and the bus is stopped, see read_TWI
+	static uint8_t read(uint8_t *data, bool last){
+		return read_TWI(module(), data, last ? NACK : ACK);
+	}
+	
+	//writes N registers starting at reg, see write_registers_TWI
+	template<uint8_t N>
+	static uint8_t write_registers(uint8_t addr, uint8_t reg, const uint8_t (&data)[N]){
+		static_assert(N > 0, "write at least one register");
+		return write_registers_TWI(module(), addr, data, reg, N);
+	}
+	
+	//reads N registers starting at reg, see read_registers_TWI
+	template<uint8_t N>
+	static uint8_t read_registers(uint8_t addr, uint8_t reg, uint8_t (&data)[N]){
+		static_assert(N > 0, "read at least one register");
+		return read_registers_TWI(module(), addr, data, reg, N);
+	}
+	
+	static uint8_t write_register(uint8_t addr, uint8_t reg, uint8_t data){
+		return write_8bit_register_TWI(module(), addr, data, reg);
+	}
+	
+	static uint8_t read_register(uint8_t addr, uint8_t reg, uint8_t *data){
+		return read_8bit_register_TWI(module(), addr, data, reg);
+	}
+};
+
+
+#endif /* TWI_HPP_ */
@@ -0,0 +1,441 @@
+/*
+ * File twi_async.c
+ * Author: Tycho Jöbsis
+ * Date: 16-10-2026
+ */ 
+
+/*
+*	MIT License
+*
+*	Copyright (c) 2021 TychoJ
+*
+*	Permission is hereby granted, free of charge, to any person obtaining a copy
+*	of this software and associated documentation files (the "Software"), to deal
+*	in the Software without restriction, including without limitation the rights
+*	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*	copies of the Software, and to permit persons to whom the Software is
+*	furnished to do so, subject to the following conditions:
+*
+*	The above copyright notice and this permission notice shall be included in all
+*	copies or substantial portions of the Software.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*	SOFTWARE.
+*/
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+#include <util/atomic.h>
+#include "twi.h"
+#include "twi_async.h"
+#include "twi_stats.h"
+#include "twi_trace.h"
+
+#define TWI_ASYNC_MAX_BUSES 4
+
+static twi_async_bus_t *buses[TWI_ASYNC_MAX_BUSES];
+
+#ifdef TWI_ASYNC_BUSES
+#ifdef TWIC
+twi_async_bus_t twic_bus;
+TWI_ASYNC_ISR(TWIC, twic_bus)
+#endif
+#ifdef TWID
+twi_async_bus_t twid_bus;
+TWI_ASYNC_ISR(TWID, twid_bus)
+#endif
+#ifdef TWIE
+twi_async_bus_t twie_bus;
+TWI_ASYNC_ISR(TWIE, twie_bus)
+#endif
+#ifdef TWIF
+twi_async_bus_t twif_bus;
+TWI_ASYNC_ISR(TWIF, twif_bus)
+#endif
+#ifdef TWI0
+twi_async_bus_t twi0_bus;
+TWI_ASYNC_ISR(TWI0, twi0_bus)
+#endif
+#endif
+
+static void start_transaction(twi_async_bus_t *bus, twi_transaction_t *t){
+	//the deadline of a polled bus includes the wait for a new speed
+	if( bus->polled && (bus->phase != TWI_PHASE_SPEED) ) deadline_start_TWI(&bus->since);
+	
+	//a held bus keeps its speed, there is no stop to change it
+	//the interrupt doesn't wait for the stop, a new speed is set by resume_transaction when the bus is free
+	if( (bus->held == 0) && (switch_speed_TWI(bus->twi, t->addr) == BUS_IN_USE) ){
+		bus->phase = TWI_PHASE_SPEED;
+		return;
+	}
+	
+	bus->idx = 0;
+	bus->steps++;
+	if( !bus->polled ) TWI_M_CTRL(bus->twi) |= TWI_M_RIEN_bm | TWI_M_WIEN_bm;	//turned off while the queue was empty
+	TWI_STATS_START(bus->twi);
+	
+	if( (t->cmd_len == 0) && (t->write_len == 0) && (t->read_len != 0) ){
+		bus->phase = TWI_PHASE_READ;
+		TWI_M_ADDR(bus->twi) = (t->addr << 1) | READ;
+		TWI_TRACE_EVENT(TWI_EV_START, (t->addr << 1) | READ);
+		return;
+	}
+	
+	bus->phase = TWI_PHASE_CMD;
+	TWI_M_ADDR(bus->twi) = (t->addr << 1) | WRITE;
+	TWI_TRACE_EVENT(TWI_EV_START, (t->addr << 1) | WRITE);
+}
+
+//removes the finished transaction from the queue and starts the next one
+static void finish_transaction(twi_async_bus_t *bus, uint8_t status){
+	twi_transaction_t *t = bus->head;
+	
+	TWI_STATS_STOP(bus->twi);
+	if(status == NACK) TWI_STATS_NACK(bus->twi, t->addr);
+	else TWI_STATS_ERROR(bus->twi, status);
+	
+	if(status == NACK) TWI_TRACE_EVENT(TWI_EV_NACK, 0);
+	else if(status != TWI_STATUS_OK) TWI_TRACE_EVENT(TWI_EV_ERROR, status);
+	TWI_TRACE_EVENT(TWI_EV_STOP, 0);
+	
+	bus->head = t->next;
+	bus->phase = TWI_PHASE_CMD;
+	if(bus->head != 0) start_transaction(bus, bus->head);
+	else bus->tail = 0;
+	
+	t->next = 0;
+	t->status = status;
+	if(t->callback) t->callback(t);
+}
+
+//starts the transaction at the head of the queue when it waits for a new speed
+static void resume_transaction(twi_async_bus_t *bus){
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE){
+		if( (bus->head != 0) && (bus->phase == TWI_PHASE_SPEED) && !bus->blocking ) start_transaction(bus, bus->head);
+	}
+}
+
+//gives up the running transaction when the bus made no progress, the next one is started
+static void abort_transaction(twi_async_bus_t *bus){
+	//a transaction waiting for its speed has nothing on the bus yet
+	if(bus->phase != TWI_PHASE_SPEED) TWI_M_CMD(bus->twi) = TWI_M_CMD_STOP_gc;
+	bus->held = 0;
+	finish_transaction(bus, (bus->phase == TWI_PHASE_READ) ? DATA_NOT_RECEIVED : DATA_NOT_SEND);
+}
+
+//gives the command that ends a successful transaction, the bus is kept for the next queued one when allowed
+//ackact is TWI_M_ACKACT_bm after a read, it is send with the stop or repeated start
+static void end_transaction(twi_async_bus_t *bus, uint8_t ackact){
+	if( (bus->head->next != 0) && (bus->held < bus->hold) ){
+		bus->held++;
+		TWI_M_CMD(bus->twi) = ackact;
+	}
+	else{
+		bus->held = 0;
+		TWI_M_CMD(bus->twi) = ackact | TWI_M_CMD_STOP_gc;
+	}
+}
+
+static void complete_transaction(twi_async_bus_t *bus, uint8_t ackact){
+	end_transaction(bus, ackact);
+	finish_transaction(bus, TWI_STATUS_OK);
+}
+
+void twi_async_init(twi_async_bus_t *bus, TWI_t *twi, uint8_t intlvl){
+	uint8_t i;
+	
+	bus->twi = twi;
+	bus->head = 0;
+	bus->tail = 0;
+	bus->idx = 0;
+	bus->phase = TWI_PHASE_CMD;
+	bus->hold = 0;
+	bus->held = 0;
+	bus->polled = (intlvl == TWI_ASYNC_POLLED);
+	bus->blocking = 0;
+	bus->steps = 0;
+	
+	//a polled bus is left to its owner
+	if(bus->polled) return;
+	
+	for(i = 0; i < TWI_ASYNC_MAX_BUSES; i++){
+		if( (buses[i] == 0) || (buses[i]->twi == twi) ){
+			buses[i] = bus;
+			break;
+		}
+	}
+	
+	twi_regs_enable_interrupts(twi, intlvl);
+}
+
+void twi_async_set_hold(twi_async_bus_t *bus, uint8_t hold){
+	bus->hold = hold;
+}
+
+twi_async_bus_t *twi_async_bus(TWI_t *twi){
+	uint8_t i;
+	
+	for(i = 0; i < TWI_ASYNC_MAX_BUSES; i++){
+		if( (buses[i] != 0) && (buses[i]->twi == twi) ) return buses[i];
+	}
+	return 0;
+}
+
+void twi_async_prepare(twi_transaction_t *t, uint8_t addr, const uint8_t *write_buf, uint16_t write_len, uint8_t *read_buf, uint16_t read_len, twi_callback_t callback){
+	t->addr = addr;
+	t->cmd = 0;
+	t->cmd_len = 0;
+	t->write_buf = write_buf;
+	t->write_len = write_len;
+	t->read_buf = read_buf;
+	t->read_len = read_len;
+	t->callback = callback;
+	t->status = TWI_STATUS_OK;
+	t->bus = 0;
+	t->next = 0;
+}
+
+void twi_async_prepare_bulk(twi_transaction_t *t, uint8_t addr, const uint8_t *cmd, uint8_t cmd_len, uint8_t *buf, uint16_t len, uint8_t rw, twi_callback_t callback){
+	if(rw == READ) twi_async_prepare(t, addr, 0, 0, buf, len, callback);
+	else twi_async_prepare(t, addr, buf, len, 0, 0, callback);
+	
+	t->cmd = cmd;
+	t->cmd_len = cmd_len;
+}
+
+uint8_t twi_async_submit(twi_async_bus_t *bus, twi_transaction_t *t){
+	t->status = TWI_BUSY;
+	t->bus = bus;
+	t->next = 0;
+	
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE){
+		if(bus->head == 0){
+			bus->head = t;
+			bus->tail = t;
+			if( !bus->blocking ) start_transaction(bus, t);
+		}
+		else{
+			bus->tail->next = t;
+			bus->tail = t;
+		}
+	}
+	
+	resume_transaction(bus);
+	return TWI_BUSY;
+}
+
+uint8_t twi_async_done(twi_transaction_t *t){
+	return t->status != TWI_BUSY;
+}
+
+uint8_t twi_async_wait(twi_transaction_t *t){
+	twi_async_bus_t *bus = t->bus;
+	twi_deadline_t since;
+	uint8_t steps;
+	
+	if(t->status != TWI_BUSY) return t->status;
+	
+	steps = bus->steps;
+	deadline_start_TWI(&since);
+	while(t->status == TWI_BUSY){
+		resume_transaction(bus);
+		
+		//a polled bus only moves when it is stepped, twi_async_poll checks the deadline itself
+		if(bus->polled){
+			twi_async_poll(bus);
+			continue;
+		}
+		
+		//the deadline starts again at every step, a long queue is no reason to give up
+		if(bus->steps != steps){
+			steps = bus->steps;
+			deadline_start_TWI(&since);
+		}
+		else if(deadline_passed_TWI(&since)){
+			ATOMIC_BLOCK(ATOMIC_RESTORESTATE){
+				if( (bus->steps == steps) && (bus->head != 0) && !bus->blocking ) abort_transaction(bus);
+			}
+			continue;
+		}
+		
+		if( !may_sleep_TWI() ) continue;
+		
+		//sleep until the next interrupt, the status is checked with interrupts off so the last one can't be missed
+		cli();
+		if(t->status == TWI_BUSY){
+			set_sleep_mode(SLEEP_MODE_IDLE);
+			sleep_enable();
+			sei();
+			sleep_cpu();
+			sleep_disable();
+		}
+		sei();
+	}
+	return t->status;
+}
+
+uint8_t twi_async_wait_all(twi_transaction_t *const *t, uint8_t count){
+	uint8_t ret = TWI_STATUS_OK;
+	uint8_t status;
+	uint8_t i;
+	
+	for(i = 0; i < count; i++){
+		status = twi_async_wait(t[i]);
+		if( (ret == TWI_STATUS_OK) && (status != TWI_STATUS_OK) ) ret = status;
+	}
+	return ret;
+}
+
+uint8_t twi_async_busy(twi_async_bus_t *bus){
+	resume_transaction(bus);
+	return bus->head != 0;
+}
+
+uint8_t twi_async_transfer(twi_async_bus_t *bus, twi_transaction_t *t){
+	twi_async_submit(bus, t);
+	return twi_async_wait(t);
+}
+
+void twi_async_isr(twi_async_bus_t *bus){
+	TWI_t *twi = bus->twi;
+	twi_transaction_t *t = bus->head;
+	uint8_t status = TWI_M_STATUS(twi);
+	
+	//nothing running or a blocking function waits for the flags, they are left alone
+	//the interrupt is turned on again by the next transaction
+	if( (t == 0) || bus->blocking || (bus->phase == TWI_PHASE_SPEED) ){
+		TWI_M_CTRL(twi) &= ~(TWI_M_RIEN_bm | TWI_M_WIEN_bm);
+		return;
+	}
+	
+	bus->steps++;
+	
+	//the bus is released by the hardware, no stop needed
+	if(status & TWI_M_ARBLOST_bm){
+		TWI_M_STATUS(twi) = TWI_M_WIF_bm | TWI_M_ARBLOST_bm;
+		bus->held = 0;
+		finish_transaction(bus, TWI_ARB_LOST);
+		return;
+	}
+	
+	if(status & TWI_M_BUSERR_bm){
+		TWI_M_STATUS(twi) = TWI_M_WIF_bm | TWI_M_BUSERR_bm;
+		bus->held = 0;
+		finish_transaction(bus, TWI_BUS_ERROR);
+		return;
+	}
+	
+	if(status & TWI_M_WIF_bm){
+		//when RXACK is 1 a NACK has been received
+		if(status & TWI_M_RXACK_bm){
+			TWI_M_CMD(twi) = TWI_M_CMD_STOP_gc;
+			bus->held = 0;
+			finish_transaction(bus, NACK);
+			return;
+		}
+		
+		if(bus->phase == TWI_PHASE_CMD){
+			if(bus->idx < t->cmd_len){
+				TWI_TRACE_EVENT(TWI_EV_BYTE_OUT, t->cmd[bus->idx]);
+				TWI_M_DATA(twi) = t->cmd[bus->idx++];
+				TWI_STATS_BYTE_OUT(twi);
+				return;
+			}
+			
+			//the buffer is send straight after the command bytes
+			bus->idx = 0;
+			bus->phase = TWI_PHASE_WRITE;
+		}
+		
+		if( (bus->phase == TWI_PHASE_WRITE) && (bus->idx < t->write_len) ){
+			TWI_TRACE_EVENT(TWI_EV_BYTE_OUT, t->write_buf[bus->idx]);
+			TWI_M_DATA(twi) = t->write_buf[bus->idx++];
+			TWI_STATS_BYTE_OUT(twi);
+			return;
+		}
+		
+		if( (bus->phase == TWI_PHASE_WRITE) && (t->read_len != 0) ){
+			bus->idx = 0;
+			bus->phase = TWI_PHASE_READ;
+			TWI_M_ADDR(twi) = (t->addr << 1) | READ;	//repeated start
+			TWI_TRACE_EVENT(TWI_EV_RSTART, (t->addr << 1) | READ);
+			return;
+		}
+		
+		complete_transaction(bus, 0);
+		return;
+	}
+	
+	if(status & TWI_M_RIF_bm){
+		uint8_t smart = TWI_M_MODE(twi) & TWI_M_SMEN_bm;
+		
+		if( (bus->idx + 1) < t->read_len ){
+			t->read_buf[bus->idx++] = TWI_M_DATA(twi);	//in smart mode this sends the ACK and receives the next byte
+			if( !smart ) TWI_M_CMD(twi) = TWI_M_CMD_RECVTRANS_gc;	//send ack (go on)
+			TWI_STATS_BYTE_IN(twi);
+			TWI_TRACE_EVENT(TWI_EV_BYTE_IN, t->read_buf[bus->idx - 1]);
+			return;
+		}
+		
+		//nack (and stop) before DATA is read, so smart mode doesn't send an ACK
+		end_transaction(bus, TWI_M_ACKACT_bm);
+		t->read_buf[bus->idx++] = TWI_M_DATA(twi);
+		if(smart) TWI_M_CMD(twi) = 0;	//ACK again for the next read
+		TWI_STATS_BYTE_IN(twi);
+		TWI_TRACE_EVENT(TWI_EV_BYTE_IN, t->read_buf[bus->idx - 1]);
+		finish_transaction(bus, TWI_STATUS_OK);
+	}
+}
+
+uint8_t twi_async_poll(twi_async_bus_t *bus){
+	resume_transaction(bus);
+	if(bus->head == 0) return 0;
+	
+	if(TWI_M_STATUS(bus->twi) & (TWI_M_RIF_bm | TWI_M_WIF_bm)){
+		deadline_start_TWI(&bus->since);
+		twi_async_isr(bus);
+	}
+	else if(deadline_passed_TWI(&bus->since)){
+		abort_transaction(bus);
+	}
+	
+	return bus->head != 0;
+}
+
+void twi_async_claim(TWI_t *twi){
+	twi_async_bus_t *bus = twi_async_bus(twi);
+	twi_transaction_t *last;
+	
+	if(bus == 0) return;
+	
+	//the queue is finished first, waiting on its last transaction also times out a stuck bus
+	do{
+		ATOMIC_BLOCK(ATOMIC_RESTORESTATE){
+			last = bus->blocking ? 0 : bus->tail;
+			if(last == 0){
+				bus->blocking = 1;
+				TWI_M_CTRL(twi) &= ~(TWI_M_RIEN_bm | TWI_M_WIEN_bm);
+			}
+		}
+		if(last != 0) twi_async_wait(last);
+	}while(last != 0);
+}
+
+void twi_async_release(TWI_t *twi){
+	twi_async_bus_t *bus = twi_async_bus(twi);
+	
+	if(bus == 0) return;
+	
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE){
+		if(bus->blocking){
+			bus->blocking = 0;
+			if(bus->head != 0) start_transaction(bus, bus->head);
+		}
+	}
+}
@@ -0,0 +1,189 @@
+/*
+ * File twi_async.h
+ * Author: Tycho Jöbsis
+ * Date: 16-10-2026
+ */ 
+
+/*
+*	MIT License
+*
+*	Copyright (c) 2021 TychoJ
+*
+*	Permission is hereby granted, free of charge, to any person obtaining a copy
+*	of this software and associated documentation files (the "Software"), to deal
+*	in the Software without restriction, including without limitation the rights
+*	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*	copies of the Software, and to permit persons to whom the Software is
+*	furnished to do so, subject to the following conditions:
+*
+*	The above copyright notice and this permission notice shall be included in all
+*	copies or substantial portions of the Software.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*	SOFTWARE.
+*/
+
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "twi.h"
+
+#ifndef TWI_ASYNC_H_
+#define TWI_ASYNC_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//interrupt level of twi_async_init for a bus without interrupts, it is stepped with twi_async_poll
+#define TWI_ASYNC_POLLED 0xFF
+
+#define TWI_PHASE_CMD   0
+#define TWI_PHASE_WRITE 1
+#define TWI_PHASE_READ  2
+#define TWI_PHASE_SPEED 3	//waits for the stop of the previous transaction to change the speed
+
+struct twi_transaction;
+
+//called from the TWI interrupt when a transaction is finished
+//keep it short, the next queued transaction is already running
+typedef void (*twi_callback_t)(struct twi_transaction *t);
+
+//a single transaction: write cmd_len bytes from cmd and write_len bytes from write_buf,
+//then (repeated start) read read_len bytes
+//cmd is meant for a register or memory address in front of a buffer, so the buffer never has to be copied
+//the transaction must stay valid until status is no longer TWI_BUSY
+//status is TWI_STATUS_OK, NACK, TWI_ARB_LOST or TWI_BUS_ERROR when finished,
+//DATA_NOT_SEND or DATA_NOT_RECEIVED when the bus made no progress within the deadline
+typedef struct twi_transaction {
+	uint8_t addr;
+	const uint8_t *cmd;
+	uint8_t cmd_len;
+	const uint8_t *write_buf;
+	uint16_t write_len;
+	uint8_t *read_buf;
+	uint16_t read_len;
+	twi_callback_t callback;
+	volatile uint8_t status;
+	struct twi_async_bus *bus;
+	struct twi_transaction *next;
+} twi_transaction_t;
+
+//the state of one TWI module used by the interrupt
+typedef struct twi_async_bus {
+	TWI_t *twi;
+	twi_transaction_t *volatile head;
+	twi_transaction_t *tail;
+	uint16_t idx;
+	uint8_t phase;
+	uint8_t hold;
+	uint8_t held;
+	uint8_t polled;
+	uint8_t blocking;		//a blocking function owns the module, see twi_async_claim
+	volatile uint8_t steps;	//counts the handled flags, twi_async_wait sees the bus moving
+	twi_deadline_t since;	//deadline start of the last step of a polled bus
+} twi_async_bus_t;
+
+//defines the master interrupt of a TWI module, use once per module
+//example: TWI_ASYNC_ISR(TWIE, twie_bus)
+#define TWI_ASYNC_ISR(module, bus)	ISR(module##_TWIM_vect){ twi_async_isr(&(bus)); }
+
+//with TWI_ASYNC_BUSES defined while compiling twi_async.c a bus and its interrupt
+//are defined for every TWI module of the device, each with its own queue
+//transactions on different modules run at the same time
+#ifdef TWI_ASYNC_BUSES
+#ifdef TWIC
+extern twi_async_bus_t twic_bus;
+#endif
+#ifdef TWID
+extern twi_async_bus_t twid_bus;
+#endif
+#ifdef TWIE
+extern twi_async_bus_t twie_bus;
+#endif
+#ifdef TWIF
+extern twi_async_bus_t twif_bus;
+#endif
+#ifdef TWI0
+extern twi_async_bus_t twi0_bus;
+#endif
+#endif
+
+//enables the master interrupts of an already enabled TWI module
+//intlvl is one of the TWI_INTLVL_xx values, it is ignored on devices without interrupt levels
+//interrupts still have to be enabled with sei()
+//with TWI_ASYNC_POLLED no interrupt is used and the blocking functions don't use the bus
+void twi_async_init(twi_async_bus_t *bus, TWI_t *twi, uint8_t intlvl);
+
+//keeps the bus for at most hold queued transactions in a row, they are chained with a repeated start
+//after that the bus is released with a stop so other masters get a turn
+//0 (default) stops after every transaction
+void twi_async_set_hold(twi_async_bus_t *bus, uint8_t hold);
+
+//returns the bus registered for a TWI module or 0 if there is none
+twi_async_bus_t *twi_async_bus(TWI_t *twi);
+
+//fills in a transaction
+void twi_async_prepare(twi_transaction_t *t, uint8_t addr, const uint8_t *write_buf, uint16_t write_len, uint8_t *read_buf, uint16_t read_len, twi_callback_t callback);
+
+//fills in a bulk transaction, cmd is send first followed by len bytes from or to buf
+//rw is WRITE or READ
+//example: a 256 byte EEPROM page or a SSD1306 framebuffer page without copying it
+void twi_async_prepare_bulk(twi_transaction_t *t, uint8_t addr, const uint8_t *cmd, uint8_t cmd_len, uint8_t *buf, uint16_t len, uint8_t rw, twi_callback_t callback);
+
+//adds a transaction to the queue, it is started right away when the bus is free
+//a transaction that needs another speed (set_device_speed_TWI) than the one before it can't start from the
+//interrupt while the stop is still on the bus, it is started by the next twi_async_submit, twi_async_wait,
+//twi_async_busy or twi_async_poll of the bus
+//returns TWI_BUSY if the transaction is still in a queue
+uint8_t twi_async_submit(twi_async_bus_t *bus, twi_transaction_t *t);
+
+//returns 1 when the transaction is finished
+uint8_t twi_async_done(twi_transaction_t *t);
+
+//waits until a transaction is finished and returns its status
+//when the bus makes no progress within the deadline (set_deadline_TWI) the running transaction is stopped,
+//it ends with DATA_NOT_SEND or DATA_NOT_RECEIVED and the next queued one is started
+//with set_sleep_TWI the deadline is only checked when an interrupt wakes the CPU, like for the blocking functions
+//a TWI_ASYNC_POLLED bus is stepped with twi_async_poll while waiting
+uint8_t twi_async_wait(twi_transaction_t *t);
+
+//waits until all transactions are finished, they can be on different modules
+//returns TWI_STATUS_OK or the status of the first transaction that failed
+uint8_t twi_async_wait_all(twi_transaction_t *const *t, uint8_t count);
+
+//returns 1 while a bus still has transactions queued
+uint8_t twi_async_busy(twi_async_bus_t *bus);
+
+//submits a transaction and waits until it is finished
+uint8_t twi_async_transfer(twi_async_bus_t *bus, twi_transaction_t *t);
+
+//state machine, must be called from the master interrupt of the module
+//with nothing queued, or while a blocking function owns the module, it only turns the interrupt off
+//and leaves the flags to the blocking function
+void twi_async_isr(twi_async_bus_t *bus);
+
+//used by the blocking functions of twi.c when it is compiled with TWI_ASYNC, nothing happens for a module without a bus
+//claim waits until the queue of the module is empty and keeps the engine off the module,
+//transactions submitted in the meantime are queued and started by release
+//start_TWI and quick_command_TWI claim the module, stop_TWI (or a failed start) releases it
+void twi_async_claim(TWI_t *twi);
+void twi_async_release(TWI_t *twi);
+
+//steps a bus set up with TWI_ASYNC_POLLED, call it from the main loop
+//handles the TWI flags when they are set and never waits for them
+//a transaction that makes no progress within the deadline (set_deadline_TWI) ends with DATA_NOT_SEND
+//returns 1 while the bus still has transactions queued
+uint8_t twi_async_poll(twi_async_bus_t *bus);
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /* TWI_ASYNC_H_ */
@@ -0,0 +1,185 @@
+/*
+ * File twi_eeprom.c
+ * Author: Tycho Jöbsis
+ * Date: 16-10-2026
+ */ 
+
+/*
+*	MIT License
+*
+*	Copyright (c) 2021 TychoJ
+*
+*	Permission is hereby granted, free of charge, to any person obtaining a copy
+*	of this software and associated documentation files (the "Software"), to deal
+*	in the Software without restriction, including without limitation the rights
+*	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*	copies of the Software, and to permit persons to whom the Software is
+*	furnished to do so, subject to the following conditions:
+*
+*	The above copyright notice and this permission notice shall be included in all
+*	copies or substantial portions of the Software.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*	SOFTWARE.
+*/
+
+#include <avr/io.h>
+#include <util/delay.h>
+#include "twi.h"
+#include "twi_eeprom.h"
+
+#ifdef TWI_ASYNC
+#include "twi_async.h"
+#endif
+
+void twi_eeprom_init(twi_eeprom_t *ee, TWI_t *twi, uint8_t addr, uint32_t size, uint16_t page_size, uint8_t addr_bytes){
+	ee->twi = twi;
+	ee->addr = addr;
+	ee->size = size;
+	ee->page_size = page_size;
+	ee->addr_bytes = addr_bytes;
+}
+
+//ends a transfer after an error of the bus
+//after a lost arbitration or a bus error the bus isn't ours anymore, only the module is given back
+static uint8_t eeprom_abort(TWI_t *twi, uint8_t err){
+	if( (err == TWI_ARB_LOST) || (err == TWI_BUS_ERROR) ){
+#ifdef TWI_ASYNC
+		twi_async_release(twi);
+#endif
+		return err;
+	}
+	
+	stop_TWI(twi);
+	return err;
+}
+
+//one write or read at mem, the memory address is send MSB first
+//the bits of mem above the address bytes go into the device address
+//returns NACK when the EEPROM didn't answer its address, it is still busy writing
+static uint8_t eeprom_transfer(twi_eeprom_t *ee, uint32_t mem, uint8_t *data, uint16_t len, uint8_t rw){
+	uint8_t dev = ee->addr | (uint8_t)(mem >> (8 * ee->addr_bytes));
+	uint8_t cmd[2];
+	uint8_t n = 0;
+	uint8_t err;
+	uint16_t i;
+	
+	if(ee->addr_bytes == 2) cmd[n++] = mem >> 8;
+	cmd[n++] = mem;
+	
+#ifdef TWI_ASYNC
+	//use the interrupt driven engine when it is enabled for this module, the address goes in front without a copy
+	//a NACK of the data can't be told apart from a busy EEPROM here
+	twi_async_bus_t *bus = twi_async_bus(ee->twi);
+	if( (bus != 0) && !bus->blocking ){
+		twi_transaction_t t;
+		if(rw == READ) twi_async_prepare(&t, dev, cmd, n, data, len, 0);
+		else twi_async_prepare_bulk(&t, dev, cmd, n, data, len, WRITE, 0);
+		return twi_async_transfer(bus, &t);
+	}
+#endif
+	
+	//a NACK of the address also stops the bus
+	err = start_TWI(ee->twi, dev, WRITE);
+	if(err != ACK) return err;
+	
+	for(i = 0; i < n; i++){
+		err = send_TWI(ee->twi, cmd[i]);
+		if(err != ACK) return eeprom_abort(ee->twi, (err == NACK) ? DATA_NOT_SEND : err);
+	}
+	
+	if(rw == WRITE){
+		for(i = 0; i < len; i++){
+			err = send_TWI(ee->twi, data[i]);
+			if(err != ACK) return eeprom_abort(ee->twi, (err == NACK) ? DATA_NOT_SEND : err);
+		}
+		
+		stop_TWI(ee->twi);
+		return TWI_STATUS_OK;
+	}
+	
+	//a NACK of the read address has already stopped the bus
+	err = repeated_start_TWI(ee->twi, dev, READ);
+	if(err == NACK) return DATA_NOT_RECEIVED;
+	if(err != ACK) return eeprom_abort(ee->twi, err);
+	
+	//ACK every byte but the last one, the last one stops the bus
+	for(i = 0; i < len; i++){
+		err = read_TWI(ee->twi, &data[i], (i < (len - 1)) ? ACK : NACK);
+		if(err == DATA_NOT_RECEIVED) return eeprom_abort(ee->twi, DATA_NOT_RECEIVED);
+	}
+	
+	return TWI_STATUS_OK;
+}
+
+//address polling: the EEPROM doesn't acknowledge its address until the write cycle is done
+//the transfer is tried again until it is or TWI_EEPROM_WRITE_US has passed
+static uint8_t eeprom_poll(twi_eeprom_t *ee, uint32_t mem, uint8_t *data, uint16_t len, uint8_t rw){
+	uint16_t waited = 0;
+	uint8_t err;
+	
+	while(1){
+		err = eeprom_transfer(ee, mem, data, len, rw);
+		if(err != NACK) return err;
+		
+		if(waited >= TWI_EEPROM_WRITE_US) return TWI_BUSY;
+		TWI_DELAY_US(TWI_EEPROM_POLL_US);
+		waited += TWI_EEPROM_POLL_US;
+	}
+}
+
+uint8_t twi_eeprom_write(twi_eeprom_t *ee, uint32_t mem, const uint8_t *data, uint16_t len){
+	uint16_t chunk;
+	uint8_t err;
+	
+	if( (mem >= ee->size) || (len > (ee->size - mem)) ) return TWI_OUT_OF_RANGE;
+	
+	while(len){
+		//up to the end of the page, a write past it would wrap to the start of the page
+		chunk = ee->page_size - (mem & (ee->page_size - 1));
+		if(chunk > len) chunk = len;
+		
+		//the data is only read, never changed
+		err = eeprom_poll(ee, mem, (uint8_t *)data, chunk, WRITE);
+		if(err != TWI_STATUS_OK) return err;
+		
+		mem += chunk;
+		data += chunk;
+		len -= chunk;
+	}
+	
+	return TWI_STATUS_OK;
+}
+
+uint8_t twi_eeprom_read(twi_eeprom_t *ee, uint32_t mem, uint8_t *data, uint16_t len){
+	uint32_t block = 1UL << (8 * ee->addr_bytes);
+	uint32_t chunk;
+	uint8_t err;
+	
+	if( (mem >= ee->size) || (len > (ee->size - mem)) ) return TWI_OUT_OF_RANGE;
+	
+	while(len){
+		//a sequential read stays within the block of one device address
+		chunk = block - (mem & (block - 1));
+		if(chunk > len) chunk = len;
+		
+		err = eeprom_poll(ee, mem, data, chunk, READ);
+		if(err != TWI_STATUS_OK) return err;
+		
+		mem += chunk;
+		data += chunk;
+		len -= chunk;
+	}
+	
+	return TWI_STATUS_OK;
+}
+
+uint8_t twi_eeprom_wait(twi_eeprom_t *ee){
+	//an empty write only sets the address pointer
+	return eeprom_poll(ee, 0, 0, 0, WRITE);
+}
@@ -0,0 +1,93 @@
+/*
+ * File twi_eeprom.h
+ * Author: Tycho Jöbsis
+ * Date: 16-10-2026
+ */ 
+
+/*
+*	MIT License
+*
+*	Copyright (c) 2021 TychoJ
+*
+*	Permission is hereby granted, free of charge, to any person obtaining a copy
+*	of this software and associated documentation files (the "Software"), to deal
+*	in the Software without restriction, including without limitation the rights
+*	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*	copies of the Software, and to permit persons to whom the Software is
+*	furnished to do so, subject to the following conditions:
+*
+*	The above copyright notice and this permission notice shall be included in all
+*	copies or substantial portions of the Software.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*	SOFTWARE.
+*/
+
+#include <avr/io.h>
+#include "twi.h"
+
+#ifndef TWI_EEPROM_H_
+#define TWI_EEPROM_H_
+
+//longest internal write cycle of the EEPROM in us, after that a device that doesn't answer is reported
+#ifndef TWI_EEPROM_WRITE_US
+#define TWI_EEPROM_WRITE_US 10000
+#endif
+
+//time in us between two address polls while the EEPROM is writing
+#ifndef TWI_EEPROM_POLL_US
+#define TWI_EEPROM_POLL_US 20
+#endif
+
+//size, page size and address bytes of common parts, for twi_eeprom_init
+//memory above the address bytes is selected with the low bits of the device address
+#define TWI_EEPROM_24C01	128UL, 8, 1
+#define TWI_EEPROM_24C02	256UL, 8, 1
+#define TWI_EEPROM_24C04	512UL, 16, 1
+#define TWI_EEPROM_24C08	1024UL, 16, 1
+#define TWI_EEPROM_24C16	2048UL, 16, 1
+#define TWI_EEPROM_24C32	4096UL, 32, 2
+#define TWI_EEPROM_24C64	8192UL, 32, 2
+#define TWI_EEPROM_24C128	16384UL, 64, 2
+#define TWI_EEPROM_24C256	32768UL, 64, 2
+#define TWI_EEPROM_24C512	65536UL, 128, 2
+#define TWI_EEPROM_24CM01	131072UL, 256, 2
+#define TWI_EEPROM_24CM02	262144UL, 256, 2
+
+//an I2C EEPROM
+typedef struct {
+	TWI_t *twi;
+	uint8_t addr;
+	uint8_t addr_bytes;
+	uint16_t page_size;
+	uint32_t size;
+} twi_eeprom_t;
+
+//sets up an EEPROM
+//addr is the 7 bit address with the block select bits 0, normally 0x50
+//size and page_size are in bytes, page_size is a power of 2
+//addr_bytes is the number of memory address bytes, 1 or 2
+//example: twi_eeprom_init(&ee, &TWIE, 0x50, TWI_EEPROM_24C256);
+void twi_eeprom_init(twi_eeprom_t *ee, TWI_t *twi, uint8_t addr, uint32_t size, uint16_t page_size, uint8_t addr_bytes);
+
+//writes len bytes from data starting at mem, split at the page boundaries
+//every page waits for the write cycle of the previous one by polling the address, the last one isn't waited for
+//returns 5 (TWI_STATUS_OK), 6 (TWI_BUSY) when the EEPROM doesn't answer within TWI_EEPROM_WRITE_US,
+//10 (DATA_NOT_SEND) when data is not acknowledged (write protected), 12 (TWI_OUT_OF_RANGE) or an error of start_TWI
+uint8_t twi_eeprom_write(twi_eeprom_t *ee, uint32_t mem, const uint8_t *data, uint16_t len);
+
+//reads len bytes starting at mem into data, waits for a running write cycle first
+//returns 5 (TWI_STATUS_OK), 6 (TWI_BUSY), 7 (DATA_NOT_RECEIVED), 12 (TWI_OUT_OF_RANGE) or an error of start_TWI
+uint8_t twi_eeprom_read(twi_eeprom_t *ee, uint32_t mem, uint8_t *data, uint16_t len);
+
+//waits until the last write cycle is finished, use it before turning the EEPROM off
+//returns 5 (TWI_STATUS_OK) or 6 (TWI_BUSY)
+uint8_t twi_eeprom_wait(twi_eeprom_t *ee);
+
+
+#endif /* TWI_EEPROM_H_ */
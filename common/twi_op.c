@@ -0,0 +1,104 @@
+/*
+ * File twi_op.c
+ * Author: Tycho Jöbsis
+ * Date: 16-10-2026
+ */ 
+
+/*
+*	MIT License
+*
+*	Copyright (c) 2021 TychoJ
+*
+*	Permission is hereby granted, free of charge, to any person obtaining a copy
+*	of this software and associated documentation files (the "Software"), to deal
+*	in the Software without restriction, including without limitation the rights
+*	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*	copies of the Software, and to permit persons to whom the Software is
+*	furnished to do so, subject to the following conditions:
+*
+*	The above copyright notice and this permission notice shall be included in all
+*	copies or substantial portions of the Software.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*	SOFTWARE.
+*/
+
+#include <avr/io.h>
+#include <util/atomic.h>
+#include "twi.h"
+#include "twi_async.h"
+#include "twi_op.h"
+
+//the transaction is the first member of the operation
+static void op_finished(twi_transaction_t *t){
+	twi_op_t *op = (twi_op_t *)t;
+	
+	if(op->done != 0) op->done(op);
+}
+
+//submits the transaction that has been filled in
+static uint8_t op_submit(twi_op_t *op, twi_async_bus_t *bus){
+	op->bus = bus;
+	op->done = 0;
+	op->t.callback = op_finished;
+	return twi_async_submit(bus, &op->t);
+}
+
+uint8_t twi_op_send_8bit(twi_op_t *op, twi_async_bus_t *bus, uint8_t addr, uint8_t data){
+	op->buf[0] = data;
+	twi_async_prepare(&op->t, addr, op->buf, 1, 0, 0, 0);
+	return op_submit(op, bus);
+}
+
+uint8_t twi_op_write_8bit_register(twi_op_t *op, twi_async_bus_t *bus, uint8_t addr, uint8_t data, uint8_t reg){
+	op->buf[0] = reg;
+	op->buf[1] = data;
+	twi_async_prepare(&op->t, addr, op->buf, 2, 0, 0, 0);
+	return op_submit(op, bus);
+}
+
+uint8_t twi_op_read_8bit_register(twi_op_t *op, twi_async_bus_t *bus, uint8_t addr, uint8_t *data, uint8_t reg){
+	op->buf[0] = reg;
+	twi_async_prepare(&op->t, addr, op->buf, 1, data, 1, 0);
+	return op_submit(op, bus);
+}
+
+uint8_t twi_op_write_registers(twi_op_t *op, twi_async_bus_t *bus, uint8_t addr, const uint8_t *data, uint8_t reg, uint16_t len){
+	op->buf[0] = reg;
+	twi_async_prepare_bulk(&op->t, addr, op->buf, 1, (uint8_t *)data, len, WRITE, 0);	//only read
+	return op_submit(op, bus);
+}
+
+uint8_t twi_op_read_registers(twi_op_t *op, twi_async_bus_t *bus, uint8_t addr, uint8_t *data, uint8_t reg, uint16_t len){
+	op->buf[0] = reg;
+	twi_async_prepare(&op->t, addr, op->buf, 1, data, len, 0);
+	return op_submit(op, bus);
+}
+
+uint8_t twi_op_status(twi_op_t *op){
+	//a polled bus is stepped, the busy check starts a transaction that waits for a new speed
+	if(op->t.status == TWI_BUSY){
+		if(op->bus->polled) twi_async_poll(op->bus);
+		else twi_async_busy(op->bus);
+	}
+	return op->t.status;
+}
+
+uint8_t twi_op_set_done(twi_op_t *op, twi_op_done_t done, void *user){
+	uint8_t waiting = 0;
+	
+	//the interrupt must not finish the operation between the check and setting done
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE){
+		if(op->t.status == TWI_BUSY){
+			op->user = user;
+			op->done = done;
+			waiting = 1;
+		}
+	}
+	return waiting;
+}
@@ -0,0 +1,89 @@
+/*
+ * File twi_op.h
+ * Author: Tycho Jöbsis
+ * Date: 16-10-2026
+ */ 
+
+/*
+*	MIT License
+*
+*	Copyright (c) 2021 TychoJ
+*
+*	Permission is hereby granted, free of charge, to any person obtaining a copy
+*	of this software and associated documentation files (the "Software"), to deal
+*	in the Software without restriction, including without limitation the rights
+*	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*	copies of the Software, and to permit persons to whom the Software is
+*	furnished to do so, subject to the following conditions:
+*
+*	The above copyright notice and this permission notice shall be included in all
+*	copies or substantial portions of the Software.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*	SOFTWARE.
+*/
+
+#include <avr/io.h>
+#include "twi.h"
+#include "twi_async.h"
+
+#ifndef TWI_OP_H_
+#define TWI_OP_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct twi_op;
+
+//called when an operation is finished, from twi_async_poll or the TWI interrupt
+typedef void (*twi_op_done_t)(struct twi_op *op);
+
+//the state of one operation that runs while the caller does other work
+//owned by the caller, it must stay valid until twi_op_status is no longer TWI_BUSY
+typedef struct twi_op {
+	twi_transaction_t t;
+	twi_async_bus_t *bus;
+	uint8_t buf[2];		//register and data, so the caller doesn't have to keep them
+	twi_op_done_t done;
+	void *user;
+} twi_op_t;
+
+/*
+ * Non-blocking versions of the functions of twi.h
+ * They start the operation on a bus of twi_async_init and return TWI_BUSY right away,
+ * twi_op_status tells when it is finished. On a TWI_ASYNC_POLLED bus nothing happens between
+ * two calls of twi_op_status (or twi_async_poll), so no interrupt is needed.
+ */
+
+uint8_t twi_op_send_8bit(twi_op_t *op, twi_async_bus_t *bus, uint8_t addr, uint8_t data);
+
+uint8_t twi_op_write_8bit_register(twi_op_t *op, twi_async_bus_t *bus, uint8_t addr, uint8_t data, uint8_t reg);
+
+//data must stay valid until the operation is finished
+uint8_t twi_op_read_8bit_register(twi_op_t *op, twi_async_bus_t *bus, uint8_t addr, uint8_t *data, uint8_t reg);
+
+//data must stay valid until the operation is finished, it is not copied
+uint8_t twi_op_write_registers(twi_op_t *op, twi_async_bus_t *bus, uint8_t addr, const uint8_t *data, uint8_t reg, uint16_t len);
+
+//data must stay valid until the operation is finished
+uint8_t twi_op_read_registers(twi_op_t *op, twi_async_bus_t *bus, uint8_t addr, uint8_t *data, uint8_t reg, uint16_t len);
+
+//steps a polled bus and returns TWI_BUSY while the operation runs
+//then TWI_STATUS_OK, NACK, TWI_ARB_LOST, TWI_BUS_ERROR or DATA_NOT_SEND
+uint8_t twi_op_status(twi_op_t *op);
+
+//sets the function that is called when the operation is finished, user is kept in op->user
+//returns 1 when it will be called, 0 when the operation was already finished
+uint8_t twi_op_set_done(twi_op_t *op, twi_op_done_t done, void *user);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TWI_OP_H_ */
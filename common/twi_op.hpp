@@ -0,0 +1,88 @@
+/*
+ * File twi_op.hpp
+ * Author: Tycho Jöbsis
+ * Date: 16-10-2026
+ */ 
+
+/*
+*	MIT License
+*
+*	Copyright (c) 2021 TychoJ
+*
+*	Permission is hereby granted, free of charge, to any person obtaining a copy
+*	of this software and associated documentation files (the "Software"), to deal
+*	in the Software without restriction, including without limitation the rights
+*	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*	copies of the Software, and to permit persons to whom the Software is
+*	furnished to do so, subject to the following conditions:
+*
+*	The above copyright notice and this permission notice shall be included in all
+*	copies or substantial portions of the Software.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*	SOFTWARE.
+*/
+
+#include "twi_op.h"
+
+#ifndef TWI_OP_HPP_
+#define TWI_OP_HPP_
+
+/*
+ * C++20 coroutine support for the operations of twi_op.h, only when the toolchain has <coroutine>.
+ * co_await on a started operation gives its status, the coroutine continues from twi_async_poll
+ * (TWI_ASYNC_POLLED bus) or from the TWI interrupt. Nothing is allocated by the awaitable,
+ * where the coroutine frame lives is up to the coroutine type.
+ *
+ * On a bus with interrupts the coroutine resumes in ISR context: inside the master interrupt of the module,
+ * with interrupts off, until it suspends on the next co_await or ends. Keep that part short, starting
+ * the next operation is fine, the blocking functions of twi.h on the same module are not.
+ * A coroutine that must not run in the interrupt uses a TWI_ASYNC_POLLED bus.
+ *
+ * example:
+ *	twi_op_t op;
+ *	twi_op_read_registers(&op, &bus, 0x1D, accel, 0x28, 6);
+ *	uint8_t status = co_await TwiOp(&op);
+ */
+
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#if __has_include(<coroutine>)
+#include <coroutine>
+#define TWI_OP_COROUTINES 1
+#endif
+#endif
+
+#ifdef TWI_OP_COROUTINES
+class TwiOp {
+public:
+	explicit TwiOp(twi_op_t *op) : op(op) {}
+	
+	bool await_ready() const {
+		return twi_op_status(op) != TWI_BUSY;
+	}
+	
+	//doesn't suspend when the operation finished in the mean time
+	bool await_suspend(std::coroutine_handle<> handle){
+		return twi_op_set_done(op, resume, handle.address());
+	}
+	
+	uint8_t await_resume() const {
+		return op->t.status;
+	}
+	
+private:
+	static void resume(twi_op_t *op){
+		std::coroutine_handle<>::from_address(op->user).resume();
+	}
+	
+	twi_op_t *op;
+};
+#endif
+
+
+#endif /* TWI_OP_HPP_ */
@@ -0,0 +1,152 @@
+/*
+ * File twi_regmap.c
+ * Author: Tycho Jöbsis
+ * Date: 16-10-2026
+ */ 
+
+/*
+*	MIT License
+*
+*	Copyright (c) 2021 TychoJ
+*
+*	Permission is hereby granted, free of charge, to any person obtaining a copy
+*	of this software and associated documentation files (the "Software"), to deal
+*	in the Software without restriction, including without limitation the rights
+*	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*	copies of the Software, and to permit persons to whom the Software is
+*	furnished to do so, subject to the following conditions:
+*
+*	The above copyright notice and this permission notice shall be included in all
+*	copies or substantial portions of the Software.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*	SOFTWARE.
+*/
+
+#include <avr/io.h>
+#include "twi.h"
+#include "twi_regmap.h"
+
+//returns 1 when reg is in the map
+static uint8_t in_map(twi_regmap_t *map, uint8_t reg){
+	return (reg >= map->first_reg) && ((uint8_t)(reg - map->first_reg) < map->count);
+}
+
+void twi_regmap_init(twi_regmap_t *map, TWI_t *twi, uint8_t addr, uint8_t *cache, uint8_t *flags){
+	map->twi = twi;
+	map->addr = addr;
+	if(cache != 0) map->cache = cache;
+	if(flags != 0) map->flags = flags;
+	
+	twi_regmap_invalidate(map);
+}
+
+uint8_t twi_regmap_set_volatile(twi_regmap_t *map, uint8_t reg, uint8_t count){
+	uint8_t err;
+	uint16_t r;
+	uint8_t i;
+	
+	//there is no register after 0xFF, reg + count doesn't wrap around to register 0
+	for(r = reg; (r < (uint16_t)reg + count) && (r <= 0xFF); r++){
+		if( !in_map(map, r) ) continue;
+		
+		i = r - map->first_reg;
+		
+		//a value that hasn't been send yet would be lost
+		if(map->flags[i] & TWI_REG_DIRTY){
+			err = write_8bit_register_TWI(map->twi, map->addr, map->cache[i], r);
+			if(err != TWI_STATUS_OK) return err;
+		}
+		
+		map->flags[i] = TWI_REG_VOLATILE;
+	}
+	
+	return TWI_STATUS_OK;
+}
+
+void twi_regmap_invalidate(twi_regmap_t *map){
+	uint8_t i;
+	
+	//only the volatile marks are kept
+	for(i = 0; i < map->count; i++) map->flags[i] &= TWI_REG_VOLATILE;
+}
+
+uint8_t twi_regmap_read(twi_regmap_t *map, uint8_t reg, uint8_t *data){
+	uint8_t err;
+	uint8_t i;
+	
+	if( !in_map(map, reg) ) return read_8bit_register_TWI(map->twi, map->addr, data, reg);
+	
+	i = reg - map->first_reg;
+	
+	if(map->flags[i] & TWI_REG_VOLATILE) return read_8bit_register_TWI(map->twi, map->addr, data, reg);
+	
+	if( !(map->flags[i] & TWI_REG_VALID) ){
+		err = read_8bit_register_TWI(map->twi, map->addr, &map->cache[i], reg);
+		if(err != TWI_STATUS_OK) return err;
+		map->flags[i] |= TWI_REG_VALID;
+	}
+	
+	(*data) = map->cache[i];
+	return TWI_STATUS_OK;
+}
+
+uint8_t twi_regmap_write(twi_regmap_t *map, uint8_t reg, uint8_t data){
+	uint8_t i;
+	
+	if( !in_map(map, reg) ) return write_8bit_register_TWI(map->twi, map->addr, data, reg);
+	
+	i = reg - map->first_reg;
+	
+	if(map->flags[i] & TWI_REG_VOLATILE) return write_8bit_register_TWI(map->twi, map->addr, data, reg);
+	
+	//the device already has this value
+	if( (map->flags[i] & TWI_REG_VALID) && (map->cache[i] == data) ) return TWI_STATUS_OK;
+	
+	map->cache[i] = data;
+	map->flags[i] |= TWI_REG_VALID | TWI_REG_DIRTY;
+	return TWI_STATUS_OK;
+}
+
+uint8_t twi_regmap_update_bits(twi_regmap_t *map, uint8_t reg, uint8_t mask, uint8_t val){
+	uint8_t err;
+	uint8_t old;
+	uint8_t new;
+	
+	err = twi_regmap_read(map, reg, &old);
+	if(err != TWI_STATUS_OK) return err;
+	
+	new = (old & ~mask) | (val & mask);
+	
+	if(new == old) return TWI_STATUS_OK;
+	
+	return twi_regmap_write(map, reg, new);
+}
+
+uint8_t twi_regmap_flush(twi_regmap_t *map){
+	uint8_t err;
+	uint8_t i = 0;
+	uint8_t j;
+	
+	while(i < map->count){
+		if( !(map->flags[i] & TWI_REG_DIRTY) ){
+			i++;
+			continue;
+		}
+		
+		//find the end of this run of dirty registers
+		for(j = i + 1; (j < map->count) && (map->flags[j] & TWI_REG_DIRTY); j++);
+		
+		err = write_registers_TWI(map->twi, map->addr, &map->cache[i], map->first_reg + i, j - i);
+		if(err != TWI_STATUS_OK) return err;
+		
+		for(; i < j; i++) map->flags[i] &= ~TWI_REG_DIRTY;
+	}
+	
+	return TWI_STATUS_OK;
+}
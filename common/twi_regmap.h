@@ -0,0 +1,88 @@
+/*
+ * File twi_regmap.h
+ * Author: Tycho Jöbsis
+ * Date: 16-10-2026
+ */ 
+
+/*
+*	MIT License
+*
+*	Copyright (c) 2021 TychoJ
+*
+*	Permission is hereby granted, free of charge, to any person obtaining a copy
+*	of this software and associated documentation files (the "Software"), to deal
+*	in the Software without restriction, including without limitation the rights
+*	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*	copies of the Software, and to permit persons to whom the Software is
+*	furnished to do so, subject to the following conditions:
+*
+*	The above copyright notice and this permission notice shall be included in all
+*	copies or substantial portions of the Software.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*	SOFTWARE.
+*/
+
+
+#include <avr/io.h>
+#include "twi.h"
+
+#ifndef TWI_REGMAP_H_
+#define TWI_REGMAP_H_
+
+#define TWI_REG_VALID    0x01
+#define TWI_REG_DIRTY    0x02
+#define TWI_REG_VOLATILE 0x04
+
+//a cache of the registers first_reg up to first_reg + count - 1 of one TWI device
+//cache and flags are supplied by the user and hold count bytes each
+typedef struct twi_regmap {
+	TWI_t *twi;
+	uint8_t addr;
+	uint8_t first_reg;
+	uint8_t count;
+	uint8_t *cache;
+	uint8_t *flags;
+} twi_regmap_t;
+
+//declares the storage and the map for a device
+//example: TWI_REGMAP_DEFINE(accel, 0x20, 0x30) caches register 0x20 up to 0x4F
+#define TWI_REGMAP_DEFINE(name, first_reg, count) \
+	static uint8_t name##_cache[count]; \
+	static uint8_t name##_flags[count]; \
+	twi_regmap_t name = {0, 0, (first_reg), (count), name##_cache, name##_flags}
+
+//sets up a map, every register starts as not cached
+//cache and flags can be 0 when the map was made with TWI_REGMAP_DEFINE
+void twi_regmap_init(twi_regmap_t *map, TWI_t *twi, uint8_t addr, uint8_t *cache, uint8_t *flags);
+
+//marks count registers starting at reg as volatile
+//volatile registers are never cached, reads and writes always go to the device
+//a dirty register is written first, on an error it stays dirty and the error is returned
+uint8_t twi_regmap_set_volatile(twi_regmap_t *map, uint8_t reg, uint8_t count);
+
+//forgets every cached value, dirty registers are dropped
+//use it after the device has been reset
+void twi_regmap_invalidate(twi_regmap_t *map);
+
+//reads a register, from the cache when it holds a value
+uint8_t twi_regmap_read(twi_regmap_t *map, uint8_t reg, uint8_t *data);
+
+//writes a register in the cache, it is send to the device by twi_regmap_flush
+//nothing is send when the value did not change
+//volatile registers and registers outside the map are written right away
+uint8_t twi_regmap_write(twi_regmap_t *map, uint8_t reg, uint8_t data);
+
+//read-modify-write: only the bits in mask are changed to the bits in val
+uint8_t twi_regmap_update_bits(twi_regmap_t *map, uint8_t reg, uint8_t mask, uint8_t val);
+
+//sends every dirty register, neighbouring dirty registers are send in one burst
+uint8_t twi_regmap_flush(twi_regmap_t *map);
+
+
+#endif /* TWI_REGMAP_H_ */
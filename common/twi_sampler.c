@@ -0,0 +1,146 @@
+/*
+ * File twi_sampler.c
+ * Author: Tycho Jöbsis
+ * Date: 16-10-2026
+ */ 
+
+/*
+*	MIT License
+*
+*	Copyright (c) 2021 TychoJ
+*
+*	Permission is hereby granted, free of charge, to any person obtaining a copy
+*	of this software and associated documentation files (the "Software"), to deal
+*	in the Software without restriction, including without limitation the rights
+*	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*	copies of the Software, and to permit persons to whom the Software is
+*	furnished to do so, subject to the following conditions:
+*
+*	The above copyright notice and this permission notice shall be included in all
+*	copies or substantial portions of the Software.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*	SOFTWARE.
+*/
+
+#include <avr/io.h>
+#include "twi.h"
+#include "twi_async.h"
+#include "twi_sampler.h"
+
+//keeps the compiler from moving the sample copy past the index update
+#define MEMORY_BARRIER()	__asm__ __volatile__("" ::: "memory")
+
+//called from the TWI interrupt, the only writer of head
+static void sample_done(twi_transaction_t *t){
+	twi_sample_source_t *src = (twi_sample_source_t *)t;
+	twi_sampler_t *s = src->sampler;
+	uint8_t head = s->head;
+	uint8_t next = (head + 1) & s->mask;
+	twi_sample_t *sample;
+	uint8_t i;
+	
+	if(t->status != TWI_STATUS_OK){
+		s->errors++;
+		return;
+	}
+	
+	if(next == s->tail){
+		s->overruns++;
+		return;
+	}
+	
+	sample = &s->ring[head];
+	sample->time = src->time;
+	sample->id = src->id;
+	sample->len = src->len;
+	for(i = 0; i < src->len; i++) sample->data[i] = src->buf[i];
+	
+	MEMORY_BARRIER();
+	s->head = next;
+}
+
+void twi_sampler_init(twi_sampler_t *s, twi_async_bus_t *bus, twi_sample_t *ring, uint8_t size){
+	s->bus = bus;
+	s->sources = 0;
+	s->ring = ring;
+	s->timer = 0;
+	s->mask = size - 1;
+	s->head = 0;
+	s->tail = 0;
+	s->ticks = 0;
+	s->overruns = 0;
+	s->missed = 0;
+	s->errors = 0;
+}
+
+uint8_t twi_sampler_add(twi_sampler_t *s, twi_sample_source_t *src, uint8_t addr, uint8_t reg, uint8_t len, uint16_t period, uint8_t id){
+	//the countdown would never reach 0 again
+	if(period == 0) return TWI_OUT_OF_RANGE;
+	
+	src->sampler = s;
+	src->addr = addr;
+	src->reg = reg;
+	src->len = (len > TWI_SAMPLE_MAX_LEN) ? TWI_SAMPLE_MAX_LEN : len;
+	src->id = id;
+	src->period = period;
+	src->countdown = period;
+	src->t.status = TWI_STATUS_OK;
+	
+	src->next = s->sources;
+	s->sources = src;
+	return TWI_STATUS_OK;
+}
+
+uint8_t twi_sampler_timer(twi_sampler_t *s, TWI_TIMER_t *tc, uint16_t period){
+	if(period == 0) return TWI_OUT_OF_RANGE;
+	
+	s->timer = tc;
+	twi_regs_tick_start(tc, period);
+	return TWI_STATUS_OK;
+}
+
+void twi_sampler_tick(twi_sampler_t *s){
+	twi_sample_source_t *src;
+	uint16_t now = ++s->ticks;
+	
+	if(s->timer != 0) twi_regs_tick_clear(s->timer);
+	
+	for(src = s->sources; src != 0; src = src->next){
+		if(--src->countdown != 0) continue;
+		src->countdown = src->period;
+		
+		//the previous read has not finished, skip this one
+		if(src->t.status == TWI_BUSY){
+			s->missed++;
+			continue;
+		}
+		
+		src->time = now;
+		twi_async_prepare_bulk(&src->t, src->addr, &src->reg, 1, src->buf, src->len, READ, sample_done);
+		twi_async_submit(s->bus, &src->t);
+	}
+}
+
+uint8_t twi_sampler_read(twi_sampler_t *s, twi_sample_t *samples, uint8_t max){
+	uint8_t tail = s->tail;
+	uint8_t head = s->head;
+	uint8_t n = 0;
+	
+	MEMORY_BARRIER();
+	
+	while( (tail != head) && (n < max) ){
+		samples[n++] = s->ring[tail];
+		tail = (tail + 1) & s->mask;
+	}
+	
+	MEMORY_BARRIER();
+	s->tail = tail;
+	
+	return n;
+}
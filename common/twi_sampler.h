@@ -0,0 +1,113 @@
+/*
+ * File twi_sampler.h
+ * Author: Tycho Jöbsis
+ * Date: 16-10-2026
+ */ 
+
+/*
+*	MIT License
+*
+*	Copyright (c) 2021 TychoJ
+*
+*	Permission is hereby granted, free of charge, to any person obtaining a copy
+*	of this software and associated documentation files (the "Software"), to deal
+*	in the Software without restriction, including without limitation the rights
+*	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*	copies of the Software, and to permit persons to whom the Software is
+*	furnished to do so, subject to the following conditions:
+*
+*	The above copyright notice and this permission notice shall be included in all
+*	copies or substantial portions of the Software.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*	SOFTWARE.
+*/
+
+
+#include <avr/io.h>
+#include "twi.h"
+#include "twi_async.h"
+
+#ifndef TWI_SAMPLER_H_
+#define TWI_SAMPLER_H_
+
+//most bytes one sample can hold
+#ifndef TWI_SAMPLE_MAX_LEN
+#define TWI_SAMPLE_MAX_LEN 6
+#endif
+
+//one sample in the ring buffer
+//time is the tick at which the read was started
+typedef struct twi_sample {
+	uint16_t time;
+	uint8_t id;
+	uint8_t len;
+	uint8_t data[TWI_SAMPLE_MAX_LEN];
+} twi_sample_t;
+
+struct twi_sampler;
+
+//a device register range that is read every period ticks
+//t must stay the first member, the TWI callback uses it to find the source
+typedef struct twi_sample_source {
+	twi_transaction_t t;
+	struct twi_sampler *sampler;
+	struct twi_sample_source *next;
+	uint8_t addr;
+	uint8_t reg;
+	uint8_t len;
+	uint8_t id;
+	uint16_t period;
+	uint16_t countdown;
+	uint16_t time;
+	uint8_t buf[TWI_SAMPLE_MAX_LEN];
+} twi_sample_source_t;
+
+//the TWI interrupt writes the ring (head), the main loop reads it (tail)
+//size must be a power of two, one entry is always kept free
+//overruns counts samples that were dropped because the ring was full
+//missed counts ticks where the previous read of a source was still busy
+//errors counts reads that ended without a sample (NACK, timeout, lost arbitration)
+typedef struct twi_sampler {
+	twi_async_bus_t *bus;
+	twi_sample_source_t *sources;
+	twi_sample_t *ring;
+	TWI_TIMER_t *timer;
+	uint8_t mask;
+	volatile uint8_t head;
+	volatile uint8_t tail;
+	volatile uint16_t ticks;
+	volatile uint16_t overruns;
+	volatile uint16_t missed;
+	volatile uint16_t errors;
+} twi_sampler_t;
+
+//sets up a sampler that queues its reads on bus
+//ring holds size samples, size must be a power of two up to 128
+void twi_sampler_init(twi_sampler_t *s, twi_async_bus_t *bus, twi_sample_t *ring, uint8_t size);
+
+//adds a source that reads len bytes starting at reg every period ticks
+//id is copied in every sample of this source
+//add all sources before the timer is started
+//returns 5 (TWI_STATUS_OK) or 12 (TWI_OUT_OF_RANGE) when period is 0, the source is not added then
+uint8_t twi_sampler_add(twi_sampler_t *s, twi_sample_source_t *src, uint8_t addr, uint8_t reg, uint8_t len, uint16_t period, uint8_t id);
+
+//starts a timer with an interrupt every period counts of F_CPU / TWI_TICK_DIV (twi_regs.h)
+//the interrupt of the timer must call twi_sampler_tick
+//returns 5 (TWI_STATUS_OK) or 12 (TWI_OUT_OF_RANGE) when period is 0, the timer is not started then
+uint8_t twi_sampler_timer(twi_sampler_t *s, TWI_TIMER_t *tc, uint16_t period);
+
+//must be called from the timer interrupt, queues the reads that are due and clears the flag of the timer
+void twi_sampler_tick(twi_sampler_t *s);
+
+//copies at most max samples out of the ring buffer
+//returns the number of samples copied
+uint8_t twi_sampler_read(twi_sampler_t *s, twi_sample_t *samples, uint8_t max);
+
+
+#endif /* TWI_SAMPLER_H_ */
@@ -0,0 +1,220 @@
+/*
+ * File twi_sched.c
+ * Author: Tycho Jöbsis
+ * Date: 16-10-2026
+ */ 
+
+/*
+*	MIT License
+*
+*	Copyright (c) 2021 TychoJ
+*
+*	Permission is hereby granted, free of charge, to any person obtaining a copy
+*	of this software and associated documentation files (the "Software"), to deal
+*	in the Software without restriction, including without limitation the rights
+*	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*	copies of the Software, and to permit persons to whom the Software is
+*	furnished to do so, subject to the following conditions:
+*
+*	The above copyright notice and this permission notice shall be included in all
+*	copies or substantial portions of the Software.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*	SOFTWARE.
+*/
+
+#include <avr/io.h>
+#include <util/atomic.h>
+#include "twi.h"
+#include "twi_async.h"
+#include "twi_sched.h"
+
+static void chunk_done(twi_transaction_t *t);
+
+//returns the clock of the scheduler in ticks of the deadline timer
+//it adds the ticks since the last call, so it has to be called at least once every turn of the timer
+static uint32_t sched_time(twi_sched_t *sched){
+	uint16_t now = time_TWI();
+	
+	sched->time += (uint16_t)(now - sched->last);
+	sched->last = now;
+	return sched->time;
+}
+
+//marks a job that is past its deadline, it stays marked however long it takes to finish
+static void check_deadline(twi_job_t *job, uint32_t now){
+	if( (int32_t)(now - job->deadline) > 0 ) job->missed = 1;
+}
+
+//checks the deadlines of every job that isn't finished
+//called with interrupts off or from the TWI interrupt
+static void check_deadlines(twi_sched_t *sched){
+	uint32_t now = sched_time(sched);
+	twi_job_t *job;
+	
+	if(sched->running != 0) check_deadline(sched->running, now);
+	for(job = sched->pending; job != 0; job = job->next) check_deadline(job, now);
+}
+
+//returns 1 when job a has to go before job b, an overdue job has the earliest deadline
+static uint8_t goes_first(twi_job_t *a, twi_job_t *b){
+	if(a->prio != b->prio) return a->prio < b->prio;
+	if(a->deadline != b->deadline) return (int32_t)(a->deadline - b->deadline) < 0;
+	return (int16_t)(a->seq - b->seq) < 0;
+}
+
+//puts the next chunk of the most urgent job on the bus, the bus must be free
+//called with interrupts off or from the TWI interrupt
+static void dispatch(twi_sched_t *sched){
+	twi_job_t **best = &sched->pending;
+	twi_job_t **p;
+	twi_job_t *job;
+	uint16_t len;
+	
+	if( (sched->running != 0) || (sched->pending == 0) ) return;
+	
+	check_deadlines(sched);
+	for(p = &sched->pending->next; *p != 0; p = &(*p)->next){
+		if(goes_first(*p, *best)) best = p;
+	}
+	
+	job = *best;
+	*best = job->next;
+	job->next = 0;
+	sched->running = job;
+	
+	len = job->len - job->done_len;
+	if( (job->chunk != 0) && (len > job->chunk) ) len = job->chunk;
+	
+	if(job->rw == READ) twi_async_prepare(&job->t, job->addr, job->cmd, job->cmd_len, job->buf + job->done_len, len, chunk_done);
+	else twi_async_prepare_bulk(&job->t, job->addr, job->cmd, job->cmd_len, job->buf + job->done_len, len, WRITE, chunk_done);
+	
+	twi_async_submit(sched->bus, &job->t);
+}
+
+//ends a job and reports a missed deadline
+static void finish_job(twi_sched_t *sched, twi_job_t *job, uint8_t status){
+	check_deadline(job, sched_time(sched));
+	if(job->missed) sched->missed++;
+	
+	job->status = status;
+	if(job->callback) job->callback(job);
+}
+
+//a chunk is finished, the job goes back to the queue so a more urgent job can go first
+static void chunk_done(twi_transaction_t *t){
+	twi_job_t *job = (twi_job_t *)t;	//the transaction is the first member of the job
+	twi_sched_t *sched = job->sched;
+	uint16_t n = (job->rw == READ) ? t->read_len : t->write_len;
+	uint16_t cmd;
+	
+	sched->running = 0;
+	
+	if(t->status == TWI_STATUS_OK) job->done_len += n;
+	
+	if(t->status != TWI_STATUS_OK){
+		finish_job(sched, job, t->status);
+	}
+	else if(job->done_len >= job->len){
+		finish_job(sched, job, TWI_STATUS_OK);
+	}
+	else{
+		//the address of the next chunk
+		if(job->cmd_len == 2){
+			cmd = ( (job->cmd[0] << 8) | job->cmd[1] ) + n;
+			job->cmd[0] = cmd >> 8;
+			job->cmd[1] = cmd;
+		}
+		else{
+			job->cmd[0] += n;
+		}
+		
+		job->next = sched->pending;
+		sched->pending = job;
+	}
+	
+	dispatch(sched);
+}
+
+void twi_sched_init(twi_sched_t *sched, twi_async_bus_t *bus){
+	sched->bus = bus;
+	sched->pending = 0;
+	sched->running = 0;
+	sched->seq = 0;
+	sched->missed = 0;
+	sched->time = 0;
+	sched->last = time_TWI();
+}
+
+void twi_sched_prepare(twi_job_t *job, uint8_t addr, uint16_t cmd, uint8_t cmd_len, uint8_t *buf, uint16_t len, uint8_t rw, uint16_t chunk){
+	job->addr = addr;
+	job->cmd_len = cmd_len;
+	
+	if(cmd_len == 2){
+		job->cmd[0] = cmd >> 8;
+		job->cmd[1] = cmd;
+	}
+	else{
+		job->cmd[0] = cmd;
+	}
+	
+	job->buf = buf;
+	job->len = len;
+	job->rw = rw;
+	job->chunk = chunk;
+}
+
+uint8_t twi_sched_submit(twi_sched_t *sched, twi_job_t *job, uint8_t prio, uint16_t deadline_us, twi_job_callback_t callback){
+	uint32_t ticks = ( (uint32_t)deadline_us * (F_CPU / TWI_TIMER_DIV / 1000) ) / 1000;
+	
+	//a deadline of at most half a turn leaves the other half to see that it was missed,
+	//even when nothing runs the scheduler until the job is finished
+	if(ticks > 0x7FFF){
+		job->status = TWI_OUT_OF_RANGE;
+		return TWI_OUT_OF_RANGE;
+	}
+	
+	job->sched = sched;
+	job->prio = prio;
+	job->callback = callback;
+	job->done_len = 0;
+	job->missed = 0;
+	job->status = TWI_BUSY;
+	
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE){
+		job->deadline = sched_time(sched) + ticks;
+		job->seq = sched->seq++;
+		job->next = sched->pending;
+		sched->pending = job;
+		dispatch(sched);
+	}
+	
+	return TWI_BUSY;
+}
+
+uint8_t twi_sched_done(twi_job_t *job){
+	//starts a chunk that waits for a new speed
+	if(job->status == TWI_BUSY){
+		ATOMIC_BLOCK(ATOMIC_RESTORESTATE){
+			check_deadlines(job->sched);
+		}
+		twi_async_busy(job->sched->bus);
+	}
+	return job->status != TWI_BUSY;
+}
+
+uint16_t twi_sched_missed(twi_sched_t *sched){
+	uint16_t missed;
+	
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE){
+		check_deadlines(sched);
+		missed = sched->missed;
+		sched->missed = 0;
+	}
+	return missed;
+}
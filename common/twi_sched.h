@@ -0,0 +1,114 @@
+/*
+ * File twi_sched.h
+ * Author: Tycho Jöbsis
+ * Date: 16-10-2026
+ */ 
+
+/*
+*	MIT License
+*
+*	Copyright (c) 2021 TychoJ
+*
+*	Permission is hereby granted, free of charge, to any person obtaining a copy
+*	of this software and associated documentation files (the "Software"), to deal
+*	in the Software without restriction, including without limitation the rights
+*	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*	copies of the Software, and to permit persons to whom the Software is
+*	furnished to do so, subject to the following conditions:
+*
+*	The above copyright notice and this permission notice shall be included in all
+*	copies or substantial portions of the Software.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*	SOFTWARE.
+*/
+
+#include <avr/io.h>
+#include "twi.h"
+#include "twi_async.h"
+
+#ifndef TWI_SCHED_H_
+#define TWI_SCHED_H_
+
+//longest deadline of twi_sched_submit in us, 0x7FFF ticks of the deadline timer
+//8191 us at 32 MHz on the Xmega (clk/8) and 3276 us at 20 MHz on the tinyAVR (clk/2)
+//the scheduler counts the turns of the timer, it has to run at least once every turn (16.4 ms and 6.5 ms) while jobs are queued:
+//a finished chunk, a call of twi_sched_submit, twi_sched_done or twi_sched_missed
+#define TWI_SCHED_DEADLINE_MAX_US	( (0x7FFFUL * 1000UL) / (F_CPU / TWI_TIMER_DIV / 1000UL) )
+
+//priority classes, a lower class always goes first
+#define TWI_PRIO_CRITICAL	0
+#define TWI_PRIO_NORMAL		1
+#define TWI_PRIO_BULK		2
+
+struct twi_job;
+struct twi_sched;
+
+//called when a job is finished, from the TWI interrupt or twi_async_poll
+typedef void (*twi_job_callback_t)(struct twi_job *job);
+
+//a transfer handed to the scheduler, owned by the caller until status is no longer TWI_BUSY
+//cmd (a register or memory address, MSB first) is send in front of every chunk and goes up by the bytes done
+//status is TWI_STATUS_OK, NACK, TWI_ARB_LOST, TWI_BUS_ERROR, DATA_NOT_SEND or DATA_NOT_RECEIVED when finished
+//missed is 1 when the job is past its deadline, it is set while the job waits or runs
+typedef struct twi_job {
+	twi_transaction_t t;	//the chunk that is on the bus
+	struct twi_sched *sched;
+	uint8_t addr;
+	uint8_t cmd[2];
+	uint8_t cmd_len;
+	uint8_t *buf;
+	uint16_t len;
+	uint16_t done_len;
+	uint16_t chunk;
+	uint8_t rw;
+	uint8_t prio;
+	uint32_t deadline;		//on the clock of the scheduler
+	uint16_t seq;			//order of submission, the first of two equal jobs goes first
+	twi_job_callback_t callback;
+	volatile uint8_t status;
+	volatile uint8_t missed;
+	struct twi_job *next;
+} twi_job_t;
+
+//orders the jobs of one bus by priority class and then by earliest deadline
+//only one chunk is on the bus at a time, so a critical job waits at most for one chunk of a bulk job
+typedef struct twi_sched {
+	twi_async_bus_t *bus;
+	twi_job_t *pending;
+	twi_job_t *running;
+	uint16_t seq;
+	volatile uint16_t missed;
+	uint32_t time;			//ticks of the deadline timer since twi_sched_init
+	uint16_t last;			//count of the timer when time was updated
+} twi_sched_t;
+
+//sets up a scheduler for a bus of twi_async_init, every transaction of the bus must go through it
+void twi_sched_init(twi_sched_t *sched, twi_async_bus_t *bus);
+
+//fills in a job
+//cmd_len is 0, 1 or 2 bytes of cmd, the register or memory address
+//rw is WRITE (buf is send after cmd) or READ (cmd is send, then buf is read after a repeated start)
+//chunk is the most bytes in one transaction, 0 for no limit
+//the device must increase its address by itself, the next chunk follows right after the stop of the last one
+void twi_sched_prepare(twi_job_t *job, uint8_t addr, uint16_t cmd, uint8_t cmd_len, uint8_t *buf, uint16_t len, uint8_t rw, uint16_t chunk);
+
+//queues a job with its priority class and a deadline in us from now, measured with the deadline timer
+//jobs with the same class and deadline are done in the order they were submitted
+//without a deadline timer the deadline is only used to order the jobs of a class and is never missed
+//returns TWI_BUSY, or TWI_OUT_OF_RANGE when deadline_us is above TWI_SCHED_DEADLINE_MAX_US, the job is not queued then
+uint8_t twi_sched_submit(twi_sched_t *sched, twi_job_t *job, uint8_t prio, uint16_t deadline_us, twi_job_callback_t callback);
+
+//returns 1 when the job is finished
+uint8_t twi_sched_done(twi_job_t *job);
+
+//returns the number of jobs that finished after their deadline and starts counting again
+uint16_t twi_sched_missed(twi_sched_t *sched);
+
+
+#endif /* TWI_SCHED_H_ */
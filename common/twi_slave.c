@@ -0,0 +1,188 @@
+/*
+ * File twi_slave.c
+ * Author: Tycho Jöbsis
+ * Date: 16-10-2026
+ */ 
+
+/*
+*	MIT License
+*
+*	Copyright (c) 2021 TychoJ
+*
+*	Permission is hereby granted, free of charge, to any person obtaining a copy
+*	of this software and associated documentation files (the "Software"), to deal
+*	in the Software without restriction, including without limitation the rights
+*	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*	copies of the Software, and to permit persons to whom the Software is
+*	furnished to do so, subject to the following conditions:
+*
+*	The above copyright notice and this permission notice shall be included in all
+*	copies or substantial portions of the Software.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*	SOFTWARE.
+*/
+
+#include <avr/io.h>
+#include "twi.h"
+#include "twi_slave.h"
+
+//sets up the register file of one slave
+static void init_slave(twi_slave_t *slave, TWI_t *twi, uint8_t addr, uint8_t *regs, uint16_t size, uint8_t *wp){
+	uint16_t i;
+	
+	slave->twi = twi;
+	slave->addr = addr;
+	slave->regs = regs;
+	slave->size = size;
+	slave->wp = wp;
+	slave->commit = 0;
+	slave->ptr = 0;
+	slave->first = 0;
+	slave->count = 0;
+	slave->state = TWI_SLAVE_POINTER;
+	slave->next = 0;
+	slave->active = slave;
+	
+	if(wp != 0){
+		for(i = 0; i < ((size + 7) / 8); i++) wp[i] = 0;
+	}
+}
+
+void twi_slave_init(twi_slave_t *slave, TWI_t *twi, uint8_t addr, uint8_t *regs, uint16_t size, uint8_t *wp, uint8_t intlvl){
+	init_slave(slave, twi, addr, regs, size, wp);
+	
+	TWI_S_ADDR(twi) = addr << 1;
+	TWI_S_ADDRMASK(twi) = 0;
+	twi_regs_enable_slave(twi, intlvl);
+}
+
+void twi_slave_add(twi_slave_t *first, twi_slave_t *slave, uint8_t addr, uint8_t *regs, uint16_t size, uint8_t *wp){
+	twi_slave_t *s = first;
+	uint8_t mask = 0;
+	
+	init_slave(slave, first->twi, addr, regs, size, wp);
+	
+	while(s->next != 0) s = s->next;
+	s->next = slave;
+	
+	//two addresses fit in the address and the second address
+	if(first->next->next == 0){
+		TWI_S_ADDRMASK(first->twi) = (addr << 1) | TWI_S_ADDREN_bm;
+		return;
+	}
+	
+	//the mask ignores every bit in which the addresses differ from the first one
+	for(s = first->next; s != 0; s = s->next) mask |= s->addr ^ first->addr;
+	TWI_S_ADDRMASK(first->twi) = mask << 1;
+}
+
+void twi_slave_protect(twi_slave_t *slave, uint8_t reg, uint8_t count){
+	uint16_t r;
+	
+	if(slave->wp == 0) return;
+	
+	for(r = reg; (r < (uint16_t)(reg + count)) && (r < slave->size); r++){
+		slave->wp[r >> 3] |= 1 << (r & 7);
+	}
+}
+
+void twi_slave_set_commit(twi_slave_t *slave, twi_slave_commit_t commit){
+	slave->commit = commit;
+}
+
+void twi_slave_disable(twi_slave_t *slave){
+	TWI_S_CTRL(slave->twi) = 0;
+}
+
+//ends a transaction at a stop or repeated start, the commit function sees the written registers
+static void end_transaction(twi_slave_t *slave){
+	if( (slave->state == TWI_SLAVE_WRITE) && (slave->count != 0) && (slave->commit != 0) ){
+		slave->commit(slave, slave->first, slave->count);
+	}
+	
+	slave->count = 0;
+	slave->state = TWI_SLAVE_POINTER;
+}
+
+void twi_slave_isr(twi_slave_t *first){
+	TWI_t *twi = first->twi;
+	twi_slave_t *slave = first->active;
+	uint8_t status = TWI_S_STATUS(twi);
+	uint8_t ptr;
+	uint8_t data;
+	
+	if(status & (TWI_S_COLL_bm | TWI_S_BUSERR_bm)){
+		TWI_S_STATUS(twi) = TWI_S_COLL_bm | TWI_S_BUSERR_bm;
+		slave->count = 0;
+		slave->state = TWI_SLAVE_POINTER;
+		TWI_S_CMD(twi) = TWI_S_CMD_COMPTRANS_gc;
+		return;
+	}
+	
+	if(status & TWI_S_APIF_bm){
+		//a repeated start ends the transaction before it like a stop
+		end_transaction(slave);
+		
+		if( !(status & TWI_S_AP_bm) ){
+			TWI_S_CMD(twi) = TWI_S_CMD_COMPTRANS_gc;	//stop
+			return;
+		}
+		
+		//DATA holds the received address, the slave with that address handles the whole transaction
+		data = TWI_S_DATA(twi) >> 1;
+		for(slave = first; (slave != 0) && (slave->addr != data); slave = slave->next);
+		
+		if(slave == 0){
+			TWI_S_CMD(twi) = TWI_S_ACKACT_bm | TWI_S_CMD_RESPONSE_gc;	//matched by the mask only, NACK
+			return;
+		}
+		
+		first->active = slave;
+		if(status & TWI_S_DIR_bm) slave->state = TWI_SLAVE_READ;
+		TWI_S_CMD(twi) = TWI_S_CMD_RESPONSE_gc;	//ACK the address
+		return;
+	}
+	
+	if( !(status & TWI_S_DIF_bm) ) return;
+	
+	ptr = slave->ptr;
+	
+	if(status & TWI_S_DIR_bm){
+		//the master NACKed the last byte, it doesn't want more
+		if( (slave->count != 0) && (status & TWI_S_RXACK_bm) ){
+			TWI_S_CMD(twi) = TWI_S_CMD_COMPTRANS_gc;
+			return;
+		}
+		
+		//registers past the end read as 0xFF
+		TWI_S_DATA(twi) = (ptr < slave->size) ? slave->regs[ptr] : 0xFF;
+		slave->ptr = ptr + 1;
+		slave->count = 1;	//only marks that a byte has been send
+		TWI_S_CMD(twi) = TWI_S_CMD_RESPONSE_gc;
+		return;
+	}
+	
+	data = TWI_S_DATA(twi);
+	
+	if(slave->state == TWI_SLAVE_POINTER){
+		slave->ptr = data;
+		slave->first = data;
+		slave->state = TWI_SLAVE_WRITE;
+	}
+	else{
+		//writes past the end and to protected registers are acknowledged and dropped
+		if( (ptr < slave->size) && ( (slave->wp == 0) || !(slave->wp[ptr >> 3] & (1 << (ptr & 7))) ) ){
+			slave->regs[ptr] = data;
+		}
+		slave->ptr = ptr + 1;
+		slave->count++;
+	}
+	
+	TWI_S_CMD(twi) = TWI_S_CMD_RESPONSE_gc;
+}
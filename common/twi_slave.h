@@ -0,0 +1,97 @@
+/*
+ * File twi_slave.h
+ * Author: Tycho Jöbsis
+ * Date: 16-10-2026
+ */ 
+
+/*
+*	MIT License
+*
+*	Copyright (c) 2021 TychoJ
+*
+*	Permission is hereby granted, free of charge, to any person obtaining a copy
+*	of this software and associated documentation files (the "Software"), to deal
+*	in the Software without restriction, including without limitation the rights
+*	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*	copies of the Software, and to permit persons to whom the Software is
+*	furnished to do so, subject to the following conditions:
+*
+*	The above copyright notice and this permission notice shall be included in all
+*	copies or substantial portions of the Software.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*	SOFTWARE.
+*/
+
+#include <avr/io.h>
+#include "twi.h"
+
+#ifndef TWI_SLAVE_H_
+#define TWI_SLAVE_H_
+
+//what the slave expects next
+#define TWI_SLAVE_POINTER	0	//the register pointer, first byte of a write
+#define TWI_SLAVE_WRITE		1	//data for the register file
+#define TWI_SLAVE_READ		2	//the master reads
+
+typedef struct twi_slave twi_slave_t;
+
+//called from the slave interrupt after a transaction that wrote count registers starting at first
+//count includes write protected registers, they are acknowledged but not changed
+typedef void (*twi_slave_commit_t)(twi_slave_t *slave, uint8_t first, uint8_t count);
+
+//a TWI slave that shows a piece of memory as its registers
+//the first byte of a write sets the register pointer, it goes up by one for every byte after that
+//reads are served from and writes go straight into the memory, nothing is copied
+//more slaves with their own address can be added to one module with twi_slave_add
+struct twi_slave {
+	TWI_t *twi;
+	uint8_t addr;
+	uint8_t *regs;
+	uint16_t size;
+	uint8_t *wp;
+	twi_slave_commit_t commit;
+	uint8_t ptr;
+	uint8_t first;
+	uint8_t count;
+	uint8_t state;
+	twi_slave_t *next;		//next slave on the same module
+	twi_slave_t *active;	//slave of the running transaction, kept in the first slave
+};
+
+//defines the slave interrupt of a module
+//example: TWI_SLAVE_ISR(TWIE, sensor)
+#define TWI_SLAVE_ISR(module, slave)	ISR(module##_TWIS_vect){ twi_slave_isr(&(slave)); }
+
+//enables the slave of a TWI module at the 7 bit address addr
+//regs is the memory of the register file, size its length up to 256 registers
+//wp holds a write protect bit for every register ((size + 7) / 8 bytes) or is 0 when nothing is protected
+//intlvl is one of the TWI_INTLVL_xx values, interrupts still have to be enabled with sei()
+void twi_slave_init(twi_slave_t *slave, TWI_t *twi, uint8_t addr, uint8_t *regs, uint16_t size, uint8_t *wp, uint8_t intlvl);
+
+//lets the module of first also answer addr with the register file of slave
+//slave has its own register pointer, write protection and commit function
+//with two addresses the second address of the module is used, with more the address mask
+//the mask can match addresses that are not added, they are not acknowledged
+void twi_slave_add(twi_slave_t *first, twi_slave_t *slave, uint8_t addr, uint8_t *regs, uint16_t size, uint8_t *wp);
+
+//write protects count registers starting at reg, the master can still read them
+//needs the wp memory of twi_slave_init
+void twi_slave_protect(twi_slave_t *slave, uint8_t reg, uint8_t count);
+
+//sets the function that is called after every transaction that wrote registers, 0 for none
+void twi_slave_set_commit(twi_slave_t *slave, twi_slave_commit_t commit);
+
+//turns the slave off
+void twi_slave_disable(twi_slave_t *slave);
+
+//state machine, must be called from the slave interrupt of the module with the slave of twi_slave_init
+void twi_slave_isr(twi_slave_t *first);
+
+
+#endif /* TWI_SLAVE_H_ */
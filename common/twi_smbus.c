@@ -0,0 +1,286 @@
+/*
+ * File twi_smbus.c
+ * Author: Tycho Jöbsis
+ * Date: 16-10-2026
+ */ 
+
+/*
+*	MIT License
+*
+*	Copyright (c) 2021 TychoJ
+*
+*	Permission is hereby granted, free of charge, to any person obtaining a copy
+*	of this software and associated documentation files (the "Software"), to deal
+*	in the Software without restriction, including without limitation the rights
+*	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*	copies of the Software, and to permit persons to whom the Software is
+*	furnished to do so, subject to the following conditions:
+*
+*	The above copyright notice and this permission notice shall be included in all
+*	copies or substantial portions of the Software.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*	SOFTWARE.
+*/
+
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+#include "twi.h"
+#include "twi_smbus.h"
+#ifdef TWI_ASYNC
+#include "twi_async.h"
+#endif
+
+//the deadline of the blocking functions is at most 65535 us
+#if TWI_SMBUS_TIMEOUT_US > 65535
+#error "TWI_SMBUS_TIMEOUT_US is larger than the deadline can be"
+#endif
+
+#ifdef TWI_SMBUS_PEC_NIBBLE
+//CRC-8 of the high nibble, two lookups per byte
+static const uint8_t pec_table[16] PROGMEM = {
+	0x00, 0x07, 0x0E, 0x09, 0x1C, 0x1B, 0x12, 0x15, 0x38, 0x3F, 0x36, 0x31, 0x24, 0x23, 0x2A, 0x2D
+};
+
+uint8_t twi_smbus_pec(uint8_t crc, uint8_t data){
+	crc ^= data;
+	crc = (crc << 4) ^ pgm_read_byte(&pec_table[crc >> 4]);
+	crc = (crc << 4) ^ pgm_read_byte(&pec_table[crc >> 4]);
+	return crc;
+}
+#else
+//CRC-8 of every byte, one lookup per byte
+static const uint8_t pec_table[256] PROGMEM = {
+	0x00, 0x07, 0x0E, 0x09, 0x1C, 0x1B, 0x12, 0x15, 0x38, 0x3F, 0x36, 0x31, 0x24, 0x23, 0x2A, 0x2D,
+	0x70, 0x77, 0x7E, 0x79, 0x6C, 0x6B, 0x62, 0x65, 0x48, 0x4F, 0x46, 0x41, 0x54, 0x53, 0x5A, 0x5D,
+	0xE0, 0xE7, 0xEE, 0xE9, 0xFC, 0xFB, 0xF2, 0xF5, 0xD8, 0xDF, 0xD6, 0xD1, 0xC4, 0xC3, 0xCA, 0xCD,
+	0x90, 0x97, 0x9E, 0x99, 0x8C, 0x8B, 0x82, 0x85, 0xA8, 0xAF, 0xA6, 0xA1, 0xB4, 0xB3, 0xBA, 0xBD,
+	0xC7, 0xC0, 0xC9, 0xCE, 0xDB, 0xDC, 0xD5, 0xD2, 0xFF, 0xF8, 0xF1, 0xF6, 0xE3, 0xE4, 0xED, 0xEA,
+	0xB7, 0xB0, 0xB9, 0xBE, 0xAB, 0xAC, 0xA5, 0xA2, 0x8F, 0x88, 0x81, 0x86, 0x93, 0x94, 0x9D, 0x9A,
+	0x27, 0x20, 0x29, 0x2E, 0x3B, 0x3C, 0x35, 0x32, 0x1F, 0x18, 0x11, 0x16, 0x03, 0x04, 0x0D, 0x0A,
+	0x57, 0x50, 0x59, 0x5E, 0x4B, 0x4C, 0x45, 0x42, 0x6F, 0x68, 0x61, 0x66, 0x73, 0x74, 0x7D, 0x7A,
+	0x89, 0x8E, 0x87, 0x80, 0x95, 0x92, 0x9B, 0x9C, 0xB1, 0xB6, 0xBF, 0xB8, 0xAD, 0xAA, 0xA3, 0xA4,
+	0xF9, 0xFE, 0xF7, 0xF0, 0xE5, 0xE2, 0xEB, 0xEC, 0xC1, 0xC6, 0xCF, 0xC8, 0xDD, 0xDA, 0xD3, 0xD4,
+	0x69, 0x6E, 0x67, 0x60, 0x75, 0x72, 0x7B, 0x7C, 0x51, 0x56, 0x5F, 0x58, 0x4D, 0x4A, 0x43, 0x44,
+	0x19, 0x1E, 0x17, 0x10, 0x05, 0x02, 0x0B, 0x0C, 0x21, 0x26, 0x2F, 0x28, 0x3D, 0x3A, 0x33, 0x34,
+	0x4E, 0x49, 0x40, 0x47, 0x52, 0x55, 0x5C, 0x5B, 0x76, 0x71, 0x78, 0x7F, 0x6A, 0x6D, 0x64, 0x63,
+	0x3E, 0x39, 0x30, 0x37, 0x22, 0x25, 0x2C, 0x2B, 0x06, 0x01, 0x08, 0x0F, 0x1A, 0x1D, 0x14, 0x13,
+	0xAE, 0xA9, 0xA0, 0xA7, 0xB2, 0xB5, 0xBC, 0xBB, 0x96, 0x91, 0x98, 0x9F, 0x8A, 0x8D, 0x84, 0x83,
+	0xDE, 0xD9, 0xD0, 0xD7, 0xC2, 0xC5, 0xCC, 0xCB, 0xE6, 0xE1, 0xE8, 0xEF, 0xFA, 0xFD, 0xF4, 0xF3
+};
+
+uint8_t twi_smbus_pec(uint8_t crc, uint8_t data){
+	return pgm_read_byte(&pec_table[crc ^ data]);
+}
+#endif
+
+void twi_smbus_init(twi_smbus_t *dev, TWI_t *twi, uint8_t addr, uint8_t pec){
+	dev->twi = twi;
+	dev->addr = addr;
+	dev->pec = pec;
+}
+
+void twi_smbus_set_pec(twi_smbus_t *dev, uint8_t pec){
+	dev->pec = pec;
+}
+
+//sends one byte and adds it to the PEC
+//a byte that isn't acknowledged or doesn't get out before the deadline ends the transfer
+static uint8_t smbus_send(TWI_t *twi, uint8_t data, uint8_t *crc){
+	uint8_t err = send_TWI(twi, data);
+	
+	if(err == ACK){
+		*crc = twi_smbus_pec(*crc, data);
+		return ACK;
+	}
+	
+	//after a lost arbitration or a bus error the bus isn't ours anymore
+	if( (err == NACK) || (err == DATA_NOT_SEND) ) stop_TWI(twi);
+	return (err == NACK) ? DATA_NOT_SEND : err;
+}
+
+//receives one byte and adds it to the PEC, the last byte is not acknowledged and ends the transfer
+static uint8_t smbus_read(TWI_t *twi, uint8_t *data, uint8_t last, uint8_t *crc){
+	if(read_TWI(twi, data, last ? NACK : ACK) != TWI_STATUS_OK){
+		stop_TWI(twi);
+		return DATA_NOT_RECEIVED;
+	}
+	
+	*crc = twi_smbus_pec(*crc, *data);
+	return TWI_STATUS_OK;
+}
+
+//one SMBus transfer
+//head and data are written after the address, when in is not 0 a repeated start follows and in is read
+//with block set the first byte read is the byte count, otherwise *in_len bytes are read
+//without anything to write the transfer starts with the read address (receive byte)
+static uint8_t smbus_transfer(twi_smbus_t *dev, const uint8_t *head, uint8_t head_len, const uint8_t *data, uint8_t len, uint8_t *in, uint8_t *in_len, uint8_t block){
+	TWI_t *twi = dev->twi;
+	uint8_t crc = 0;
+	uint8_t n = 0;
+	uint8_t b;
+	uint8_t err;
+	uint8_t i;
+	
+	if( (head_len != 0) || (in == 0) ){
+		err = start_TWI(twi, dev->addr, WRITE);
+		if(err != ACK) return err;
+		crc = twi_smbus_pec(crc, dev->addr << 1);
+		
+		for(i = 0; i < head_len; i++){
+			err = smbus_send(twi, head[i], &crc);
+			if(err != ACK) return err;
+		}
+		
+		for(i = 0; i < len; i++){
+			err = smbus_send(twi, data[i], &crc);
+			if(err != ACK) return err;
+		}
+		
+		if(in == 0){
+			if(dev->pec){
+				err = smbus_send(twi, crc, &crc);
+				if(err != ACK) return err;
+			}
+			stop_TWI(twi);
+			return TWI_STATUS_OK;
+		}
+		
+		err = repeated_start_TWI(twi, dev->addr, READ);
+		if(err == DATA_NOT_SEND) stop_TWI(twi);
+	}
+	else err = start_TWI(twi, dev->addr, READ);
+	
+	if(err != ACK) return err;
+	crc = twi_smbus_pec(crc, (dev->addr << 1) | READ);
+	
+	n = *in_len;
+	if(block){
+		//the byte count is always followed by data or the PEC
+		err = smbus_read(twi, &b, 0, &crc);
+		if(err != TWI_STATUS_OK) return err;
+		
+		if( (b == 0) || (b > n) ){
+			smbus_read(twi, &b, 1, &crc);
+			return TWI_OUT_OF_RANGE;
+		}
+		n = b;
+		*in_len = n;
+	}
+	
+	for(i = 0; i < n; i++){
+		err = smbus_read(twi, &in[i], (i == n - 1) && !dev->pec, &crc);
+		if(err != TWI_STATUS_OK) return err;
+	}
+	
+	//the PEC of the device, received without adding it
+	if(dev->pec){
+		if(read_TWI(twi, &b, NACK) != TWI_STATUS_OK){
+			stop_TWI(twi);
+			return DATA_NOT_RECEIVED;
+		}
+		if(b != crc) return TWI_PEC_ERROR;
+	}
+	
+	return TWI_STATUS_OK;
+}
+
+//runs a transfer with the SMBus timeout as the deadline of every byte
+//on a module of the interrupt engine the whole transfer is claimed, so queued transactions wait
+//and a transfer that ends without a stop (lost arbitration, bus error) still gives the module back
+static uint8_t smbus_run(twi_smbus_t *dev, const uint8_t *head, uint8_t head_len, const uint8_t *data, uint8_t len, uint8_t *in, uint8_t *in_len, uint8_t block){
+	uint16_t deadline = get_deadline_TWI();
+	uint8_t err;
+	
+	set_deadline_TWI(TWI_SMBUS_TIMEOUT_US);
+#ifdef TWI_ASYNC
+	twi_async_claim(dev->twi);
+#endif
+	err = smbus_transfer(dev, head, head_len, data, len, in, in_len, block);
+#ifdef TWI_ASYNC
+	twi_async_release(dev->twi);
+#endif
+	set_deadline_TWI(deadline);
+	return err;
+}
+
+uint8_t twi_smbus_send_byte(twi_smbus_t *dev, uint8_t data){
+	return smbus_run(dev, &data, 1, 0, 0, 0, 0, 0);
+}
+
+uint8_t twi_smbus_receive_byte(twi_smbus_t *dev, uint8_t *data){
+	uint8_t n = 1;
+	
+	return smbus_run(dev, 0, 0, 0, 0, data, &n, 0);
+}
+
+uint8_t twi_smbus_write_byte(twi_smbus_t *dev, uint8_t cmd, uint8_t data){
+	uint8_t head[2] = {cmd, data};
+	
+	return smbus_run(dev, head, 2, 0, 0, 0, 0, 0);
+}
+
+uint8_t twi_smbus_write_word(twi_smbus_t *dev, uint8_t cmd, uint16_t data){
+	uint8_t head[3] = {cmd, data, data >> 8};
+	
+	return smbus_run(dev, head, 3, 0, 0, 0, 0, 0);
+}
+
+uint8_t twi_smbus_read_byte(twi_smbus_t *dev, uint8_t cmd, uint8_t *data){
+	uint8_t n = 1;
+	
+	return smbus_run(dev, &cmd, 1, 0, 0, data, &n, 0);
+}
+
+uint8_t twi_smbus_read_word(twi_smbus_t *dev, uint8_t cmd, uint16_t *data){
+	uint8_t in[2];
+	uint8_t n = 2;
+	uint8_t err = smbus_run(dev, &cmd, 1, 0, 0, in, &n, 0);
+	
+	if(err == TWI_STATUS_OK) *data = in[0] | (in[1] << 8);
+	return err;
+}
+
+uint8_t twi_smbus_process_call(twi_smbus_t *dev, uint8_t cmd, uint16_t data, uint16_t *answer){
+	uint8_t head[3] = {cmd, data, data >> 8};
+	uint8_t in[2];
+	uint8_t n = 2;
+	uint8_t err = smbus_run(dev, head, 3, 0, 0, in, &n, 0);
+	
+	if(err == TWI_STATUS_OK) *answer = in[0] | (in[1] << 8);
+	return err;
+}
+
+uint8_t twi_smbus_block_write(twi_smbus_t *dev, uint8_t cmd, const uint8_t *data, uint8_t len){
+	uint8_t head[2] = {cmd, len};
+	
+	if( (len == 0) || (len > TWI_SMBUS_BLOCK_MAX) ) return TWI_OUT_OF_RANGE;
+	return smbus_run(dev, head, 2, data, len, 0, 0, 0);
+}
+
+uint8_t twi_smbus_block_read(twi_smbus_t *dev, uint8_t cmd, uint8_t *data, uint8_t max, uint8_t *len){
+	uint8_t err;
+	
+	*len = max;
+	err = smbus_run(dev, &cmd, 1, 0, 0, data, len, 1);
+	if(err != TWI_STATUS_OK) *len = 0;
+	return err;
+}
+
+uint8_t twi_smbus_block_process_call(twi_smbus_t *dev, uint8_t cmd, const uint8_t *out, uint8_t out_len, uint8_t *in, uint8_t max, uint8_t *in_len){
+	uint8_t head[2] = {cmd, out_len};
+	uint8_t err;
+	
+	*in_len = 0;
+	if( (out_len == 0) || (out_len > TWI_SMBUS_BLOCK_MAX) ) return TWI_OUT_OF_RANGE;
+	
+	*in_len = max;
+	err = smbus_run(dev, head, 2, out, out_len, in, in_len, 1);
+	if(err != TWI_STATUS_OK) *in_len = 0;
+	return err;
+}
@@ -0,0 +1,114 @@
+/*
+ * File twi_smbus.h
+ * Author: Tycho Jöbsis
+ * Date: 16-10-2026
+ */ 
+
+/*
+*	MIT License
+*
+*	Copyright (c) 2021 TychoJ
+*
+*	Permission is hereby granted, free of charge, to any person obtaining a copy
+*	of this software and associated documentation files (the "Software"), to deal
+*	in the Software without restriction, including without limitation the rights
+*	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*	copies of the Software, and to permit persons to whom the Software is
+*	furnished to do so, subject to the following conditions:
+*
+*	The above copyright notice and this permission notice shall be included in all
+*	copies or substantial portions of the Software.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*	SOFTWARE.
+*/
+
+#include <avr/io.h>
+#include "twi.h"
+
+#ifndef TWI_SMBUS_H_
+#define TWI_SMBUS_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//time in us a slave may hold the clock low before a transfer is given up (tTIMEOUT)
+//the slaves reset their interface after 25 to 35 ms, so the next transfer finds them idle again
+//at most 65535, the largest deadline of the blocking functions
+#ifndef TWI_SMBUS_TIMEOUT_US
+#define TWI_SMBUS_TIMEOUT_US 25000
+#endif
+
+//largest block, 32 for SMBus 2.0, up to 255 for SMBus 3.0
+#ifndef TWI_SMBUS_BLOCK_MAX
+#define TWI_SMBUS_BLOCK_MAX 32
+#endif
+
+//define TWI_SMBUS_PEC_NIBBLE to calculate the PEC with a 16 byte table instead of a 256 byte table
+//it costs two table lookups per byte instead of one
+
+//on a module registered with twi_async_init build twi.c and twi_smbus.c with TWI_ASYNC,
+//every transfer then waits for the queue of the module and the queue waits for the transfer
+
+//an SMBus or PMBus device
+typedef struct {
+	TWI_t *twi;
+	uint8_t addr;
+	uint8_t pec;		//1 when every transfer ends with a packet error code
+} twi_smbus_t;
+
+//sets up a device
+//addr is the 7 bit address, pec is 1 when the device checks and sends a PEC byte
+//example: twi_smbus_init(&psu, &TWIE, 0x58, 1);
+void twi_smbus_init(twi_smbus_t *dev, TWI_t *twi, uint8_t addr, uint8_t pec);
+
+//turns the PEC of the device on (1) or off (0)
+void twi_smbus_set_pec(twi_smbus_t *dev, uint8_t pec);
+
+//adds one byte to a PEC (CRC-8, polynomial x^8 + x^2 + x + 1), start with 0
+uint8_t twi_smbus_pec(uint8_t crc, uint8_t data);
+
+//all transfers return 5 (TWI_STATUS_OK), 0 (NACK), 10 (DATA_NOT_SEND), 7 (DATA_NOT_RECEIVED),
+//13 (TWI_PEC_ERROR) when the PEC of the device doesn't match or an error of start_TWI
+//the PEC is calculated while the bytes are send and received, the address bytes are included
+
+//send byte: one byte without a command code
+uint8_t twi_smbus_send_byte(twi_smbus_t *dev, uint8_t data);
+
+//receive byte: one byte without a command code
+uint8_t twi_smbus_receive_byte(twi_smbus_t *dev, uint8_t *data);
+
+//write byte and write word, the word is send LSB first
+uint8_t twi_smbus_write_byte(twi_smbus_t *dev, uint8_t cmd, uint8_t data);
+uint8_t twi_smbus_write_word(twi_smbus_t *dev, uint8_t cmd, uint16_t data);
+
+//read byte and read word, the word is received LSB first
+uint8_t twi_smbus_read_byte(twi_smbus_t *dev, uint8_t cmd, uint8_t *data);
+uint8_t twi_smbus_read_word(twi_smbus_t *dev, uint8_t cmd, uint16_t *data);
+
+//process call: writes a word and reads the answer word in one transfer
+uint8_t twi_smbus_process_call(twi_smbus_t *dev, uint8_t cmd, uint16_t data, uint16_t *answer);
+
+//block write: sends the byte count and then len bytes
+//returns 12 (TWI_OUT_OF_RANGE) when len is 0 or larger than TWI_SMBUS_BLOCK_MAX
+uint8_t twi_smbus_block_write(twi_smbus_t *dev, uint8_t cmd, const uint8_t *data, uint8_t len);
+
+//block read: the first byte received is the byte count, it sets the length of the rest of the transfer
+//max is the size of data, *len is set to the number of bytes received
+//returns 12 (TWI_OUT_OF_RANGE) when the device sends a count of 0 or larger than max, the transfer is ended after one more byte
+uint8_t twi_smbus_block_read(twi_smbus_t *dev, uint8_t cmd, uint8_t *data, uint8_t max, uint8_t *len);
+
+//block write-block read process call: sends a block and reads the answer block in one transfer
+uint8_t twi_smbus_block_process_call(twi_smbus_t *dev, uint8_t cmd, const uint8_t *out, uint8_t out_len, uint8_t *in, uint8_t max, uint8_t *in_len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TWI_SMBUS_H_ */
@@ -0,0 +1,160 @@
+/*
+ * File twi_stats.c
+ * Author: Tycho Jöbsis
+ * Date: 16-10-2026
+ */ 
+
+/*
+*	MIT License
+*
+*	Copyright (c) 2021 TychoJ
+*
+*	Permission is hereby granted, free of charge, to any person obtaining a copy
+*	of this software and associated documentation files (the "Software"), to deal
+*	in the Software without restriction, including without limitation the rights
+*	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*	copies of the Software, and to permit persons to whom the Software is
+*	furnished to do so, subject to the following conditions:
+*
+*	The above copyright notice and this permission notice shall be included in all
+*	copies or substantial portions of the Software.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*	SOFTWARE.
+*/
+
+#include <avr/io.h>
+#include <string.h>
+#include "twi.h"
+#include "twi_stats.h"
+
+static twi_stats_t stats[TWI_STATS_MAX_BUSES];
+
+//returns the histogram bucket of a value
+static uint8_t bucket(uint16_t value){
+	uint8_t n = 0;
+	
+	while(value){
+		value >>= 1;
+		n++;
+	}
+	return n;
+}
+
+twi_stats_t *twi_stats_get(TWI_t *twi){
+	uint8_t i;
+	
+	for(i = 0; i < TWI_STATS_MAX_BUSES; i++){
+		if(stats[i].twi == twi) return &stats[i];
+		
+		if(stats[i].twi == 0){
+			stats[i].twi = twi;
+			return &stats[i];
+		}
+	}
+	return 0;
+}
+
+void twi_stats_reset(TWI_t *twi){
+	twi_stats_t *s = twi_stats_get(twi);
+	
+	if(s == 0) return;
+	
+	memset(s, 0, sizeof(twi_stats_t));
+	s->twi = twi;
+}
+
+void twi_stats_start(TWI_t *twi){
+	twi_stats_t *s = twi_stats_get(twi);
+	
+	if(s == 0) return;
+	
+	s->transactions++;
+	s->start_time = time_TWI();
+}
+
+void twi_stats_stop(TWI_t *twi){
+	twi_stats_t *s = twi_stats_get(twi);
+	uint16_t elapsed;
+	
+	if(s == 0) return;
+	
+	elapsed = time_TWI() - s->start_time;
+	if(elapsed) s->latency[bucket(elapsed)]++;
+}
+
+void twi_stats_bytes(TWI_t *twi, uint8_t out, uint8_t in){
+	twi_stats_t *s = twi_stats_get(twi);
+	
+	if(s == 0) return;
+	
+	s->bytes_out += out;
+	s->bytes_in += in;
+}
+
+void twi_stats_nack(TWI_t *twi, uint8_t addr){
+	twi_stats_t *s = twi_stats_get(twi);
+	uint8_t i;
+	
+	if(s == 0) return;
+	
+	s->nacks++;
+	
+	//an entry with a count of 0 is free
+	for(i = 0; i < TWI_STATS_NACK_ADDRS; i++){
+		if( (s->nack_count[i] != 0) && (s->nack_addr[i] != addr) ) continue;
+		
+		s->nack_addr[i] = addr;
+		s->nack_count[i]++;
+		return;
+	}
+}
+
+void twi_stats_error(TWI_t *twi, uint8_t err){
+	twi_stats_t *s = twi_stats_get(twi);
+	
+	if(s == 0) return;
+	
+	switch(err){
+		case DATA_NOT_SEND:
+		case DATA_NOT_RECEIVED:
+		s->timeouts++;
+		break;
+		
+		case NACK:
+		s->nacks++;
+		break;
+		
+		case TWI_ARB_LOST:
+		s->arb_lost++;
+		break;
+		
+		case TWI_BUS_ERROR:
+		s->bus_errors++;
+		break;
+		
+		default:
+		break;
+	}
+}
+
+void twi_stats_recovery(TWI_t *twi){
+	twi_stats_t *s = twi_stats_get(twi);
+	
+	if(s == 0) return;
+	
+	s->recoveries++;
+}
+
+void twi_stats_spin(TWI_t *twi, uint16_t elapsed){
+	twi_stats_t *s = twi_stats_get(twi);
+	
+	if(s == 0) return;
+	
+	s->spin[bucket(elapsed)]++;
+}
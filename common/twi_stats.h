@@ -0,0 +1,109 @@
+/*
+ * File twi_stats.h
+ * Author: Tycho Jöbsis
+ * Date: 16-10-2026
+ */ 
+
+/*
+*	MIT License
+*
+*	Copyright (c) 2021 TychoJ
+*
+*	Permission is hereby granted, free of charge, to any person obtaining a copy
+*	of this software and associated documentation files (the "Software"), to deal
+*	in the Software without restriction, including without limitation the rights
+*	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*	copies of the Software, and to permit persons to whom the Software is
+*	furnished to do so, subject to the following conditions:
+*
+*	The above copyright notice and this permission notice shall be included in all
+*	copies or substantial portions of the Software.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*	SOFTWARE.
+*/
+
+
+#include <avr/io.h>
+#include "twi.h"
+
+#ifndef TWI_STATS_H_
+#define TWI_STATS_H_
+
+//number of TWI modules that can have statistics
+#ifndef TWI_STATS_MAX_BUSES
+#define TWI_STATS_MAX_BUSES 4
+#endif
+
+//number of addresses whose NACKs are counted separately
+#ifndef TWI_STATS_NACK_ADDRS
+#define TWI_STATS_NACK_ADDRS 8
+#endif
+
+//histogram bucket n counts values from 2^(n-1) up to 2^n - 1, bucket 0 counts 0
+#define TWI_STATS_BUCKETS 17
+
+//statistics of one TWI module
+//latency and spin are measured in ticks of the deadline timer (clk/8), see set_deadline_timer_TWI
+//without a deadline timer latency stays empty and spin is counted in us
+typedef struct twi_stats {
+	TWI_t *twi;
+	uint32_t transactions;
+	uint32_t bytes_out;
+	uint32_t bytes_in;
+	uint16_t nacks;
+	uint16_t timeouts;
+	uint16_t arb_lost;
+	uint16_t bus_errors;
+	uint16_t recoveries;
+	uint8_t nack_addr[TWI_STATS_NACK_ADDRS];
+	uint16_t nack_count[TWI_STATS_NACK_ADDRS];
+	uint16_t latency[TWI_STATS_BUCKETS];
+	uint16_t spin[TWI_STATS_BUCKETS];
+	uint16_t start_time;
+} twi_stats_t;
+
+//the library only counts when TWI_STATS is defined for every file that includes twi.h
+//without it the hooks below are empty and cost nothing
+#ifdef TWI_STATS
+#define TWI_STATS_START(twi)			twi_stats_start(twi)
+#define TWI_STATS_STOP(twi)				twi_stats_stop(twi)
+#define TWI_STATS_BYTE_OUT(twi)			twi_stats_bytes(twi, 1, 0)
+#define TWI_STATS_BYTE_IN(twi)			twi_stats_bytes(twi, 0, 1)
+#define TWI_STATS_NACK(twi, addr)		twi_stats_nack(twi, addr)
+#define TWI_STATS_ERROR(twi, err)		twi_stats_error(twi, err)
+#define TWI_STATS_RECOVERY(twi)			twi_stats_recovery(twi)
+#define TWI_STATS_SPIN(twi, elapsed)	twi_stats_spin(twi, elapsed)
+#else
+#define TWI_STATS_START(twi)			((void)0)
+#define TWI_STATS_STOP(twi)				((void)0)
+#define TWI_STATS_BYTE_OUT(twi)			((void)0)
+#define TWI_STATS_BYTE_IN(twi)			((void)0)
+#define TWI_STATS_NACK(twi, addr)		((void)0)
+#define TWI_STATS_ERROR(twi, err)		((void)0)
+#define TWI_STATS_RECOVERY(twi)			((void)0)
+#define TWI_STATS_SPIN(twi, elapsed)	((void)0)
+#endif
+
+//returns the statistics of a TWI module, 0 when all TWI_STATS_MAX_BUSES are in use
+twi_stats_t *twi_stats_get(TWI_t *twi);
+
+//sets all counters of a TWI module to 0
+void twi_stats_reset(TWI_t *twi);
+
+//used by the library
+void twi_stats_start(TWI_t *twi);
+void twi_stats_stop(TWI_t *twi);
+void twi_stats_bytes(TWI_t *twi, uint8_t out, uint8_t in);
+void twi_stats_nack(TWI_t *twi, uint8_t addr);
+void twi_stats_error(TWI_t *twi, uint8_t err);
+void twi_stats_recovery(TWI_t *twi);
+void twi_stats_spin(TWI_t *twi, uint16_t elapsed);
+
+
+#endif /* TWI_STATS_H_ */
@@ -0,0 +1,81 @@
+/*
+ * File twi_trace.c
+ * Author: Tycho Jöbsis
+ * Date: 16-10-2026
+ */ 
+
+/*
+*	MIT License
+*
+*	Copyright (c) 2021 TychoJ
+*
+*	Permission is hereby granted, free of charge, to any person obtaining a copy
+*	of this software and associated documentation files (the "Software"), to deal
+*	in the Software without restriction, including without limitation the rights
+*	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*	copies of the Software, and to permit persons to whom the Software is
+*	furnished to do so, subject to the following conditions:
+*
+*	The above copyright notice and this permission notice shall be included in all
+*	copies or substantial portions of the Software.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*	SOFTWARE.
+*/
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "twi.h"
+#include "twi_trace.h"
+
+twi_trace_event_t twi_trace_buf[TWI_TRACE_SIZE];
+uint8_t twi_trace_head = 0;
+uint8_t twi_trace_full = 0;
+
+void twi_trace_clear(void){
+	uint8_t sreg = SREG;
+	
+	cli();
+	twi_trace_head = 0;
+	twi_trace_full = 0;
+	SREG = sreg;
+}
+
+void twi_trace_dump(void (*put)(uint8_t c)){
+	const char *magic = TWI_TRACE_MAGIC;
+	uint16_t ticks_per_ms = F_CPU / TWI_TIMER_DIV / 1000;
+	uint16_t count;
+	uint8_t i;
+	uint8_t sreg = SREG;
+	twi_trace_event_t e;
+	uint16_t n;
+	
+	//stop recording while the buffer is copied out
+	cli();
+	
+	count = twi_trace_full ? TWI_TRACE_SIZE : twi_trace_head;
+	i = twi_trace_full ? twi_trace_head : 0;
+	
+	while(*magic) put(*magic++);
+	put(TWI_TRACE_VERSION);
+	put(ticks_per_ms & 0xFF);
+	put(ticks_per_ms >> 8);
+	put(count & 0xFF);
+	put(count >> 8);
+	
+	for(n = 0; n < count; n++){
+		e = twi_trace_buf[i];
+		put(e.time & 0xFF);
+		put(e.time >> 8);
+		put(e.type);
+		put(e.arg);
+		i = (i + 1) & (TWI_TRACE_SIZE - 1);
+	}
+	
+	SREG = sreg;
+}
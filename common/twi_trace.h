@@ -0,0 +1,102 @@
+/*
+ * File twi_trace.h
+ * Author: Tycho Jöbsis
+ * Date: 16-10-2026
+ */ 
+
+/*
+*	MIT License
+*
+*	Copyright (c) 2021 TychoJ
+*
+*	Permission is hereby granted, free of charge, to any person obtaining a copy
+*	of this software and associated documentation files (the "Software"), to deal
+*	in the Software without restriction, including without limitation the rights
+*	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*	copies of the Software, and to permit persons to whom the Software is
+*	furnished to do so, subject to the following conditions:
+*
+*	The above copyright notice and this permission notice shall be included in all
+*	copies or substantial portions of the Software.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*	SOFTWARE.
+*/
+
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "twi.h"
+
+#ifndef TWI_TRACE_H_
+#define TWI_TRACE_H_
+
+//number of events kept, must be a power of two up to 256
+#ifndef TWI_TRACE_SIZE
+#define TWI_TRACE_SIZE 64
+#endif
+
+//event types, arg is noted behind every type
+#define TWI_EV_START		1	//address byte (addr << 1 | rw)
+#define TWI_EV_RSTART		2	//address byte (addr << 1 | rw)
+#define TWI_EV_ACK			3	//0
+#define TWI_EV_NACK			4	//0
+#define TWI_EV_BYTE_OUT		5	//data
+#define TWI_EV_BYTE_IN		6	//data
+#define TWI_EV_STOP			7	//0
+#define TWI_EV_ERROR		8	//error code (DATA_NOT_SEND, TWI_ARB_LOST, ...)
+#define TWI_EV_RECOVERY		9	//0
+
+//the dump starts with TWI_TRACE_MAGIC, a version byte, the ticks per ms of the timer (16 bit)
+//and the number of events (16 bit), followed by the events oldest first
+//all numbers are little endian
+#define TWI_TRACE_MAGIC		"TWTR"
+#define TWI_TRACE_VERSION	1
+
+//one event, time is the counter of the deadline timer (clk/8), see set_deadline_timer_TWI
+typedef struct twi_trace_event {
+	uint16_t time;
+	uint8_t type;
+	uint8_t arg;
+} twi_trace_event_t;
+
+extern twi_trace_event_t twi_trace_buf[TWI_TRACE_SIZE];
+extern uint8_t twi_trace_head;
+extern uint8_t twi_trace_full;
+
+//adds an event, the oldest event is overwritten when the buffer is full
+static inline void twi_trace(uint8_t type, uint8_t arg){
+	uint8_t sreg = SREG;
+	twi_trace_event_t *e;
+	
+	cli();
+	e = &twi_trace_buf[twi_trace_head];
+	e->time = time_TWI();
+	e->type = type;
+	e->arg = arg;
+	twi_trace_head = (twi_trace_head + 1) & (TWI_TRACE_SIZE - 1);
+	if(twi_trace_head == 0) twi_trace_full = 1;
+	SREG = sreg;
+}
+
+//the library only records events when TWI_TRACE is defined for every file that includes twi.h
+#ifdef TWI_TRACE
+#define TWI_TRACE_EVENT(type, arg)	twi_trace(type, arg)
+#else
+#define TWI_TRACE_EVENT(type, arg)	((void)0)
+#endif
+
+//empties the trace buffer
+void twi_trace_clear(void);
+
+//writes the trace buffer with put, one byte at a time, for example to a UART
+//tools/twi_trace_decode turns the dump into a readable transcript
+void twi_trace_dump(void (*put)(uint8_t c));
+
+
+#endif /* TWI_TRACE_H_ */
@@ -0,0 +1,307 @@
+/*
+ * File io.h
+ * Author: Tycho Jöbsis
+ * Date: 16-10-2026
+ */ 
+
+/*
+*	MIT License
+*
+*	Copyright (c) 2021 TychoJ
+*
+*	Permission is hereby granted, free of charge, to any person obtaining a copy
+*	of this software and associated documentation files (the "Software"), to deal
+*	in the Software without restriction, including without limitation the rights
+*	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*	copies of the Software, and to permit persons to whom the Software is
+*	furnished to do so, subject to the following conditions:
+*
+*	The above copyright notice and this permission notice shall be included in all
+*	copies or substantial portions of the Software.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*	SOFTWARE.
+*/
+
+#ifndef HOST_AVR_IO_H_
+#define HOST_AVR_IO_H_
+
+/*
+ * Register layout of the simulated devices for the host build, see sim.h.
+ * SIM_TINY selects a tinyAVR 1-series part with TWI0, otherwise an Xmega A3U with TWIC up to TWIF.
+ * The modules and timers live in one memory page of the simulator, every access to them is seen by it.
+ */
+
+#include <stdint.h>
+
+typedef volatile uint8_t register8_t;
+typedef volatile uint16_t register16_t;
+
+#define _BV(bit)	(1 << (bit))
+
+#define CPU_I_bm	0x80
+extern register8_t SREG;
+
+typedef struct {
+	register8_t DIR, DIRSET, DIRCLR, DIRTGL, OUT, OUTSET, OUTCLR, OUTTGL, IN;
+} PORT_t;
+
+#define PIN0_bm 0x01
+#define PIN1_bm 0x02
+
+#ifndef SIM_TINY
+
+/*
+ * Xmega A3U
+ */
+typedef struct {
+	register8_t CTRLA, CTRLB, CTRLC, STATUS, BAUD, ADDR, DATA;
+} TWI_MASTER_t;
+
+typedef struct {
+	register8_t CTRLA, CTRLB, STATUS, ADDR, DATA, ADDRMASK;
+} TWI_SLAVE_t;
+
+typedef struct {
+	register8_t CTRL;
+	TWI_MASTER_t MASTER;
+	TWI_SLAVE_t SLAVE;
+} TWI_t;
+
+typedef struct {
+	register8_t CTRLA, CTRLB, CTRLC, CTRLD, CTRLE, reserved_0x05, INTCTRLA, INTCTRLB;
+	register8_t CTRLFCLR, CTRLFSET, CTRLGCLR, CTRLGSET, INTFLAGS, reserved_0x0d, reserved_0x0e, TEMP;
+	uint8_t reserved_0x10[0x10];
+	register16_t CNT;
+	uint8_t reserved_0x22[4];
+	register16_t PER;
+	register16_t CCA, CCB, CCC, CCD;
+} TC0_t;
+
+typedef struct {
+	register8_t STATUS, INTPRI, CTRL;
+} PMIC_t;
+
+typedef struct {
+	register8_t CTRL;
+} SLEEP_t;
+
+//the simulated peripherals, in the page that is watched by the simulator
+typedef struct {
+	TWI_t TWIC, TWID, TWIE, TWIF;
+	TC0_t TCC0, TCD0, TCE0, TCF0;
+} sim_io_t;
+
+extern sim_io_t *sim_io;
+
+#define TWIC	(sim_io->TWIC)
+#define TWID	(sim_io->TWID)
+#define TWIE	(sim_io->TWIE)
+#define TWIF	(sim_io->TWIF)
+#define TCC0	(sim_io->TCC0)
+#define TCD0	(sim_io->TCD0)
+#define TCE0	(sim_io->TCE0)
+#define TCF0	(sim_io->TCF0)
+
+extern PMIC_t PMIC;
+extern SLEEP_t SLEEP;
+extern PORT_t PORTC, PORTD, PORTE, PORTF;
+
+#define TWI_FMPLUSEN_bm		0x80
+
+#define TWI_MASTER_INTLVL_gm		0xC0
+#define TWI_MASTER_INTLVL_OFF_gc	0x00
+#define TWI_MASTER_INTLVL_LO_gc		0x40
+#define TWI_MASTER_INTLVL_MED_gc	0x80
+#define TWI_MASTER_INTLVL_HI_gc		0xC0
+#define TWI_MASTER_RIEN_bm			0x20
+#define TWI_MASTER_WIEN_bm			0x10
+#define TWI_MASTER_ENABLE_bm		0x08
+
+#define TWI_MASTER_TIMEOUT_gm			0x0C
+#define TWI_MASTER_TIMEOUT_DISABLED_gc	0x00
+#define TWI_MASTER_TIMEOUT_50US_gc		0x04
+#define TWI_MASTER_TIMEOUT_100US_gc		0x08
+#define TWI_MASTER_TIMEOUT_200US_gc		0x0C
+#define TWI_MASTER_QCEN_bm				0x02
+#define TWI_MASTER_SMEN_bm				0x01
+
+#define TWI_MASTER_ACKACT_bm			0x04
+#define TWI_MASTER_CMD_gm				0x03
+#define TWI_MASTER_CMD_NOACT_gc			0x00
+#define TWI_MASTER_CMD_REPSTART_gc		0x01
+#define TWI_MASTER_CMD_RECVTRANS_gc		0x02
+#define TWI_MASTER_CMD_STOP_gc			0x03
+
+#define TWI_MASTER_RIF_bm				0x80
+#define TWI_MASTER_WIF_bm				0x40
+#define TWI_MASTER_CLKHOLD_bm			0x20
+#define TWI_MASTER_RXACK_bm				0x10
+#define TWI_MASTER_ARBLOST_bm			0x08
+#define TWI_MASTER_BUSERR_bm			0x04
+#define TWI_MASTER_BUSSTATE_gm			0x03
+#define TWI_MASTER_BUSSTATE_UNKNOWN_gc	0x00
+#define TWI_MASTER_BUSSTATE_IDLE_gc		0x01
+#define TWI_MASTER_BUSSTATE_OWNER_gc	0x02
+#define TWI_MASTER_BUSSTATE_BUSY_gc		0x03
+
+#define TWI_SLAVE_INTLVL_gm			0xC0
+#define TWI_SLAVE_DIEN_bm			0x20
+#define TWI_SLAVE_APIEN_bm			0x10
+#define TWI_SLAVE_ENABLE_bm			0x08
+#define TWI_SLAVE_PIEN_bm			0x04
+#define TWI_SLAVE_PMEN_bm			0x02
+#define TWI_SLAVE_SMEN_bm			0x01
+#define TWI_SLAVE_ACKACT_bm			0x04
+#define TWI_SLAVE_CMD_gm			0x03
+#define TWI_SLAVE_CMD_NOACT_gc		0x00
+#define TWI_SLAVE_CMD_COMPTRANS_gc	0x02
+#define TWI_SLAVE_CMD_RESPONSE_gc	0x03
+#define TWI_SLAVE_DIF_bm			0x80
+#define TWI_SLAVE_APIF_bm			0x40
+#define TWI_SLAVE_CLKHOLD_bm		0x20
+#define TWI_SLAVE_RXACK_bm			0x10
+#define TWI_SLAVE_COLL_bm			0x08
+#define TWI_SLAVE_BUSERR_bm			0x04
+#define TWI_SLAVE_DIR_bm			0x02
+#define TWI_SLAVE_AP_bm				0x01
+#define TWI_SLAVE_ADDREN_bm			0x01
+
+#define TC_CLKSEL_gm		0x0F
+#define TC_CLKSEL_OFF_gc	0x00
+#define TC_CLKSEL_DIV1_gc	0x01
+#define TC_CLKSEL_DIV2_gc	0x02
+#define TC_CLKSEL_DIV4_gc	0x03
+#define TC_CLKSEL_DIV8_gc	0x04
+#define TC_CLKSEL_DIV64_gc	0x05
+#define TC_CLKSEL_DIV256_gc	0x06
+#define TC_CLKSEL_DIV1024_gc	0x07
+#define TC_WGMODE_NORMAL_gc	0x00
+#define TC_OVFINTLVL_gm		0x03
+#define TC_OVFINTLVL_OFF_gc	0x00
+#define TC_OVFINTLVL_LO_gc	0x01
+#define TC_OVFINTLVL_MED_gc	0x02
+#define TC_OVFINTLVL_HI_gc	0x03
+#define TC0_OVFIF_bm		0x01
+
+#define PMIC_LOLVLEN_bm		0x01
+#define PMIC_MEDLVLEN_bm	0x02
+#define PMIC_HILVLEN_bm		0x04
+
+#define SLEEP_SMODE_IDLE_gc	0x00
+#define SLEEP_SEN_bm		0x01
+
+//interrupt vectors, the simulator calls these functions when they are defined
+#define TWIC_TWIM_vect	sim_vect_twic_m
+#define TWID_TWIM_vect	sim_vect_twid_m
+#define TWIE_TWIM_vect	sim_vect_twie_m
+#define TWIF_TWIM_vect	sim_vect_twif_m
+#define TWIC_TWIS_vect	sim_vect_twic_s
+#define TWID_TWIS_vect	sim_vect_twid_s
+#define TWIE_TWIS_vect	sim_vect_twie_s
+#define TWIF_TWIS_vect	sim_vect_twif_s
+#define TCC0_OVF_vect	sim_vect_tcc0_ovf
+#define TCD0_OVF_vect	sim_vect_tcd0_ovf
+#define TCE0_OVF_vect	sim_vect_tce0_ovf
+#define TCF0_OVF_vect	sim_vect_tcf0_ovf
+
+#else
+
+/*
+ * tinyAVR 1-series
+ */
+typedef struct {
+	register8_t CTRLA, DUALCTRL, DBGCTRL;
+	register8_t MCTRLA, MCTRLB, MSTATUS, MBAUD, MADDR, MDATA;
+	register8_t SCTRLA, SCTRLB, SSTATUS, SADDR, SDATA, SADDRMASK;
+} TWI_t;
+
+typedef struct {
+	register8_t CTRLA, CTRLB, reserved_0x02, reserved_0x03, EVCTRL, INTCTRL, INTFLAGS, STATUS, DBGCTRL, TEMP;
+	register16_t CNT;
+	register16_t CCMP;
+} TCB_t;
+
+typedef struct {
+	TWI_t TWI0;
+	TCB_t TCB0, TCB1;
+} sim_io_t;
+
+extern sim_io_t *sim_io;
+
+#define TWI0	(sim_io->TWI0)
+#define TCB0	(sim_io->TCB0)
+#define TCB1	(sim_io->TCB1)
+
+extern PORT_t PORTA, PORTB;
+
+#define TWI_SDASETUP_bm		0x10
+#define TWI_SDAHOLD_gm		0x0C
+#define TWI_FMPEN_bm		0x02
+
+#define TWI_RIEN_bm			0x80
+#define TWI_WIEN_bm			0x40
+#define TWI_QCEN_bm			0x10
+#define TWI_TIMEOUT_gm		0x0C
+#define TWI_SMEN_bm			0x02
+#define TWI_ENABLE_bm		0x01
+
+#define TWI_FLUSH_bm			0x08
+#define TWI_ACKACT_bm			0x04
+#define TWI_MCMD_gm				0x03
+#define TWI_MCMD_NOACT_gc		0x00
+#define TWI_MCMD_REPSTART_gc	0x01
+#define TWI_MCMD_RECVTRANS_gc	0x02
+#define TWI_MCMD_STOP_gc		0x03
+
+#define TWI_RIF_bm				0x80
+#define TWI_WIF_bm				0x40
+#define TWI_CLKHOLD_bm			0x20
+#define TWI_RXACK_bm			0x10
+#define TWI_ARBLOST_bm			0x08
+#define TWI_BUSERR_bm			0x04
+#define TWI_BUSSTATE_gm			0x03
+#define TWI_BUSSTATE_UNKNOWN_gc	0x00
+#define TWI_BUSSTATE_IDLE_gc	0x01
+#define TWI_BUSSTATE_OWNER_gc	0x02
+#define TWI_BUSSTATE_BUSY_gc	0x03
+
+#define TWI_DIEN_bm				0x80
+#define TWI_APIEN_bm			0x40
+#define TWI_PIEN_bm				0x20
+#define TWI_PMEN_bm				0x04
+#define TWI_SMEN_bm				0x02
+#define TWI_SCMD_gm				0x03
+#define TWI_SCMD_NOACT_gc		0x00
+#define TWI_SCMD_COMPTRANS_gc	0x02
+#define TWI_SCMD_RESPONSE_gc	0x03
+#define TWI_DIF_bm				0x80
+#define TWI_APIF_bm				0x40
+#define TWI_COLL_bm				0x08
+#define TWI_DIR_bm				0x02
+#define TWI_AP_bm				0x01
+#define TWI_ADDREN_bm			0x01
+
+#define TCB_ENABLE_bm			0x01
+#define TCB_CLKSEL_gm			0x06
+#define TCB_CLKSEL_CLKDIV1_gc	0x00
+#define TCB_CLKSEL_CLKDIV2_gc	0x02
+#define TCB_CLKSEL_CLKTCA_gc	0x04
+#define TCB_CNTMODE_gm			0x07
+#define TCB_CNTMODE_INT_gc		0x00
+#define TCB_CAPT_bm				0x01
+
+//interrupt vectors, the simulator calls these functions when they are defined
+#define TWI0_TWIM_vect	sim_vect_twi0_m
+#define TWI0_TWIS_vect	sim_vect_twi0_s
+#define TCB0_INT_vect	sim_vect_tcb0_int
+#define TCB1_INT_vect	sim_vect_tcb1_int
+
+#endif
+
+#endif /* HOST_AVR_IO_H_ */
@@ -0,0 +1,94 @@
+/*
+ * File bench.h
+ * Author: Tycho Jöbsis
+ * Date: 16-10-2026
+ */ 
+
+/*
+*	MIT License
+*
+*	Copyright (c) 2021 TychoJ
+*
+*	Permission is hereby granted, free of charge, to any person obtaining a copy
+*	of this software and associated documentation files (the "Software"), to deal
+*	in the Software without restriction, including without limitation the rights
+*	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*	copies of the Software, and to permit persons to whom the Software is
+*	furnished to do so, subject to the following conditions:
+*
+*	The above copyright notice and this permission notice shall be included in all
+*	copies or substantial portions of the Software.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*	SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include "sim.h"
+#include "test.h"
+
+#ifndef BENCH_H_
+#define BENCH_H_
+
+/*
+ * Measurements for the host benchmarks, every result is one CSV line on stdout
+ * the cycles are those of the simulator: sim.access_cost per register access and sim.isr_cost per interrupt,
+ * so they compare releases and options with each other, they are not the cycles of a compiled AVR build
+ */
+
+//cycles the benchmark let pass while the CPU was free to do something else
+static uint64_t bench_idle_cycles;
+
+//state at the start of a measurement
+typedef struct {
+	uint64_t cycles;
+	uint64_t sleep;
+	uint64_t idle;
+	uint64_t isr;
+	uint64_t bytes;		//data bytes on the bus of the module, without the address bytes
+} bench_mark_t;
+
+static inline void bench_mark(bench_mark_t *m, TWI_t *twi){
+	m->cycles = sim_cycles();
+	m->sleep = sim.sleep_time;
+	m->idle = bench_idle_cycles;
+	m->isr = sim.isr_time;
+	m->bytes = sim_counters(twi)->bytes_out + sim_counters(twi)->bytes_in;
+}
+
+//lets ns pass for code that doesn't use the CPU, only the interrupts in that time count as busy
+static inline void bench_idle(uint64_t ns){
+	uint64_t start = sim_cycles();
+	uint64_t isr = sim.isr_time;
+	
+	sim_run_ns(ns);
+	bench_idle_cycles += (sim_cycles() - start) - (sim.isr_time - isr);
+}
+
+//result of a measurement
+typedef struct {
+	uint64_t cycles;	//elapsed cycles
+	uint64_t busy;		//cycles the CPU was not free: elapsed minus sleep and idle time
+	uint64_t bus_bytes;
+} bench_result_t;
+
+static inline void bench_end(const bench_mark_t *m, TWI_t *twi, bench_result_t *r){
+	uint64_t free_cycles = (sim.sleep_time - m->sleep) + (bench_idle_cycles - m->idle);
+	
+	r->cycles = sim_cycles() - m->cycles;
+	r->busy = r->cycles - free_cycles;
+	r->bus_bytes = sim_counters(twi)->bytes_out + sim_counters(twi)->bytes_in - m->bytes;
+}
+
+static inline double bench_seconds(uint64_t cycles){
+	return (double)cycles / (double)F_CPU;
+}
+
+
+#endif /* BENCH_H_ */
@@ -0,0 +1,213 @@
+/*
+ * File bench_api.c
+ * Author: Tycho Jöbsis
+ * Date: 16-10-2026
+ */ 
+
+/*
+*	MIT License
+*
+*	Copyright (c) 2021 TychoJ
+*
+*	Permission is hereby granted, free of charge, to any person obtaining a copy
+*	of this software and associated documentation files (the "Software"), to deal
+*	in the Software without restriction, including without limitation the rights
+*	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*	copies of the Software, and to permit persons to whom the Software is
+*	furnished to do so, subject to the following conditions:
+*
+*	The above copyright notice and this permission notice shall be included in all
+*	copies or substantial portions of the Software.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*	SOFTWARE.
+*/
+
+#include <string.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "twi.h"
+#include "twi_async.h"
+#include "twi_smbus.h"
+#include "sim.h"
+#include "sim_devices.h"
+#include "bench.h"
+
+/*
+ * Cost of the public transfer functions against a register file at BAUD_100K and BAUD_400K
+ * CSV: family,function,speed,payload bytes,cycles/transaction,us/transaction,payload bytes/s,bus bytes/s,cpu busy
+ * the bus bytes are all data bytes on the bus, the register address included
+ * cpu busy is the part of the transaction time the CPU can't do anything else, 1.000 for a function that waits
+ */
+
+#ifdef SIM_TINY
+#define BENCH_BUS twi0_bus
+#else
+#define BENCH_BUS twie_bus
+#endif
+
+//transactions per measurement
+#define BENCH_RUNS 20
+
+#define DEV 0x40
+
+static sim_regfile_t dev;
+static uint8_t buf[16];
+static twi_transaction_t t;
+static twi_smbus_t smbus;
+
+static uint8_t run_probe(void){
+	return (probe_TWI(TEST_TWI, DEV) == ACK) ? TWI_STATUS_OK : NACK;
+}
+
+static uint8_t run_quick_command(void){
+	return (quick_command_TWI(TEST_TWI, DEV, WRITE) == ACK) ? TWI_STATUS_OK : NACK;
+}
+
+static uint8_t run_write_8bit_register(void){
+	return write_8bit_register_TWI(TEST_TWI, DEV, 0x5A, 0x10);
+}
+
+static uint8_t run_read_8bit_register(void){
+	return read_8bit_register_TWI(TEST_TWI, DEV, buf, 0x10);
+}
+
+static uint8_t run_write_registers(void){
+	return write_registers_TWI(TEST_TWI, DEV, buf, 0x10, 16);
+}
+
+static uint8_t run_read_registers(void){
+	return read_registers_TWI(TEST_TWI, DEV, buf, 0x10, 16);
+}
+
+static uint8_t run_transfer(void){
+	uint8_t reg = 0x10;
+	twi_segment_t seg[2] = {
+		{ DEV, WRITE, &reg, 1 },
+		{ DEV, READ, buf, 16 },
+	};
+	
+	return transfer_TWI(TEST_TWI, seg, 2);
+}
+
+static uint8_t run_start_send_stop(void){
+	uint8_t err = start_TWI(TEST_TWI, DEV, WRITE);
+	uint8_t i;
+	
+	if(err != ACK) return err;
+	for(i = 0; (i < 9) && (err == ACK); i++) err = send_TWI(TEST_TWI, 0x10 + i);
+	stop_TWI(TEST_TWI);
+	return (err == ACK) ? TWI_STATUS_OK : err;
+}
+
+static uint8_t run_smbus_read_word(void){
+	uint16_t word;
+	
+	return twi_smbus_read_word(&smbus, 0x10, &word);
+}
+
+//the caller waits with the CPU free, only the submit and the interrupts are busy
+static uint8_t async_done(void){
+	while( !twi_async_done(&t) ) bench_idle(1000);
+	return t.status;
+}
+
+static uint8_t run_async_write(void){
+	static const uint8_t out[17] = { 0x10 };
+	
+	twi_async_prepare(&t, DEV, out, sizeof(out), 0, 0, 0);
+	twi_async_submit(&BENCH_BUS, &t);
+	return async_done();
+}
+
+static uint8_t run_async_read(void){
+	static const uint8_t reg = 0x10;
+	
+	twi_async_prepare(&t, DEV, &reg, 1, buf, 16, 0);
+	twi_async_submit(&BENCH_BUS, &t);
+	return async_done();
+}
+
+typedef struct {
+	const char *name;
+	uint8_t payload;		//data bytes moved by one transaction
+	uint8_t async;			//runs on the interrupt engine
+	uint8_t (*run)(void);
+} bench_t;
+
+static const bench_t benches[] = {
+	{ "probe_TWI", 0, 0, run_probe },
+	{ "quick_command_TWI", 0, 0, run_quick_command },
+	{ "write_8bit_register_TWI", 1, 0, run_write_8bit_register },
+	{ "read_8bit_register_TWI", 1, 0, run_read_8bit_register },
+	{ "write_registers_TWI", 16, 0, run_write_registers },
+	{ "read_registers_TWI", 16, 0, run_read_registers },
+	{ "transfer_TWI", 16, 0, run_transfer },
+	{ "start_TWI+send_TWI+stop_TWI", 8, 0, run_start_send_stop },
+	{ "twi_smbus_read_word", 2, 0, run_smbus_read_word },
+	{ "twi_async_submit(write)", 16, 1, run_async_write },
+	{ "twi_async_submit(read)", 16, 1, run_async_read },
+};
+
+static void setup(uint32_t speed, uint8_t async){
+	sim_reset();
+	sim_regfile_init(&dev, DEV);
+	sim_attach(TEST_TWI, &dev.dev);
+	enable_TWI(TEST_TWI, speed, TIMEOUT_DIS);
+	twi_smbus_init(&smbus, TEST_TWI, DEV, 0);
+	if(async){
+		twi_async_init(&BENCH_BUS, TEST_TWI, TWI_INTLVL_LO);
+		sei();
+	}
+}
+
+static int bench(const bench_t *b, uint32_t speed){
+	bench_mark_t mark;
+	bench_result_t r;
+	double seconds;
+	uint8_t i;
+	
+	setup(speed, b->async);
+	
+	//the first run is left out, it sets up the speed and the register pointer
+	if(b->run() != TWI_STATUS_OK) return 1;
+	
+	bench_mark(&mark, TEST_TWI);
+	for(i = 0; i < BENCH_RUNS; i++){
+		if(b->run() != TWI_STATUS_OK) return 1;
+	}
+	bench_end(&mark, TEST_TWI, &r);
+	
+	seconds = bench_seconds(r.cycles);
+	printf("%s,%s,%lu,%u,%llu,%.1f,%.0f,%.0f,%.3f\n", TEST_FAMILY, b->name, (unsigned long)speed, b->payload,
+		(unsigned long long)(r.cycles / BENCH_RUNS), seconds * 1e6 / BENCH_RUNS,
+		b->payload * BENCH_RUNS / seconds, r.bus_bytes / seconds, (double)r.busy / (double)r.cycles);
+	
+	cli();
+	return 0;
+}
+
+int main(void){
+	static const uint32_t speeds[] = { BAUD_100K, BAUD_400K };
+	uint8_t i, s;
+	int failed = 0;
+	
+	sim_init();
+	printf("family,function,speed,payload_bytes,cycles_per_transaction,us_per_transaction,payload_bytes_per_s,bus_bytes_per_s,cpu_busy\n");
+	
+	//the blocking functions run before the module is registered with the engine
+	for(s = 0; s < 2; s++){
+		for(i = 0; i < sizeof(benches) / sizeof(benches[0]); i++){
+			if(bench(&benches[i], speeds[s])){
+				fprintf(stderr, "%s: %s failed\n", TEST_FAMILY, benches[i].name);
+				failed++;
+			}
+		}
+	}
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,146 @@
+/*
+ * File bench_buses.c
+ * Author: Tycho Jöbsis
+ * Date: 16-10-2026
+ */ 
+
+/*
+*	MIT License
+*
+*	Copyright (c) 2021 TychoJ
+*
+*	Permission is hereby granted, free of charge, to any person obtaining a copy
+*	of this software and associated documentation files (the "Software"), to deal
+*	in the Software without restriction, including without limitation the rights
+*	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*	copies of the Software, and to permit persons to whom the Software is
+*	furnished to do so, subject to the following conditions:
+*
+*	The above copyright notice and this permission notice shall be included in all
+*	copies or substantial portions of the Software.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*	SOFTWARE.
+*/
+
+#include <string.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "twi.h"
+#include "twi_async.h"
+#include "sim.h"
+#include "sim_devices.h"
+#include "bench.h"
+
+/*
+ * Aggregate throughput of the interrupt engine with 1 to all TWI modules busy at the same time
+ * every bus has its own register file and queue, the same number of transactions is queued on each bus
+ * CSV: family,buses,speed,transactions,us,payload bytes/s,scaling against one bus,cpu busy
+ */
+
+//the simulated modules are only known at run time, see set_modules
+#ifdef SIM_TINY
+#define BUSES 1
+static twi_async_bus_t *const buses[BUSES] = { &twi0_bus };
+#else
+#define BUSES 4
+static twi_async_bus_t *const buses[BUSES] = { &twic_bus, &twid_bus, &twie_bus, &twif_bus };
+#endif
+
+static TWI_t *modules[BUSES];
+
+static void set_modules(void){
+#ifdef SIM_TINY
+	modules[0] = &TWI0;
+#else
+	modules[0] = &TWIC;
+	modules[1] = &TWID;
+	modules[2] = &TWIE;
+	modules[3] = &TWIF;
+#endif
+}
+
+//transactions per bus, each writes a register address and 16 bytes
+#define BENCH_RUNS 8
+#define PAYLOAD 16
+
+static sim_regfile_t devs[BUSES];
+static twi_transaction_t t[BUSES][BENCH_RUNS];
+static const uint8_t out[PAYLOAD + 1] = { 0x10 };
+
+//runs BENCH_RUNS transactions on each of n buses, returns 0 when one of them failed
+static uint8_t bench(uint8_t n, uint32_t speed, bench_result_t *r){
+	bench_mark_t mark;
+	uint8_t i, j, done;
+	
+	sim_reset();
+	for(i = 0; i < n; i++){
+		sim_regfile_init(&devs[i], 0x40);
+		sim_attach(modules[i], &devs[i].dev);
+		enable_TWI(modules[i], speed, TIMEOUT_DIS);
+		twi_async_init(buses[i], modules[i], TWI_INTLVL_LO);
+	}
+	sei();
+	
+	bench_mark(&mark, modules[0]);
+	for(i = 0; i < n; i++){
+		for(j = 0; j < BENCH_RUNS; j++){
+			twi_async_prepare(&t[i][j], 0x40, out, sizeof(out), 0, 0, 0);
+			twi_async_submit(buses[i], &t[i][j]);
+		}
+	}
+	
+	//the CPU is free until the last transaction of every bus is done
+	do{
+		bench_idle(1000);
+		done = 1;
+		for(i = 0; i < n; i++){
+			if( !twi_async_done(&t[i][BENCH_RUNS - 1]) ) done = 0;
+		}
+	}while( !done );
+	bench_end(&mark, modules[0], r);
+	cli();
+	
+	for(i = 0; i < n; i++){
+		if(sim_counters(modules[i])->violations != 0) return 0;
+		for(j = 0; j < BENCH_RUNS; j++){
+			if(t[i][j].status != TWI_STATUS_OK) return 0;
+		}
+	}
+	return 1;
+}
+
+int main(void){
+	static const uint32_t speeds[] = { BAUD_100K, BAUD_400K };
+	bench_result_t r;
+	double seconds, rate, one;
+	uint8_t n, s;
+	int failed = 0;
+	
+	sim_init();
+	set_modules();
+	printf("family,buses,speed,transactions,us,payload_bytes_per_s,scaling,cpu_busy\n");
+	
+	for(s = 0; s < 2; s++){
+		one = 0;
+		for(n = 1; n <= BUSES; n++){
+			if( !bench(n, speeds[s], &r) ){
+				fprintf(stderr, "%s: %u buses failed\n", TEST_FAMILY, n);
+				failed++;
+				continue;
+			}
+			
+			seconds = bench_seconds(r.cycles);
+			rate = n * BENCH_RUNS * PAYLOAD / seconds;
+			if(n == 1) one = rate;
+			printf("%s,%u,%lu,%u,%.1f,%.0f,%.2f,%.3f\n", TEST_FAMILY, n, (unsigned long)speeds[s], n * BENCH_RUNS,
+				seconds * 1e6, rate, (one != 0) ? rate / one : 0.0, (double)r.busy / (double)r.cycles);
+		}
+	}
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,140 @@
+/*
+ * File bench_sleep.c
+ * Author: Tycho Jöbsis
+ * Date: 16-10-2026
+ */ 
+
+/*
+*	MIT License
+*
+*	Copyright (c) 2021 TychoJ
+*
+*	Permission is hereby granted, free of charge, to any person obtaining a copy
+*	of this software and associated documentation files (the "Software"), to deal
+*	in the Software without restriction, including without limitation the rights
+*	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*	copies of the Software, and to permit persons to whom the Software is
+*	furnished to do so, subject to the following conditions:
+*
+*	The above copyright notice and this permission notice shall be included in all
+*	copies or substantial portions of the Software.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*	SOFTWARE.
+*/
+
+#include <string.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "twi.h"
+#include "sim.h"
+#include "sim_devices.h"
+#include "bench.h"
+
+/*
+ * Blocking functions that spin against the same functions sleeping in IDLE (set_sleep_TWI)
+ * CSV: family,function,speed,mode,cycles/transaction,active cycles,sleep cycles,latency against spin,energy against spin
+ * the energy counts a sleeping cycle as BENCH_IDLE_PERMILLE / 1000 of an active cycle,
+ * replace it with the ratio of the IDLE and active supply current measured on your board
+ */
+
+#ifndef BENCH_IDLE_PERMILLE
+#define BENCH_IDLE_PERMILLE 350
+#endif
+
+#define BENCH_RUNS 20
+#define DEV 0x40
+
+static sim_regfile_t dev;
+static uint8_t buf[16];
+
+ISR(TEST_TWIM_vect){
+	twi_sleep_wake(TEST_TWI);
+}
+
+static uint8_t run_read_8bit_register(void){
+	return read_8bit_register_TWI(TEST_TWI, DEV, buf, 0x10);
+}
+
+static uint8_t run_write_registers(void){
+	return write_registers_TWI(TEST_TWI, DEV, buf, 0x10, 16);
+}
+
+static uint8_t run_read_registers(void){
+	return read_registers_TWI(TEST_TWI, DEV, buf, 0x10, 16);
+}
+
+typedef struct {
+	const char *name;
+	uint8_t (*run)(void);
+} bench_t;
+
+static const bench_t benches[] = {
+	{ "read_8bit_register_TWI", run_read_8bit_register },
+	{ "write_registers_TWI", run_write_registers },
+	{ "read_registers_TWI", run_read_registers },
+};
+
+//measures BENCH_RUNS transactions, returns 0 when one failed
+static uint8_t bench(const bench_t *b, uint32_t speed, uint8_t sleep, bench_result_t *r){
+	bench_mark_t mark;
+	uint8_t i;
+	
+	sim_reset();
+	sim_regfile_init(&dev, DEV);
+	sim_attach(TEST_TWI, &dev.dev);
+	enable_TWI(TEST_TWI, speed, TIMEOUT_DIS);
+	set_sleep_TWI(sleep, TWI_INTLVL_LO);
+	sei();
+	
+	if(b->run() != TWI_STATUS_OK) return 0;
+	
+	bench_mark(&mark, TEST_TWI);
+	for(i = 0; i < BENCH_RUNS; i++){
+		if(b->run() != TWI_STATUS_OK) return 0;
+	}
+	bench_end(&mark, TEST_TWI, r);
+	
+	cli();
+	set_sleep_TWI(0, TWI_INTLVL_LO);
+	return sim_counters(TEST_TWI)->violations == 0;
+}
+
+static double energy(const bench_result_t *r){
+	return (double)r->busy + (double)(r->cycles - r->busy) * BENCH_IDLE_PERMILLE / 1000.0;
+}
+
+static void print(const bench_t *b, uint32_t speed, const char *mode, const bench_result_t *r, const bench_result_t *spin){
+	printf("%s,%s,%lu,%s,%llu,%llu,%llu,%.3f,%.3f\n", TEST_FAMILY, b->name, (unsigned long)speed, mode,
+		(unsigned long long)(r->cycles / BENCH_RUNS), (unsigned long long)(r->busy / BENCH_RUNS),
+		(unsigned long long)((r->cycles - r->busy) / BENCH_RUNS),
+		(double)r->cycles / (double)spin->cycles, energy(r) / energy(spin));
+}
+
+int main(void){
+	static const uint32_t speeds[] = { BAUD_100K, BAUD_400K };
+	bench_result_t spin, sleep;
+	uint8_t i, s;
+	int failed = 0;
+	
+	sim_init();
+	printf("family,function,speed,mode,cycles_per_transaction,active_cycles,sleep_cycles,latency_vs_spin,energy_vs_spin\n");
+	
+	for(s = 0; s < 2; s++){
+		for(i = 0; i < sizeof(benches) / sizeof(benches[0]); i++){
+			if( !bench(&benches[i], speeds[s], 0, &spin) || !bench(&benches[i], speeds[s], 1, &sleep) ){
+				fprintf(stderr, "%s: %s failed\n", TEST_FAMILY, benches[i].name);
+				failed++;
+				continue;
+			}
+			print(&benches[i], speeds[s], "spin", &spin, &spin);
+			print(&benches[i], speeds[s], "sleep", &sleep, &spin);
+		}
+	}
+	return failed ? 1 : 0;
+}
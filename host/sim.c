@@ -0,0 +1,1190 @@
+/*
+ * File sim.c
+ * Author: Tycho Jöbsis
+ * Date: 16-10-2026
+ */ 
+
+/*
+*	MIT License
+*
+*	Copyright (c) 2021 TychoJ
+*
+*	Permission is hereby granted, free of charge, to any person obtaining a copy
+*	of this software and associated documentation files (the "Software"), to deal
+*	in the Software without restriction, including without limitation the rights
+*	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*	copies of the Software, and to permit persons to whom the Software is
+*	furnished to do so, subject to the following conditions:
+*
+*	The above copyright notice and this permission notice shall be included in all
+*	copies or substantial portions of the Software.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*	SOFTWARE.
+*/
+
+#define _GNU_SOURCE
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <ucontext.h>
+#include <unistd.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "twi.h"
+#include "sim.h"
+
+#if !defined(__x86_64__) || !defined(__linux__)
+#error "the simulator traps the register accesses with the page protection and trap flag of x86-64 Linux"
+#endif
+
+#define NEVER	UINT64_MAX
+
+//trap flag of EFLAGS, the CPU stops after one instruction
+#define EFLAGS_TF	0x100
+
+//page fault error code, set for a write
+#define PF_WRITE	0x2
+
+sim_io_t *sim_io;
+sim_state_t sim;
+register8_t SREG;
+
+/*
+ * Modules and vectors of both families
+ */
+#ifndef SIM_TINY
+PMIC_t PMIC;
+SLEEP_t SLEEP;
+PORT_t PORTC, PORTD, PORTE, PORTF;
+
+extern void sim_vect_twic_m(void) __attribute__((weak));
+extern void sim_vect_twid_m(void) __attribute__((weak));
+extern void sim_vect_twie_m(void) __attribute__((weak));
+extern void sim_vect_twif_m(void) __attribute__((weak));
+extern void sim_vect_twic_s(void) __attribute__((weak));
+extern void sim_vect_twid_s(void) __attribute__((weak));
+extern void sim_vect_twie_s(void) __attribute__((weak));
+extern void sim_vect_twif_s(void) __attribute__((weak));
+extern void sim_vect_tcc0_ovf(void) __attribute__((weak));
+extern void sim_vect_tcd0_ovf(void) __attribute__((weak));
+extern void sim_vect_tce0_ovf(void) __attribute__((weak));
+extern void sim_vect_tcf0_ovf(void) __attribute__((weak));
+
+#define SIM_MODULES 4
+#define SIM_TIMERS 4
+#else
+PORT_t PORTA, PORTB;
+
+extern void sim_vect_twi0_m(void) __attribute__((weak));
+extern void sim_vect_twi0_s(void) __attribute__((weak));
+extern void sim_vect_tcb0_int(void) __attribute__((weak));
+extern void sim_vect_tcb1_int(void) __attribute__((weak));
+
+#define SIM_MODULES 1
+#define SIM_TIMERS 2
+#endif
+
+//byte in flight on a module
+#define OP_NONE		0
+#define OP_WAIT		1	//the address waits for a free bus
+#define OP_ADDR		2
+#define OP_WRITE	3
+#define OP_READ		4
+
+typedef struct sim_module {
+	TWI_t *twi;
+	void (*isr_m)(void);
+	void (*isr_s)(void);
+	sim_dev_t *devs;
+	sim_dev_t *cur;			//device that acknowledged the address
+	uint8_t state;			//TWI_M_BUSSTATE_xx_gc
+	uint8_t enabled;
+	uint8_t rw;
+	uint8_t op;
+	uint8_t addr;			//address byte of the running or waiting start
+	uint8_t data;			//byte of the running write
+	uint8_t held;			//a received byte waits for its acknowledge
+	uint8_t inject;
+	uint64_t op_at;			//end of the byte in flight
+	uint64_t free_at;		//a start waits for the stop before it
+	uint64_t other_until;	//another master has the bus
+	uint64_t other_at;		//another master takes the bus for other_ns
+	uint64_t other_ns;
+	uint64_t timeout_at;	//bus timeout of the unknown state
+	uint64_t owner_since;
+	uint8_t s_cmd;			//last command of the slave interrupt, 0xFF for none
+	uint8_t s_ackact;
+	sim_twi_counters_t cnt;
+} sim_module_t;
+
+typedef struct sim_timer {
+	TWI_TIMER_t *tc;
+	void (*isr)(void);
+	uint64_t base;			//time of the last change
+	uint64_t base_ticks;	//counter at base, not wrapped
+	uint64_t wraps;			//overflows already flagged
+} sim_timer_t;
+
+static sim_module_t modules[SIM_MODULES];
+static sim_timer_t timers[SIM_TIMERS];
+
+static size_t page_size;
+static int lock_depth;
+static uint8_t in_isr;
+static uint8_t sleep_enabled;
+
+//access between the page fault and the trap after the instruction
+static struct {
+	volatile uint8_t *addr;
+	uint8_t write;
+	uint8_t old;
+} trapped;
+
+static void die(const char *msg){
+	fprintf(stderr, "sim: %s at %llu cycles\n", msg, (unsigned long long)sim.now);
+	abort();
+}
+
+static void violation(sim_module_t *m, const char *msg){
+	sim.violation = msg;
+	m->cnt.violations++;
+}
+
+//the registers can only be touched by the simulator while the page is open
+static void unlock(void){
+	if(lock_depth++ == 0) mprotect(sim_io, page_size, PROT_READ | PROT_WRITE);
+}
+
+static void lock(void){
+	if(--lock_depth == 0) mprotect(sim_io, page_size, PROT_NONE);
+}
+
+/*
+ * Time, counted in CPU cycles
+ */
+#define NS_TO_CYCLES(ns)	(((uint64_t)(ns) * (F_CPU / 1000UL) + 999999UL) / 1000000UL)
+
+uint64_t sim_cycles(void){
+	return sim.now;
+}
+
+uint64_t sim_time_ns(void){
+	return (sim.now * 1000000UL) / (F_CPU / 1000UL);
+}
+
+//cycles of one SCL period, f_scl = F_CPU / (10 + 2 * BAUD + F_CPU * t_rise)
+static uint64_t bit_cycles(sim_module_t *m){
+	return 10 + 2 * (uint64_t)TWI_M_BAUD(m->twi) + NS_TO_CYCLES(TWI_RISE_TIME_NS);
+}
+
+static uint64_t stretch_cycles(sim_dev_t *dev){
+	if(dev == 0) return 0;
+	if(dev->stretch_ns == SIM_STUCK) return NEVER;
+	return NS_TO_CYCLES(dev->stretch_ns);
+}
+
+static uint64_t timeout_cycles(sim_module_t *m){
+	switch(TWI_M_MODE(m->twi) & TWI_M_TIMEOUT_gm){
+		case TWI_M_TIMEOUT_50US_gc: return NS_TO_CYCLES(50000);
+		case TWI_M_TIMEOUT_100US_gc: return NS_TO_CYCLES(100000);
+		case TWI_M_TIMEOUT_200US_gc: return NS_TO_CYCLES(200000);
+		default: return NEVER;
+	}
+}
+
+static uint64_t after(uint64_t t, uint64_t d){
+	return ( (t == NEVER) || (d == NEVER) ) ? NEVER : t + d;
+}
+
+/*
+ * Timers
+ */
+#ifndef SIM_TINY
+static uint32_t timer_div(sim_timer_t *t){
+	static const uint16_t div[8] = { 0, 1, 2, 4, 8, 64, 256, 1024 };
+	uint8_t clksel = t->tc->CTRLA & TC_CLKSEL_gm;
+	
+	return (clksel < 8) ? div[clksel] : 0;
+}
+
+static uint32_t timer_top(sim_timer_t *t){
+	return t->tc->PER;
+}
+
+static uint8_t timer_int(sim_timer_t *t){
+	uint8_t lvl = t->tc->INTCTRLA & TC_OVFINTLVL_gm;
+	
+	return (lvl != 0) && (PMIC.CTRL & (1 << (lvl - 1))) && (t->tc->INTFLAGS & TC0_OVFIF_bm);
+}
+
+static void timer_flag(sim_timer_t *t){
+	t->tc->INTFLAGS |= TC0_OVFIF_bm;
+}
+
+static uint8_t timer_int_enabled(sim_timer_t *t){
+	return (t->tc->INTCTRLA & TC_OVFINTLVL_gm) != 0;
+}
+
+//the overflow flag is cleared by running its vector
+static void timer_enter(sim_timer_t *t){
+	t->tc->INTFLAGS &= ~TC0_OVFIF_bm;
+}
+#else
+static uint32_t timer_div(sim_timer_t *t){
+	if( !(t->tc->CTRLA & TCB_ENABLE_bm) ) return 0;
+	return ( (t->tc->CTRLA & TCB_CLKSEL_gm) == TCB_CLKSEL_CLKDIV2_gc ) ? 2 : 1;
+}
+
+static uint32_t timer_top(sim_timer_t *t){
+	return t->tc->CCMP;
+}
+
+static uint8_t timer_int(sim_timer_t *t){
+	return (t->tc->INTCTRL & TCB_CAPT_bm) && (t->tc->INTFLAGS & TCB_CAPT_bm);
+}
+
+static void timer_flag(sim_timer_t *t){
+	t->tc->INTFLAGS |= TCB_CAPT_bm;
+}
+
+static uint8_t timer_int_enabled(sim_timer_t *t){
+	return (t->tc->INTCTRL & TCB_CAPT_bm) != 0;
+}
+
+//the CAPT flag stays until the vector writes it
+static void timer_enter(sim_timer_t *t){
+	(void)t;
+}
+#endif
+
+//brings CNT and the overflow flag up to date
+static void timer_sync(sim_timer_t *t){
+	uint32_t div = timer_div(t);
+	uint64_t ticks;
+	uint64_t period = (uint64_t)timer_top(t) + 1;
+	
+	if(div == 0){
+		t->base = sim.now;
+		return;
+	}
+	
+	ticks = t->base_ticks + (sim.now - t->base) / div;
+	t->tc->CNT = ticks % period;
+	if( (ticks / period) > t->wraps ){
+		t->wraps = ticks / period;
+		timer_flag(t);
+	}
+}
+
+//starts counting again from the current CNT, after a write to the timer
+static void timer_rebase(sim_timer_t *t){
+	t->base = sim.now;
+	t->base_ticks = t->tc->CNT;
+	t->wraps = 0;
+}
+
+static uint64_t timer_next(sim_timer_t *t){
+	uint32_t div = timer_div(t);
+	uint64_t period = (uint64_t)timer_top(t) + 1;
+	uint64_t ticks;
+	
+	if( (div == 0) || !timer_int_enabled(t) ) return NEVER;
+	
+	ticks = (t->wraps + 1) * period - t->base_ticks;
+	return t->base + ticks * div;
+}
+
+/*
+ * Bus of one module
+ */
+static void set_state(sim_module_t *m, uint8_t state){
+	if( (m->state == TWI_M_BUSSTATE_OWNER_gc) && (state != TWI_M_BUSSTATE_OWNER_gc) ){
+		m->cnt.busy += sim.now - m->owner_since;
+	}
+	if( (m->state != TWI_M_BUSSTATE_OWNER_gc) && (state == TWI_M_BUSSTATE_OWNER_gc) ) m->owner_since = sim.now;
+	
+	m->state = state;
+	TWI_M_STATUS(m->twi) = (TWI_M_STATUS(m->twi) & ~TWI_M_BUSSTATE_gm) | (m->enabled ? state : 0);
+}
+
+static void set_flags(sim_module_t *m, uint8_t set, uint8_t clear){
+	TWI_M_STATUS(m->twi) = (TWI_M_STATUS(m->twi) & ~clear) | set;
+}
+
+static sim_dev_t *find_dev(sim_module_t *m, uint8_t addr){
+	sim_dev_t *dev;
+	
+	for(dev = m->devs; dev != 0; dev = dev->next){
+		if(dev->addr == addr) return dev;
+	}
+	return 0;
+}
+
+//the master sends its acknowledge for the byte it received
+static void ack_read(sim_module_t *m, uint8_t ack){
+	m->held = 0;
+	if( (m->cur != 0) && (m->cur->ack != 0) ) m->cur->ack(m->cur, ack);
+}
+
+static void begin_read(sim_module_t *m){
+	m->op = OP_READ;
+	m->op_at = after(sim.now + 9 * bit_cycles(m), stretch_cycles(m->cur));
+}
+
+//a start or repeated start with the address byte addr
+static void begin_address(sim_module_t *m, uint8_t addr){
+	uint64_t at = sim.now;
+	
+	m->addr = addr;
+	
+	if(m->state == TWI_M_BUSSTATE_OWNER_gc){
+		//the acknowledge action of a received byte goes before the repeated start
+		if(m->held) ack_read(m, !(TWI_M_CMD(m->twi) & TWI_M_ACKACT_bm));
+		m->cnt.rstarts++;
+	}
+	else if(m->state == TWI_M_BUSSTATE_IDLE_gc){
+		if(m->free_at > at) at = m->free_at;
+		m->cnt.starts++;
+		set_state(m, TWI_M_BUSSTATE_OWNER_gc);
+	}
+	else{
+		//the hardware waits until the bus is free
+		m->op = OP_WAIT;
+		return;
+	}
+	
+	m->held = 0;
+	m->cur = 0;
+	m->rw = addr & 1;
+	m->op = OP_ADDR;
+	m->op_at = after(at + 10 * bit_cycles(m), stretch_cycles(find_dev(m, addr >> 1)));
+}
+
+//another master takes over the bus
+static void lose_bus(sim_module_t *m, uint8_t err){
+	m->op = OP_NONE;
+	m->held = 0;
+	m->cur = 0;
+	
+	if(err == SIM_INJECT_ARBLOST){
+		set_flags(m, TWI_M_ARBLOST_bm | TWI_M_WIF_bm, 0);
+		m->other_until = sim.now + 20 * bit_cycles(m);
+		set_state(m, TWI_M_BUSSTATE_BUSY_gc);
+	}
+	else{
+		set_flags(m, TWI_M_BUSERR_bm | TWI_M_WIF_bm, 0);
+		set_state(m, TWI_M_BUSSTATE_IDLE_gc);
+	}
+}
+
+static void end_address(sim_module_t *m){
+	sim_dev_t *dev = find_dev(m, m->addr >> 1);
+	uint8_t ack = 0;
+	
+	m->op = OP_NONE;
+	
+	if(m->inject != SIM_INJECT_NONE){
+		lose_bus(m, m->inject);
+		m->inject = SIM_INJECT_NONE;
+		return;
+	}
+	
+	if(dev != 0){
+		dev->starts++;
+		ack = (dev->start == 0) || dev->start(dev, m->rw);
+	}
+	
+	if( !ack ){
+		m->cnt.nacks++;
+		set_flags(m, TWI_M_WIF_bm | TWI_M_RXACK_bm, 0);
+		return;
+	}
+	
+	m->cur = dev;
+	set_flags(m, 0, TWI_M_RXACK_bm);
+	
+	if(m->rw == WRITE){
+		set_flags(m, TWI_M_WIF_bm, 0);
+		return;
+	}
+	
+	//quick command ends right after the acknowledge of the address
+	if(TWI_M_MODE(m->twi) & TWI_M_QCEN_bm){
+		set_flags(m, TWI_M_RIF_bm, 0);
+		return;
+	}
+	
+	begin_read(m);
+}
+
+static void end_write(sim_module_t *m){
+	uint8_t ack;
+	
+	m->op = OP_NONE;
+	
+	if(m->inject != SIM_INJECT_NONE){
+		lose_bus(m, m->inject);
+		m->inject = SIM_INJECT_NONE;
+		return;
+	}
+	
+	ack = (m->cur == 0) || (m->cur->write == 0) || m->cur->write(m->cur, m->data);
+	if(m->cur != 0) m->cur->bytes_in++;
+	m->cnt.bytes_out++;
+	
+	if(ack) set_flags(m, TWI_M_WIF_bm, TWI_M_RXACK_bm);
+	else set_flags(m, TWI_M_WIF_bm | TWI_M_RXACK_bm, 0);
+}
+
+static void end_read(sim_module_t *m){
+	uint8_t data = 0xFF;
+	
+	m->op = OP_NONE;
+	
+	if( (m->cur != 0) && (m->cur->read != 0) ) data = m->cur->read(m->cur);
+	if(m->cur != 0) m->cur->bytes_out++;
+	m->cnt.bytes_in++;
+	
+	TWI_M_DATA(m->twi) = data;
+	m->held = 1;
+	set_flags(m, TWI_M_RIF_bm, 0);
+}
+
+static void do_stop(sim_module_t *m, uint8_t ackact){
+	if(m->state != TWI_M_BUSSTATE_OWNER_gc){
+		if(m->op == OP_WAIT) m->op = OP_NONE;
+		return;
+	}
+	
+	if(m->held) ack_read(m, !ackact);
+	
+	//a byte in flight is cut off, a stuck device gives up at the stop
+	m->op = OP_NONE;
+	if( (m->cur != 0) && (m->cur->stop != 0) ) m->cur->stop(m->cur);
+	if(m->cur != 0) m->cur->stops++;
+	m->cur = 0;
+	m->cnt.stops++;
+	m->free_at = sim.now + bit_cycles(m);
+	set_state(m, TWI_M_BUSSTATE_IDLE_gc);
+}
+
+static uint64_t module_next(sim_module_t *m){
+	uint64_t at = NEVER;
+	
+	if( !m->enabled ) return NEVER;
+	
+	if( (m->op == OP_ADDR) || (m->op == OP_WRITE) || (m->op == OP_READ) ) at = m->op_at;
+	if( (m->state == TWI_M_BUSSTATE_BUSY_gc) && (m->other_until < at) ) at = m->other_until;
+	if(m->other_at < at) at = m->other_at;
+	if( (m->state == TWI_M_BUSSTATE_UNKNOWN_gc) && (m->timeout_at < at) ) at = m->timeout_at;
+	return at;
+}
+
+static void module_run(sim_module_t *m){
+	uint64_t now = sim.now;
+	
+	if(m->other_at <= now){
+		m->other_at = NEVER;
+		if(m->state != TWI_M_BUSSTATE_OWNER_gc){
+			m->other_until = now + NS_TO_CYCLES(m->other_ns);
+			set_state(m, TWI_M_BUSSTATE_BUSY_gc);
+		}
+	}
+	
+	if( (m->state == TWI_M_BUSSTATE_BUSY_gc) && (m->other_until <= now) ){
+		m->other_until = NEVER;
+		set_state(m, TWI_M_BUSSTATE_IDLE_gc);
+	}
+	
+	if( (m->state == TWI_M_BUSSTATE_UNKNOWN_gc) && (m->timeout_at <= now) ){
+		m->timeout_at = NEVER;
+		set_state(m, TWI_M_BUSSTATE_IDLE_gc);
+	}
+	
+	if( (m->op == OP_WAIT) && (m->state == TWI_M_BUSSTATE_IDLE_gc) ) begin_address(m, m->addr);
+	
+	if( (m->op_at > now) || (m->op < OP_ADDR) ) return;
+	
+	if(m->op == OP_ADDR) end_address(m);
+	else if(m->op == OP_WRITE) end_write(m);
+	else if(m->op == OP_READ) end_read(m);
+}
+
+/*
+ * Events and interrupts
+ */
+static uint64_t next_event(void){
+	uint64_t at = NEVER;
+	uint64_t t;
+	uint8_t i;
+	
+	for(i = 0; i < SIM_MODULES; i++){
+		t = module_next(&modules[i]);
+		if(t < at) at = t;
+	}
+	for(i = 0; i < SIM_TIMERS; i++){
+		t = timer_next(&timers[i]);
+		if(t < at) at = t;
+	}
+	return at;
+}
+
+//moves time forward to t, the page must be open, interrupts are not delivered
+static void advance_to(uint64_t t){
+	uint64_t at;
+	uint8_t i;
+	
+	while( (at = next_event()) <= t ){
+		if(at > sim.now) sim.now = at;
+		for(i = 0; i < SIM_MODULES; i++) module_run(&modules[i]);
+		for(i = 0; i < SIM_TIMERS; i++) timer_sync(&timers[i]);
+	}
+	if(t > sim.now) sim.now = t;
+}
+
+#ifndef SIM_TINY
+static uint8_t level_on(uint8_t ctrl){
+	uint8_t lvl = (ctrl & TWI_MASTER_INTLVL_gm) >> 6;
+	
+	return (lvl != 0) && (PMIC.CTRL & (1 << (lvl - 1)));
+}
+#else
+static uint8_t level_on(uint8_t ctrl){
+	(void)ctrl;
+	return 1;
+}
+#endif
+
+//returns the vector of an interrupt that is ready, the page must be open
+static void (*pending(void))(void){
+	sim_module_t *m;
+	uint8_t ctrl;
+	uint8_t status;
+	uint8_t i;
+	
+	for(i = 0; i < SIM_MODULES; i++){
+		m = &modules[i];
+		
+		ctrl = TWI_M_CTRL(m->twi);
+		status = TWI_M_STATUS(m->twi);
+		if( level_on(ctrl) && ( ( (status & TWI_M_RIF_bm) && (ctrl & TWI_M_RIEN_bm) ) || ( (status & TWI_M_WIF_bm) && (ctrl & TWI_M_WIEN_bm) ) ) ){
+			if(m->isr_m == 0) die("master interrupt without a vector");
+			return m->isr_m;
+		}
+		
+		ctrl = TWI_S_CTRL(m->twi);
+		status = TWI_S_STATUS(m->twi);
+		if( level_on(ctrl) && (ctrl & TWI_S_ENABLE_bm) && ( ( (status & TWI_S_DIF_bm) && (ctrl & TWI_S_DIEN_bm) ) || ( (status & TWI_S_APIF_bm) && (ctrl & TWI_S_APIEN_bm) ) ) ){
+			if(m->isr_s == 0) die("slave interrupt without a vector");
+			return m->isr_s;
+		}
+	}
+	
+	for(i = 0; i < SIM_TIMERS; i++){
+		timer_sync(&timers[i]);
+		if(timer_int(&timers[i])){
+			if(timers[i].isr == 0) die("timer interrupt without a vector");
+			timer_enter(&timers[i]);
+			return timers[i].isr;
+		}
+	}
+	return 0;
+}
+
+static void call_isr(void (*isr)(void)){
+	uint64_t start = sim.now;
+	
+	in_isr = 1;
+	SREG &= ~CPU_I_bm;
+	unlock();
+	advance_to(sim.now + sim.isr_cost);
+	lock();
+	isr();
+	SREG |= CPU_I_bm;
+	in_isr = 0;
+	
+	sim.isr_calls++;
+	sim.isr_time += sim.now - start;
+	if( (sim.now - start) > sim.isr_max ) sim.isr_max = sim.now - start;
+}
+
+//runs the interrupts that are ready, the page must be closed
+static void deliver(void){
+	void (*isr)(void);
+	uint32_t n = 0;
+	
+	if(in_isr) return;
+	
+	while(SREG & CPU_I_bm){
+		unlock();
+		isr = pending();
+		lock();
+		if(isr == 0) return;
+		
+		if(++n > 100000) die("interrupt storm, an interrupt flag is never cleared");
+		call_isr(isr);
+	}
+}
+
+static void run_until(uint64_t t){
+	uint64_t at;
+	
+	while(1){
+		unlock();
+		at = next_event();
+		if(at > t) at = t;
+		advance_to(at);
+		lock();
+		deliver();
+		if(sim.now >= t) return;
+	}
+}
+
+void sim_run_ns(uint64_t ns){
+	run_until(sim.now + NS_TO_CYCLES(ns));
+}
+
+void sim_delay_us(double us){
+	run_until(sim.now + (uint64_t)(us * (F_CPU / 1000000.0) + 0.5));
+}
+
+void sim_cli(void){
+	SREG &= ~CPU_I_bm;
+}
+
+//the interrupts that are ready run after the next access, so the instruction after sei still runs first
+void sim_sei(void){
+	SREG |= CPU_I_bm;
+}
+
+void sim_sleep_enable(uint8_t enable){
+	sleep_enabled = enable;
+}
+
+void sim_sleep(void){
+	uint64_t start = sim.now;
+	void (*isr)(void);
+	uint64_t at;
+	
+	if( !sleep_enabled ) return;
+	if( !(SREG & CPU_I_bm) ) die("sleep with interrupts disabled");
+	
+	while(1){
+		unlock();
+		isr = pending();
+		if(isr != 0){
+			lock();
+			break;
+		}
+		
+		at = next_event();
+		if(at == NEVER){
+			lock();
+			die("sleep without a wake up source");
+		}
+		advance_to(at);
+		lock();
+	}
+	
+	sim.sleep_time += sim.now - start;
+	deliver();
+}
+
+/*
+ * Register accesses
+ */
+static sim_module_t *module_of(volatile uint8_t *addr){
+	uint8_t i;
+	
+	for(i = 0; i < SIM_MODULES; i++){
+		if( (addr >= (volatile uint8_t *)modules[i].twi) && (addr < (volatile uint8_t *)(modules[i].twi + 1)) ) return &modules[i];
+	}
+	return 0;
+}
+
+static sim_timer_t *timer_of(volatile uint8_t *addr){
+	uint8_t i;
+	
+	for(i = 0; i < SIM_TIMERS; i++){
+		if( (addr >= (volatile uint8_t *)timers[i].tc) && (addr < (volatile uint8_t *)(timers[i].tc + 1)) ) return &timers[i];
+	}
+	return 0;
+}
+
+static void write_ctrl(sim_module_t *m, uint8_t old){
+	uint8_t on = (TWI_M_CTRL(m->twi) & TWI_M_ENABLE_bm) != 0;
+	
+	(void)old;
+	if(on == m->enabled) return;
+	
+	m->enabled = on;
+	m->op = OP_NONE;
+	m->held = 0;
+	m->cur = 0;
+	m->state = TWI_M_BUSSTATE_UNKNOWN_gc;
+	TWI_M_STATUS(m->twi) = 0;
+	
+	//the bus state is unknown until a bus timeout or a forced idle
+	if(on) m->timeout_at = after(sim.now, timeout_cycles(m));
+}
+
+static void write_status(sim_module_t *m, uint8_t value, uint8_t old){
+	uint8_t w1c = TWI_M_RIF_bm | TWI_M_WIF_bm | TWI_M_ARBLOST_bm | TWI_M_BUSERR_bm;
+	
+	TWI_M_STATUS(m->twi) = old & ~(value & w1c);
+	
+	if( m->enabled && ((value & TWI_M_BUSSTATE_gm) == TWI_M_BUSSTATE_IDLE_gc) ){
+		if(m->state == TWI_M_BUSSTATE_OWNER_gc) violation(m, "bus forced to idle while owned");
+		m->timeout_at = NEVER;
+		set_state(m, TWI_M_BUSSTATE_IDLE_gc);
+	}
+}
+
+static void write_cmd(sim_module_t *m, uint8_t value){
+	uint8_t ackact = value & TWI_M_ACKACT_bm;
+	uint8_t cmd = value & 0x03;
+	
+	//the command bits always read 0
+	TWI_M_CMD(m->twi) = ackact;
+	if(cmd == 0) return;
+	
+	set_flags(m, 0, TWI_M_RIF_bm | TWI_M_WIF_bm);
+	
+	switch(cmd){
+		case 1:
+		begin_address(m, TWI_M_ADDR(m->twi));
+		break;
+		
+		case TWI_M_CMD_RECVTRANS_gc:
+		if( (m->state != TWI_M_BUSSTATE_OWNER_gc) || (m->op != OP_NONE) ){
+			violation(m, "RECVTRANS without a byte");
+			break;
+		}
+		if(m->rw == WRITE) break;
+		
+		if(m->held) ack_read(m, !ackact);
+		if( !ackact ) begin_read(m);
+		break;
+		
+		case TWI_M_CMD_STOP_gc:
+		do_stop(m, ackact);
+		break;
+	}
+}
+
+static void write_master(sim_module_t *m, volatile uint8_t *addr, uint8_t old){
+	TWI_t *twi = m->twi;
+	uint8_t value = *addr;
+	
+	//the control and mode register are the same register on some devices
+	if( (addr == &TWI_M_CTRL(twi)) || (addr == &TWI_M_MODE(twi)) ){
+		write_ctrl(m, old);
+		if( ( (old ^ value) & TWI_M_TIMEOUT_gm ) && (m->state == TWI_M_BUSSTATE_UNKNOWN_gc) ){
+			m->timeout_at = after(sim.now, timeout_cycles(m));
+		}
+	}
+	
+	if(addr == &TWI_M_BAUD(twi)){
+		if(m->enabled) violation(m, "BAUD written while the master is enabled");
+	}
+	else if(addr == &TWI_M_STATUS(twi)){
+		write_status(m, value, old);
+	}
+	else if(addr == &TWI_M_CMD(twi)){
+		write_cmd(m, value);
+	}
+	else if(addr == &TWI_M_ADDR(twi)){
+		if( !m->enabled ){
+			violation(m, "ADDR written while the master is disabled");
+			return;
+		}
+		if( (m->op != OP_NONE) && (m->op != OP_WAIT) ) violation(m, "ADDR written while a byte is on the bus");
+		
+		//a new address also clears the error flags
+		set_flags(m, 0, TWI_M_RIF_bm | TWI_M_WIF_bm | TWI_M_ARBLOST_bm | TWI_M_BUSERR_bm);
+		begin_address(m, value);
+	}
+	else if(addr == &TWI_M_DATA(twi)){
+		set_flags(m, 0, TWI_M_RIF_bm | TWI_M_WIF_bm);
+		if( (m->state != TWI_M_BUSSTATE_OWNER_gc) || (m->rw != WRITE) || (m->op != OP_NONE) || (m->cur == 0) ){
+			violation(m, "DATA written without an acknowledged write address");
+			return;
+		}
+		m->data = value;
+		m->op = OP_WRITE;
+		m->op_at = after(sim.now + 9 * bit_cycles(m), stretch_cycles(m->cur));
+	}
+}
+
+static void read_master(sim_module_t *m, volatile uint8_t *addr){
+	TWI_t *twi = m->twi;
+	uint8_t status;
+	
+	if(addr != &TWI_M_DATA(twi)) return;
+	
+	status = TWI_M_STATUS(twi);
+	set_flags(m, 0, TWI_M_RIF_bm | TWI_M_WIF_bm);
+	
+	//smart mode sends the acknowledge action when DATA is read
+	if( (TWI_M_MODE(twi) & TWI_M_SMEN_bm) && m->held && (status & TWI_M_RIF_bm) ){
+		uint8_t ackact = TWI_M_CMD(twi) & TWI_M_ACKACT_bm;
+		
+		ack_read(m, !ackact);
+		if( !ackact ) begin_read(m);
+	}
+}
+
+static void write_slave(sim_module_t *m, volatile uint8_t *addr, uint8_t old){
+	TWI_t *twi = m->twi;
+	uint8_t value = *addr;
+	
+	if(addr == &TWI_S_CMD(twi)){
+		TWI_S_CMD(twi) = value & TWI_S_ACKACT_bm;
+		if( (value & 0x03) == 0 ) return;
+		
+		m->s_cmd = value & 0x03;
+		m->s_ackact = value & TWI_S_ACKACT_bm;
+		TWI_S_STATUS(twi) &= ~(TWI_S_DIF_bm | TWI_S_APIF_bm);
+	}
+	else if(addr == &TWI_S_STATUS(twi)){
+		TWI_S_STATUS(twi) = old & ~(value & (TWI_S_DIF_bm | TWI_S_APIF_bm | TWI_S_COLL_bm | TWI_S_BUSERR_bm));
+	}
+}
+
+static uint8_t is_slave_reg(TWI_t *twi, volatile uint8_t *addr){
+	return (addr == &TWI_S_CTRL(twi)) || (addr == &TWI_S_CMD(twi)) || (addr == &TWI_S_STATUS(twi)) ||
+		(addr == &TWI_S_ADDR(twi)) || (addr == &TWI_S_DATA(twi)) || (addr == &TWI_S_ADDRMASK(twi));
+}
+
+static void pre_access(volatile uint8_t *addr){
+	sim_timer_t *t;
+	
+	sim.accesses++;
+	advance_to(sim.now + sim.access_cost);
+	
+	t = timer_of(addr);
+	if(t != 0) timer_sync(t);
+}
+
+static void post_access(volatile uint8_t *addr, uint8_t write, uint8_t old){
+	sim_module_t *m = module_of(addr);
+	sim_timer_t *t;
+	
+	if(m != 0){
+		if(is_slave_reg(m->twi, addr)){
+			if(write) write_slave(m, addr, old);
+		}
+		else if(write) write_master(m, addr, old);
+		else read_master(m, addr);
+		return;
+	}
+	
+	t = timer_of(addr);
+	if( (t != 0) && write ){
+		if(addr == &t->tc->INTFLAGS) t->tc->INTFLAGS = old & ~(*addr);
+		else timer_rebase(t);
+		return;
+	}
+	
+	if(t == 0) sim.violation = "access to an unused register";
+}
+
+static void on_segv(int sig, siginfo_t *si, void *ctx){
+	ucontext_t *uc = ctx;
+	volatile uint8_t *addr = si->si_addr;
+	
+	(void)sig;
+	
+	//a real crash
+	if( (addr < (volatile uint8_t *)sim_io) || (addr >= (volatile uint8_t *)sim_io + page_size) ){
+		signal(SIGSEGV, SIG_DFL);
+		return;
+	}
+	
+	unlock();
+	pre_access(addr);
+	trapped.addr = addr;
+	trapped.write = (uc->uc_mcontext.gregs[REG_ERR] & PF_WRITE) != 0;
+	trapped.old = *addr;
+	
+	//let the instruction run with the page open and stop right after it
+	uc->uc_mcontext.gregs[REG_EFL] |= EFLAGS_TF;
+}
+
+static void on_trap(int sig, siginfo_t *si, void *ctx){
+	ucontext_t *uc = ctx;
+	volatile uint8_t *addr = trapped.addr;
+	uint8_t write = trapped.write;
+	uint8_t old = trapped.old;
+	
+	(void)sig;
+	(void)si;
+	
+	uc->uc_mcontext.gregs[REG_EFL] &= ~EFLAGS_TF;
+	
+	post_access(addr, write, old);
+	lock();
+	deliver();
+}
+
+/*
+ * Setup
+ */
+void sim_init(void){
+	struct sigaction sa;
+	
+	page_size = sysconf(_SC_PAGESIZE);
+	if(sizeof(sim_io_t) > page_size) die("the registers don't fit in a page");
+	
+	sim_io = mmap(0, page_size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if(sim_io == MAP_FAILED) die("mmap failed");
+	
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_flags = SA_SIGINFO | SA_NODEFER;
+	sa.sa_sigaction = on_segv;
+	sigaction(SIGSEGV, &sa, 0);
+	sa.sa_sigaction = on_trap;
+	sigaction(SIGTRAP, &sa, 0);
+	
+	sim_reset();
+}
+
+void sim_reset(void){
+	uint8_t i;
+	
+	unlock();
+	memset(sim_io, 0, page_size);
+	memset(modules, 0, sizeof(modules));
+	memset(timers, 0, sizeof(timers));
+	
+#ifndef SIM_TINY
+	modules[0].twi = &TWIC;
+	modules[0].isr_m = sim_vect_twic_m;
+	modules[0].isr_s = sim_vect_twic_s;
+	modules[1].twi = &TWID;
+	modules[1].isr_m = sim_vect_twid_m;
+	modules[1].isr_s = sim_vect_twid_s;
+	modules[2].twi = &TWIE;
+	modules[2].isr_m = sim_vect_twie_m;
+	modules[2].isr_s = sim_vect_twie_s;
+	modules[3].twi = &TWIF;
+	modules[3].isr_m = sim_vect_twif_m;
+	modules[3].isr_s = sim_vect_twif_s;
+	timers[0].tc = &TCC0;
+	timers[0].isr = sim_vect_tcc0_ovf;
+	timers[1].tc = &TCD0;
+	timers[1].isr = sim_vect_tcd0_ovf;
+	timers[2].tc = &TCE0;
+	timers[2].isr = sim_vect_tce0_ovf;
+	timers[3].tc = &TCF0;
+	timers[3].isr = sim_vect_tcf0_ovf;
+	
+	memset((void *)&PMIC, 0, sizeof(PMIC));
+	memset((void *)&SLEEP, 0, sizeof(SLEEP));
+	PORTC.IN = PORTD.IN = PORTE.IN = PORTF.IN = 0xFF;	//pulled up
+#else
+	modules[0].twi = &TWI0;
+	modules[0].isr_m = sim_vect_twi0_m;
+	modules[0].isr_s = sim_vect_twi0_s;
+	timers[0].tc = &TCB0;
+	timers[0].isr = sim_vect_tcb0_int;
+	timers[1].tc = &TCB1;
+	timers[1].isr = sim_vect_tcb1_int;
+	
+	PORTA.IN = PORTB.IN = 0xFF;
+#endif
+	
+	for(i = 0; i < SIM_MODULES; i++){
+		modules[i].state = TWI_M_BUSSTATE_UNKNOWN_gc;
+		modules[i].other_until = NEVER;
+		modules[i].other_at = NEVER;
+		modules[i].timeout_at = NEVER;
+		modules[i].s_cmd = 0xFF;
+	}
+	
+	for(i = 0; i < SIM_TIMERS; i++){
+		timers[i].tc->CNT = 0;
+		timer_rebase(&timers[i]);
+	}
+	lock();
+	
+	memset(&sim, 0, sizeof(sim));
+	sim.access_cost = 4;
+	sim.isr_cost = 20;
+	SREG = 0;
+	in_isr = 0;
+	sleep_enabled = 0;
+}
+
+/*
+ * Devices and external masters
+ */
+static sim_module_t *module(TWI_t *twi){
+	uint8_t i;
+	
+	for(i = 0; i < SIM_MODULES; i++){
+		if(modules[i].twi == twi) return &modules[i];
+	}
+	die("unknown TWI module");
+	return 0;
+}
+
+void sim_attach(TWI_t *twi, sim_dev_t *dev){
+	sim_module_t *m = module(twi);
+	
+	dev->next = m->devs;
+	m->devs = dev;
+}
+
+void sim_detach(TWI_t *twi, sim_dev_t *dev){
+	sim_module_t *m = module(twi);
+	sim_dev_t **p;
+	
+	for(p = &m->devs; *p != 0; p = &(*p)->next){
+		if(*p == dev){
+			*p = dev->next;
+			break;
+		}
+	}
+	if(m->cur == dev) m->cur = 0;
+}
+
+void sim_inject(TWI_t *twi, uint8_t err){
+	module(twi)->inject = err;
+}
+
+void sim_other_master(TWI_t *twi, uint64_t ns){
+	sim_module_t *m = module(twi);
+	
+	unlock();
+	if(m->state != TWI_M_BUSSTATE_OWNER_gc){
+		m->other_until = sim.now + NS_TO_CYCLES(ns);
+		set_state(m, TWI_M_BUSSTATE_BUSY_gc);
+	}
+	lock();
+}
+
+sim_twi_counters_t *sim_counters(TWI_t *twi){
+	return &module(twi)->cnt;
+}
+
+void sim_other_master_at(TWI_t *twi, uint64_t at_ns, uint64_t ns){
+	sim_module_t *m = module(twi);
+	
+	m->other_at = NS_TO_CYCLES(at_ns);
+	m->other_ns = ns;
+}
+
+uint8_t sim_bus_state(TWI_t *twi){
+	return module(twi)->state;
+}
+
+uint32_t sim_bit_ns(TWI_t *twi){
+	sim_module_t *m = module(twi);
+	uint64_t cycles;
+	
+	unlock();
+	cycles = bit_cycles(m);
+	lock();
+	return (cycles * 1000000UL) / (F_CPU / 1000UL);
+}
+
+//returns 1 when the slave of a module answers to addr
+static uint8_t slave_match(sim_module_t *m, uint8_t addr){
+	TWI_t *twi = m->twi;
+	uint8_t own = TWI_S_ADDR(twi) >> 1;
+	uint8_t second = TWI_S_ADDRMASK(twi);
+	
+	if( !(TWI_S_CTRL(twi) & TWI_S_ENABLE_bm) ) return 0;
+	if(addr == own) return 1;
+	
+	if(second & TWI_S_ADDREN_bm) return addr == (second >> 1);
+	return ( (addr ^ own) & ~(second >> 1) & 0x7F ) == 0;
+}
+
+//one event for the slave, the interrupt answers it with a command
+//returns 1 when the slave acknowledged
+static uint8_t slave_step(sim_module_t *m, uint8_t status, int data){
+	uint64_t cycles;
+	
+	unlock();
+	m->s_cmd = 0xFF;
+	TWI_S_STATUS(m->twi) = status;
+	if(data >= 0) TWI_S_DATA(m->twi) = data;
+	cycles = bit_cycles(m);
+	lock();
+	
+	run_until(sim.now + 9 * cycles);
+	
+	if(m->s_cmd == 0xFF) die("the slave interrupt sent no command, the bus would hang");
+	return (m->s_cmd == TWI_S_CMD_RESPONSE_gc) && !m->s_ackact;
+}
+
+static void slave_stop(sim_module_t *m){
+	uint8_t pien;
+	
+	unlock();
+	pien = TWI_S_CTRL(m->twi) & TWI_S_PIEN_bm;
+	lock();
+	
+	if(pien) slave_step(m, TWI_S_APIF_bm, -1);
+}
+
+int sim_master_write(TWI_t *twi, uint8_t addr, const uint8_t *data, uint8_t len, uint8_t stop){
+	sim_module_t *m = module(twi);
+	uint8_t match;
+	int n;
+	
+	unlock();
+	match = slave_match(m, addr);
+	lock();
+	
+	if( !match || !slave_step(m, TWI_S_APIF_bm | TWI_S_AP_bm, addr << 1) ){
+		if(stop) slave_stop(m);
+		return -1;
+	}
+	
+	for(n = 0; n < len; n++){
+		if( !slave_step(m, TWI_S_DIF_bm, data[n]) ) break;
+	}
+	if(n < len) n++;	//the NACKed byte was received too
+	
+	if(stop) slave_stop(m);
+	return n;
+}
+
+int sim_master_read(TWI_t *twi, uint8_t addr, uint8_t *data, uint8_t len, uint8_t stop){
+	sim_module_t *m = module(twi);
+	uint8_t match;
+	int n;
+	
+	unlock();
+	match = slave_match(m, addr);
+	lock();
+	
+	if( !match || !slave_step(m, TWI_S_APIF_bm | TWI_S_AP_bm | TWI_S_DIR_bm, (addr << 1) | READ) ){
+		if(stop) slave_stop(m);
+		return -1;
+	}
+	
+	for(n = 0; n < len; n++){
+		slave_step(m, TWI_S_DIF_bm | TWI_S_DIR_bm, -1);
+		unlock();
+		data[n] = TWI_S_DATA(twi);
+		lock();
+	}
+	
+	//the master NACKs the last byte
+	slave_step(m, TWI_S_DIF_bm | TWI_S_DIR_bm | TWI_S_RXACK_bm, -1);
+	
+	if(stop) slave_stop(m);
+	return n;
+}
@@ -0,0 +1,162 @@
+/*
+ * File sim.h
+ * Author: Tycho Jöbsis
+ * Date: 16-10-2026
+ */ 
+
+/*
+*	MIT License
+*
+*	Copyright (c) 2021 TychoJ
+*
+*	Permission is hereby granted, free of charge, to any person obtaining a copy
+*	of this software and associated documentation files (the "Software"), to deal
+*	in the Software without restriction, including without limitation the rights
+*	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*	copies of the Software, and to permit persons to whom the Software is
+*	furnished to do so, subject to the following conditions:
+*
+*	The above copyright notice and this permission notice shall be included in all
+*	copies or substantial portions of the Software.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*	SOFTWARE.
+*/
+
+#include <avr/io.h>
+#include <stdint.h>
+
+#ifndef SIM_H_
+#define SIM_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Register level simulator of the TWI modules for the host build.
+ * The library runs unchanged on the PC, every access to a module or timer is trapped and handled by the simulator:
+ * the bus, the STATUS flags, the commands, smart mode, quick command and the bus timeout are modelled,
+ * the virtual slaves on the bus answer the master and the interrupts are delivered between two accesses.
+ * Time only moves when the CPU touches a register, waits in _delay_us or sleeps, every access costs sim.access_cost.
+ */
+
+//stretch_ns of a device that holds SCL low forever
+#define SIM_STUCK 0xFFFFFFFFUL
+
+//errors injected in the next address or data byte of a module
+#define SIM_INJECT_NONE		0
+#define SIM_INJECT_ARBLOST	1
+#define SIM_INJECT_BUSERR	2
+
+struct sim_dev;
+
+//a slave on the simulated bus, every callback is optional
+//start returns 1 to ACK its address, write returns 1 to ACK a byte of the master
+//ack gets the ACK (1) or NACK (0) of the master after every byte read from the device
+//stretch_ns is added to every byte, SIM_STUCK never finishes the byte
+typedef struct sim_dev {
+	uint8_t addr;
+	uint8_t (*start)(struct sim_dev *dev, uint8_t rw);
+	uint8_t (*write)(struct sim_dev *dev, uint8_t data);
+	uint8_t (*read)(struct sim_dev *dev);
+	void (*ack)(struct sim_dev *dev, uint8_t ack);
+	void (*stop)(struct sim_dev *dev);
+	uint32_t stretch_ns;
+	uint32_t starts;
+	uint32_t stops;
+	uint32_t bytes_in;
+	uint32_t bytes_out;
+	struct sim_dev *next;
+} sim_dev_t;
+
+//counters of one module, reset by sim_reset
+typedef struct sim_twi_counters {
+	uint32_t starts;
+	uint32_t rstarts;
+	uint32_t stops;
+	uint32_t bytes_out;
+	uint32_t bytes_in;
+	uint32_t nacks;
+	uint32_t violations;	//accesses the hardware would not accept, see sim_last_violation
+	uint64_t busy;			//cycles the master held the bus
+} sim_twi_counters_t;
+
+//state of the simulator
+typedef struct sim_state {
+	uint64_t now;				//time in CPU cycles
+	uint32_t access_cost;		//CPU cycles of one register access with the code around it
+	uint32_t isr_cost;			//CPU cycles to enter and leave an interrupt
+	uint64_t accesses;
+	uint64_t isr_calls;
+	uint64_t isr_time;			//cycles spent in interrupts
+	uint64_t isr_max;			//cycles of the longest interrupt
+	uint64_t sleep_time;		//cycles spent in sleep_cpu
+	const char *violation;		//last access the hardware would not accept
+} sim_state_t;
+
+extern sim_state_t sim;
+
+//maps the registers and installs the trap handlers, call once
+void sim_init(void);
+
+//puts all modules, timers, devices and counters back in their reset state
+void sim_reset(void);
+
+//simulated time
+uint64_t sim_time_ns(void);
+uint64_t sim_cycles(void);
+
+//busy waits, used for _delay_us and TWI_DELAY_US
+void sim_delay_us(double us);
+
+//lets time pass without a register access, interrupts are delivered
+void sim_run_ns(uint64_t ns);
+
+//puts a device on the bus of a module
+void sim_attach(TWI_t *twi, sim_dev_t *dev);
+
+//takes a device off the bus
+void sim_detach(TWI_t *twi, sim_dev_t *dev);
+
+//the next address or data byte of the master fails with err (SIM_INJECT_xx)
+void sim_inject(TWI_t *twi, uint8_t err);
+
+//another master uses the bus for ns, a start of this module waits for it
+void sim_other_master(TWI_t *twi, uint64_t ns);
+
+//another master takes the bus at the time at_ns (sim_time_ns) for ns, unless this module owns it then
+void sim_other_master_at(TWI_t *twi, uint64_t at_ns, uint64_t ns);
+
+//counters of a module
+sim_twi_counters_t *sim_counters(TWI_t *twi);
+
+//bus state as the hardware sees it (TWI_M_BUSSTATE_xx_gc)
+uint8_t sim_bus_state(TWI_t *twi);
+
+//time of one SCL period at the current baud register in ns
+uint32_t sim_bit_ns(TWI_t *twi);
+
+//an external master addressing the slave of a module
+//every byte of the transaction is handled by the slave interrupt
+//stop 0 ends with a repeated start for the next call
+//returns the number of bytes the slave acknowledged (write) or that were read, -1 when the address was not acknowledged
+int sim_master_write(TWI_t *twi, uint8_t addr, const uint8_t *data, uint8_t len, uint8_t stop);
+int sim_master_read(TWI_t *twi, uint8_t addr, uint8_t *data, uint8_t len, uint8_t stop);
+
+//CPU functions used by the mock avr-libc headers
+void sim_cli(void);
+void sim_sei(void);
+void sim_sleep_enable(uint8_t enable);
+void sim_sleep(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SIM_H_ */
@@ -0,0 +1,170 @@
+/*
+ * File sim_devices.c
+ * Author: Tycho Jöbsis
+ * Date: 16-10-2026
+ */ 
+
+/*
+*	MIT License
+*
+*	Copyright (c) 2021 TychoJ
+*
+*	Permission is hereby granted, free of charge, to any person obtaining a copy
+*	of this software and associated documentation files (the "Software"), to deal
+*	in the Software without restriction, including without limitation the rights
+*	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*	copies of the Software, and to permit persons to whom the Software is
+*	furnished to do so, subject to the following conditions:
+*
+*	The above copyright notice and this permission notice shall be included in all
+*	copies or substantial portions of the Software.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*	SOFTWARE.
+*/
+
+#include <string.h>
+#include "twi.h"
+#include "sim.h"
+#include "sim_devices.h"
+
+/*
+ * Register file
+ */
+static uint8_t regfile_start(sim_dev_t *dev, uint8_t rw){
+	sim_regfile_t *r = (sim_regfile_t *)dev;
+	
+	if(rw == WRITE){
+		r->pointer_set = 0;
+		r->writes = 0;
+	}
+	return 1;
+}
+
+static uint8_t regfile_write(sim_dev_t *dev, uint8_t data){
+	sim_regfile_t *r = (sim_regfile_t *)dev;
+	
+	if( !r->pointer_set ){
+		r->ptr = data;
+		r->pointer_set = 1;
+		return 1;
+	}
+	
+	r->regs[r->ptr++] = data;
+	r->writes++;
+	return 1;
+}
+
+static uint8_t regfile_read(sim_dev_t *dev){
+	sim_regfile_t *r = (sim_regfile_t *)dev;
+	
+	return r->regs[r->ptr++];
+}
+
+void sim_regfile_init(sim_regfile_t *r, uint8_t addr){
+	memset(r, 0, sizeof(*r));
+	r->dev.addr = addr;
+	r->dev.start = regfile_start;
+	r->dev.write = regfile_write;
+	r->dev.read = regfile_read;
+}
+
+/*
+ * EEPROM
+ */
+static uint8_t eeprom_start(sim_dev_t *dev, uint8_t rw){
+	sim_eeprom_t *e = (sim_eeprom_t *)dev;
+	
+	if(sim_cycles() < e->busy_until){
+		e->busy_nacks++;
+		return 0;
+	}
+	
+	if(rw == WRITE){
+		e->addr_count = 0;
+		e->pending = 0;
+	}
+	return 1;
+}
+
+static uint8_t eeprom_write(sim_dev_t *dev, uint8_t data){
+	sim_eeprom_t *e = (sim_eeprom_t *)dev;
+	uint32_t page_start;
+	
+	if(e->addr_count < e->addr_bytes){
+		e->ptr = ( (e->ptr << 8) | data ) % e->size;
+		if(++e->addr_count == e->addr_bytes) e->buf_addr = e->ptr;
+		return 1;
+	}
+	
+	//the address counter only counts inside the page
+	page_start = e->buf_addr - (e->buf_addr % e->page);
+	if( (e->pending != 0) && (((e->buf_addr + e->pending) % e->page) == 0) ) e->wraps++;
+	e->mem[page_start + ((e->buf_addr + e->pending) % e->page)] = data;
+	if(e->pending < e->page) e->pending++;
+	return 1;
+}
+
+static uint8_t eeprom_read(sim_dev_t *dev){
+	sim_eeprom_t *e = (sim_eeprom_t *)dev;
+	uint8_t data = e->mem[e->ptr];
+	
+	e->ptr = (e->ptr + 1) % e->size;
+	return data;
+}
+
+static void eeprom_stop(sim_dev_t *dev){
+	sim_eeprom_t *e = (sim_eeprom_t *)dev;
+	
+	if(e->pending == 0) return;
+	
+	e->pending = 0;
+	e->addr_count = 0;
+	e->cycles++;
+	e->busy_until = sim_cycles() + (uint64_t)e->write_us * (F_CPU / 1000000UL);
+}
+
+void sim_eeprom_init(sim_eeprom_t *e, uint8_t addr, uint8_t *mem, uint32_t size, uint16_t page, uint8_t addr_bytes, uint32_t write_us){
+	memset(e, 0, sizeof(*e));
+	e->dev.addr = addr;
+	e->dev.start = eeprom_start;
+	e->dev.write = eeprom_write;
+	e->dev.read = eeprom_read;
+	e->dev.stop = eeprom_stop;
+	e->mem = mem;
+	e->size = size;
+	e->page = page;
+	e->addr_bytes = addr_bytes;
+	e->write_us = write_us;
+}
+
+/*
+ * NACKing device
+ */
+static uint8_t nack_start(sim_dev_t *dev, uint8_t rw){
+	sim_nack_t *n = (sim_nack_t *)dev;
+	
+	(void)rw;
+	n->count = 0;
+	return n->nack_after != 0;
+}
+
+static uint8_t nack_write(sim_dev_t *dev, uint8_t data){
+	sim_nack_t *n = (sim_nack_t *)dev;
+	
+	(void)data;
+	return ++n->count < n->nack_after;
+}
+
+void sim_nack_init(sim_nack_t *n, uint8_t addr, uint8_t nack_after){
+	memset(n, 0, sizeof(*n));
+	n->dev.addr = addr;
+	n->dev.start = nack_start;
+	n->dev.write = nack_write;
+	n->nack_after = nack_after;
+}
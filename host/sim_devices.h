@@ -0,0 +1,94 @@
+/*
+ * File sim_devices.h
+ * Author: Tycho Jöbsis
+ * Date: 16-10-2026
+ */ 
+
+/*
+*	MIT License
+*
+*	Copyright (c) 2021 TychoJ
+*
+*	Permission is hereby granted, free of charge, to any person obtaining a copy
+*	of this software and associated documentation files (the "Software"), to deal
+*	in the Software without restriction, including without limitation the rights
+*	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*	copies of the Software, and to permit persons to whom the Software is
+*	furnished to do so, subject to the following conditions:
+*
+*	The above copyright notice and this permission notice shall be included in all
+*	copies or substantial portions of the Software.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*	SOFTWARE.
+*/
+
+#include <stdint.h>
+#include "sim.h"
+
+#ifndef SIM_DEVICES_H_
+#define SIM_DEVICES_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Virtual slaves for the simulated bus
+ * every device embeds a sim_dev_t as first member, attach it with sim_attach(twi, &dev.dev)
+ */
+
+//a device with 256 registers, the first byte of a write sets the register pointer
+//the pointer increments after every byte, a read starts at the pointer
+//a clock stretcher is a register file with dev.stretch_ns set, SIM_STUCK holds SCL forever
+typedef struct sim_regfile {
+	sim_dev_t dev;
+	uint8_t regs[256];
+	uint8_t ptr;
+	uint8_t pointer_set;	//the next written byte is data
+	uint8_t writes;			//data bytes of the last write
+} sim_regfile_t;
+
+void sim_regfile_init(sim_regfile_t *r, uint8_t addr);
+
+//a 24Cxx EEPROM, the address is addr_bytes long and written bytes wrap inside a page
+//after the stop of a write the device NACKs its address for write_us
+typedef struct sim_eeprom {
+	sim_dev_t dev;
+	uint8_t *mem;
+	uint32_t size;
+	uint16_t page;
+	uint8_t addr_bytes;
+	uint32_t write_us;
+	uint32_t ptr;
+	uint8_t addr_count;		//address bytes received in this write
+	uint64_t busy_until;	//end of the write cycle in cycles
+	uint16_t pending;		//data bytes waiting for the stop
+	uint8_t buf[256];
+	uint32_t buf_addr;
+	uint32_t cycles;		//write cycles done
+	uint32_t busy_nacks;	//addresses NACKed during a write cycle
+	uint32_t wraps;			//writes that wrapped around the end of a page
+} sim_eeprom_t;
+
+void sim_eeprom_init(sim_eeprom_t *e, uint8_t addr, uint8_t *mem, uint32_t size, uint16_t page, uint8_t addr_bytes, uint32_t write_us);
+
+//NACKs its address, or with nack_after > 0 the byte nack_after of a write
+typedef struct sim_nack {
+	sim_dev_t dev;
+	uint8_t nack_after;
+	uint8_t count;
+} sim_nack_t;
+
+void sim_nack_init(sim_nack_t *n, uint8_t addr, uint8_t nack_after);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SIM_DEVICES_H_ */
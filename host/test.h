@@ -0,0 +1,91 @@
+/*
+ * File test.h
+ * Author: Tycho Jöbsis
+ * Date: 16-10-2026
+ */ 
+
+/*
+*	MIT License
+*
+*	Copyright (c) 2021 TychoJ
+*
+*	Permission is hereby granted, free of charge, to any person obtaining a copy
+*	of this software and associated documentation files (the "Software"), to deal
+*	in the Software without restriction, including without limitation the rights
+*	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*	copies of the Software, and to permit persons to whom the Software is
+*	furnished to do so, subject to the following conditions:
+*
+*	The above copyright notice and this permission notice shall be included in all
+*	copies or substantial portions of the Software.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*	SOFTWARE.
+*/
+
+#include <stdio.h>
+#include "sim.h"
+
+#ifndef TEST_H_
+#define TEST_H_
+
+/*
+ * Checks for the host tests, every test runs on a freshly reset simulator
+ */
+
+static int test_failed;
+static const char *test_name __attribute__((unused));	//not used by the benchmarks
+
+#define CHECK(cond)	do{ \
+	if( !(cond) ){ \
+		printf("%s:%d: %s: CHECK(%s) failed\n", __FILE__, __LINE__, test_name, #cond); \
+		test_failed++; \
+	} \
+}while(0)
+
+#define CHECK_EQ(a, b)	do{ \
+	long long check_a = (long long)(a); \
+	long long check_b = (long long)(b); \
+	if(check_a != check_b){ \
+		printf("%s:%d: %s: CHECK_EQ(%s, %s) failed, %lld != %lld\n", __FILE__, __LINE__, test_name, #a, #b, check_a, check_b); \
+		test_failed++; \
+	} \
+}while(0)
+
+#define RUN(test)	do{ \
+	test_name = #test; \
+	sim_reset(); \
+	test(); \
+}while(0)
+
+static inline int test_result(const char *family){
+	if(test_failed) printf("%s: %d checks failed\n", family, test_failed);
+	else printf("%s: all tests passed\n", family);
+	return test_failed ? 1 : 0;
+}
+
+//module, deadline timer, periodic timer and vectors used by the tests
+#ifdef SIM_TINY
+#define TEST_FAMILY		"tiny"
+#define TEST_TWI		(&TWI0)
+#define TEST_TC			(&TCB0)
+#define TEST_TICK_TC	(&TCB1)
+#define TEST_TICK_vect	TCB1_INT_vect
+#define TEST_TWIM_vect	TWI0_TWIM_vect
+#define TEST_TWIS_vect	TWI0_TWIS_vect
+#else
+#define TEST_FAMILY		"xmega"
+#define TEST_TWI		(&TWIE)
+#define TEST_TC			(&TCC0)
+#define TEST_TICK_TC	(&TCD0)
+#define TEST_TICK_vect	TCD0_OVF_vect
+#define TEST_TWIM_vect	TWIE_TWIM_vect
+#define TEST_TWIS_vect	TWIE_TWIS_vect
+#endif
+
+#endif /* TEST_H_ */
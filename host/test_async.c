@@ -0,0 +1,470 @@
+/*
+ * File test_async.c
+ * Author: Tycho Jöbsis
+ * Date: 16-10-2026
+ */ 
+
+/*
+*	MIT License
+*
+*	Copyright (c) 2021 TychoJ
+*
+*	Permission is hereby granted, free of charge, to any person obtaining a copy
+*	of this software and associated documentation files (the "Software"), to deal
+*	in the Software without restriction, including without limitation the rights
+*	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*	copies of the Software, and to permit persons to whom the Software is
+*	furnished to do so, subject to the following conditions:
+*
+*	The above copyright notice and this permission notice shall be included in all
+*	copies or substantial portions of the Software.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*	SOFTWARE.
+*/
+
+#include <string.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "twi.h"
+#include "twi_async.h"
+#include "twi_sched.h"
+#include "twi_smbus.h"
+#include "sim.h"
+#include "sim_devices.h"
+#include "test.h"
+
+/*
+ * Interrupt engine of twi_async.c and the blocking functions on a module it is registered for
+ */
+
+#ifdef SIM_TINY
+#define TEST_BUS twi0_bus
+#else
+#define TEST_BUS twie_bus
+#endif
+
+static sim_regfile_t dev;
+static sim_regfile_t other;
+
+static void setup(void){
+	sim_regfile_init(&dev, 0x40);
+	sim_regfile_init(&other, 0x41);
+	sim_attach(TEST_TWI, &dev.dev);
+	sim_attach(TEST_TWI, &other.dev);
+	set_deadline_timer_TWI(TEST_TC);
+	set_deadline_TWI(500);
+	enable_TWI(TEST_TWI, BAUD_400K, TIMEOUT_DIS);
+	twi_async_init(&TEST_BUS, TEST_TWI, TWI_INTLVL_LO);
+	sei();
+}
+
+static void test_queue(void){
+	uint8_t reg = 0x10;
+	uint8_t out[3] = { 0x10, 0xA1, 0xA2 };
+	uint8_t in[2] = { 0, 0 };
+	twi_transaction_t write, read;
+	twi_transaction_t *all[2] = { &write, &read };
+	
+	setup();
+	twi_async_prepare(&write, 0x40, out, sizeof(out), 0, 0, 0);
+	twi_async_prepare(&read, 0x40, &reg, 1, in, sizeof(in), 0);
+	twi_async_submit(&TEST_BUS, &write);
+	twi_async_submit(&TEST_BUS, &read);
+	
+	CHECK_EQ(twi_async_wait_all(all, 2), TWI_STATUS_OK);
+	CHECK_EQ(in[0], 0xA1);
+	CHECK_EQ(in[1], 0xA2);
+	CHECK_EQ(twi_async_busy(&TEST_BUS), 0);
+	CHECK_EQ(sim_counters(TEST_TWI)->violations, 0);
+}
+
+static void test_smart_mode(void){
+	uint8_t reg = 0x00;
+	uint8_t in[4];
+	uint8_t i;
+	twi_transaction_t first, second;
+	
+	setup();
+	set_timeout(TEST_TWI, TIMEOUT_DIS | TWI_SMART_MODE);
+	for(i = 0; i < 8; i++) dev.regs[i] = 0x60 + i;
+	
+	//the last byte is NACKed before DATA is read, held transactions don't inherit the NACK
+	twi_async_set_hold(&TEST_BUS, 1);
+	twi_async_prepare(&first, 0x40, &reg, 1, in, 2, 0);
+	twi_async_prepare(&second, 0x40, 0, 0, in + 2, 2, 0);
+	twi_async_submit(&TEST_BUS, &first);
+	twi_async_submit(&TEST_BUS, &second);
+	CHECK_EQ(twi_async_wait(&second), TWI_STATUS_OK);
+	CHECK_EQ(first.status, TWI_STATUS_OK);
+	for(i = 0; i < sizeof(in); i++) CHECK_EQ(in[i], 0x60 + i);
+	
+	CHECK_EQ(dev.dev.bytes_out, 4);
+	CHECK_EQ(sim_counters(TEST_TWI)->rstarts, 2);
+	CHECK_EQ(sim_counters(TEST_TWI)->violations, 0);
+}
+
+//a register file that gets stuck once it is addressed for a read
+static uint8_t stuck_read_start(sim_dev_t *d, uint8_t rw){
+	if(rw == READ) d->stretch_ns = SIM_STUCK;
+	return 1;
+}
+
+static void test_timeout(void){
+	uint8_t out[2] = { 0x20, 0x55 };
+	uint8_t in = 0;
+	twi_transaction_t stuck, next;
+	uint64_t start;
+	
+	setup();
+	
+	//a stuck write ends at the deadline and the queued transaction still runs
+	dev.dev.stretch_ns = SIM_STUCK;
+	twi_async_prepare(&stuck, 0x40, out, sizeof(out), 0, 0, 0);
+	twi_async_prepare(&next, 0x41, out, sizeof(out), 0, 0, 0);
+	twi_async_submit(&TEST_BUS, &stuck);
+	twi_async_submit(&TEST_BUS, &next);
+	
+	start = sim_time_ns();
+	CHECK_EQ(twi_async_wait(&stuck), DATA_NOT_SEND);
+	CHECK(sim_time_ns() - start >= 500000);
+	CHECK(sim_time_ns() - start < 600000);
+	CHECK_EQ(twi_async_wait(&next), TWI_STATUS_OK);
+	CHECK_EQ(other.regs[0x20], 0x55);
+	
+	//a read that never gets its byte
+	dev.dev.stretch_ns = 0;
+	dev.dev.start = stuck_read_start;
+	twi_async_prepare(&stuck, 0x40, 0, 0, &in, 1, 0);
+	twi_async_prepare(&next, 0x41, out, sizeof(out), 0, 0, 0);
+	twi_async_submit(&TEST_BUS, &stuck);
+	twi_async_submit(&TEST_BUS, &next);
+	CHECK_EQ(twi_async_wait(&stuck), DATA_NOT_RECEIVED);
+	CHECK_EQ(twi_async_wait(&next), TWI_STATUS_OK);
+	CHECK_EQ(bus_state(TEST_TWI), BUS_NOT_IN_USE);
+}
+
+static void test_blocking(void){
+	uint8_t data = 0;
+	uint8_t out[2] = { 0x30, 0x77 };
+	uint8_t reg = 0x30;
+	twi_segment_t seg[2] = {
+		{ 0x40, WRITE, &reg, 1 },
+		{ 0x40, READ, &data, 1 },
+	};
+	
+	setup();
+	
+	//the flags are left to the blocking functions, the empty queue only turns the interrupt off
+	CHECK_EQ(start_TWI(TEST_TWI, 0x40, WRITE), ACK);
+	CHECK_EQ(send_TWI(TEST_TWI, 0x30), ACK);
+	CHECK_EQ(send_TWI(TEST_TWI, 0x66), ACK);
+	stop_TWI(TEST_TWI);
+	CHECK_EQ(dev.regs[0x30], 0x66);
+	
+	CHECK_EQ(start_TWI(TEST_TWI, 0x40, WRITE), ACK);
+	CHECK_EQ(send_TWI(TEST_TWI, 0x30), ACK);
+	CHECK_EQ(repeated_start_TWI(TEST_TWI, 0x40, READ), ACK);
+	CHECK_EQ(read_TWI(TEST_TWI, &data, NACK), TWI_STATUS_OK);
+	CHECK_EQ(data, 0x66);
+	
+	seg[0].data = out;
+	seg[0].len = 2;
+	CHECK_EQ(transfer_TWI(TEST_TWI, seg, 1), TWI_STATUS_OK);
+	seg[0].data = &reg;
+	seg[0].len = 1;
+	CHECK_EQ(transfer_TWI(TEST_TWI, seg, 2), TWI_STATUS_OK);
+	CHECK_EQ(data, 0x77);
+	
+	//the interrupt of the engine wakes a blocking function that sleeps
+	set_sleep_TWI(1, TWI_INTLVL_LO);
+	dev.regs[0x31] = 0x5C;
+	CHECK_EQ(read_8bit_register_TWI(TEST_TWI, 0x40, &data, 0x31), TWI_STATUS_OK);
+	CHECK_EQ(start_TWI(TEST_TWI, 0x40, WRITE), ACK);
+	CHECK_EQ(send_TWI(TEST_TWI, 0x31), ACK);
+	CHECK_EQ(repeated_start_TWI(TEST_TWI, 0x40, READ), ACK);
+	CHECK_EQ(read_TWI(TEST_TWI, &data, NACK), TWI_STATUS_OK);
+	CHECK_EQ(data, 0x5C);
+	CHECK(sim.sleep_time > 0);
+	set_sleep_TWI(0, TWI_INTLVL_LO);
+	
+	CHECK_EQ(probe_TWI(TEST_TWI, 0x40), ACK);
+	CHECK_EQ(probe_TWI(TEST_TWI, 0x50), NACK);
+	CHECK_EQ(quick_command_TWI(TEST_TWI, 0x41, WRITE), ACK);
+	CHECK_EQ(sim_counters(TEST_TWI)->violations, 0);
+}
+
+static void test_claim(void){
+	uint8_t out[2] = { 0x40, 0x12 };
+	uint8_t in = 0;
+	uint8_t data;
+	twi_transaction_t first, queued;
+	
+	setup();
+	
+	//a blocking start waits until the queue is finished
+	twi_async_prepare(&first, 0x40, out, sizeof(out), 0, 0, 0);
+	twi_async_submit(&TEST_BUS, &first);
+	CHECK_EQ(start_TWI(TEST_TWI, 0x41, WRITE), ACK);
+	CHECK_EQ(twi_async_done(&first), 1);
+	CHECK_EQ(first.status, TWI_STATUS_OK);
+	
+	//a transaction submitted during the blocking sequence waits for the stop
+	twi_async_prepare(&queued, 0x40, out, 1, &in, 1, 0);
+	twi_async_submit(&TEST_BUS, &queued);
+	sim_run_ns(1000000);
+	CHECK_EQ(twi_async_done(&queued), 0);
+	CHECK_EQ(read_8bit_register_TWI(TEST_TWI, 0x40, &data, 0x40), OWNER_OF_BUS);
+	CHECK_EQ(send_TWI(TEST_TWI, 0x01), ACK);
+	stop_TWI(TEST_TWI);
+	
+	CHECK_EQ(twi_async_wait(&queued), TWI_STATUS_OK);
+	CHECK_EQ(in, 0x12);
+	
+	//the register functions use the engine again
+	CHECK_EQ(read_8bit_register_TWI(TEST_TWI, 0x40, &data, 0x40), TWI_STATUS_OK);
+	CHECK_EQ(data, 0x12);
+	CHECK_EQ(sim_counters(TEST_TWI)->violations, 0);
+}
+
+//submits late when the device is addressed for a read, in the middle of an SMBus read
+static twi_transaction_t *late;
+
+static uint8_t submit_on_read(sim_dev_t *d, uint8_t rw){
+	if(rw == WRITE) ((sim_regfile_t *)d)->pointer_set = 0;
+	if( (rw == READ) && (late != 0) ){
+		twi_async_submit(&TEST_BUS, late);
+		late = 0;
+	}
+	return 1;
+}
+
+//the byte after the address is lost to another master
+static uint8_t lose_after_start(sim_dev_t *d, uint8_t rw){
+	if(rw == WRITE) ((sim_regfile_t *)d)->pointer_set = 0;
+	sim_inject(TEST_TWI, SIM_INJECT_ARBLOST);
+	return 1;
+}
+
+static void test_smbus(void){
+	uint8_t out[2] = { 0x50, 0x11 };
+	uint8_t data = 0;
+	uint16_t word = 0;
+	twi_transaction_t first, during;
+	twi_smbus_t psu;
+	uint64_t start_ns;
+	
+	setup();
+	twi_smbus_init(&psu, TEST_TWI, 0x40, 0);
+	
+	//a queued transaction finishes before the transfer
+	twi_async_prepare(&first, 0x41, out, sizeof(out), 0, 0, 0);
+	twi_async_submit(&TEST_BUS, &first);
+	CHECK_EQ(twi_smbus_write_word(&psu, 0x50, 0xBEEF), TWI_STATUS_OK);
+	CHECK_EQ(twi_async_done(&first), 1);
+	CHECK_EQ(first.status, TWI_STATUS_OK);
+	
+	//one submitted during the transfer waits for its stop
+	dev.dev.start = submit_on_read;
+	late = &during;
+	twi_async_prepare(&during, 0x41, out, sizeof(out), 0, 0, 0);
+	CHECK_EQ(twi_smbus_read_word(&psu, 0x50, &word), TWI_STATUS_OK);
+	CHECK_EQ(word, 0xBEEF);
+	CHECK_EQ(late, 0);
+	CHECK_EQ(twi_async_wait(&during), TWI_STATUS_OK);
+	CHECK_EQ(other.regs[0x50], 0x11);
+	
+	//a transfer that loses the bus without a stop gives the module back to the engine
+	dev.dev.start = lose_after_start;
+	CHECK_EQ(twi_smbus_write_byte(&psu, 0x51, 0x22), TWI_ARB_LOST);
+	sim_run_ns(1000000);
+	dev.dev.start = 0;
+	out[1] = 0x33;
+	twi_async_prepare(&first, 0x41, out, sizeof(out), 0, 0, 0);
+	twi_async_submit(&TEST_BUS, &first);
+	CHECK_EQ(twi_async_wait(&first), TWI_STATUS_OK);
+	CHECK_EQ(other.regs[0x50], 0x33);
+	
+	//a stuck slave is given up after the SMBus timeout, the deadline is restored
+	dev.dev.stretch_ns = SIM_STUCK;
+	start_ns = sim_time_ns();
+	CHECK_EQ(twi_smbus_read_byte(&psu, 0x50, &data), DATA_NOT_SEND);
+	CHECK(sim_time_ns() - start_ns >= (uint64_t)TWI_SMBUS_TIMEOUT_US * 1000);
+	CHECK(sim_time_ns() - start_ns < (uint64_t)TWI_SMBUS_TIMEOUT_US * 1000 + 100000);
+	CHECK_EQ(get_deadline_TWI(), 500);
+	dev.dev.stretch_ns = 0;
+	CHECK_EQ(twi_smbus_read_byte(&psu, 0x50, &data), TWI_STATUS_OK);
+	CHECK_EQ(data, 0xEF);
+	CHECK_EQ(bus_state(TEST_TWI), BUS_NOT_IN_USE);
+}
+
+static void test_device_speed(void){
+	uint8_t out[2] = { 0x60, 0x01 };
+	twi_transaction_t a, b, c;
+	twi_transaction_t *all[3] = { &a, &b, &c };
+	
+	setup();
+	CHECK_EQ(set_device_speed_TWI(TEST_TWI, 0x41, BAUD_100K), TWI_STATUS_OK);
+	
+	//the interrupt never waits for a stop to change the speed
+	twi_async_prepare(&a, 0x40, out, sizeof(out), 0, 0, 0);
+	twi_async_prepare(&b, 0x41, out, sizeof(out), 0, 0, 0);
+	twi_async_prepare(&c, 0x40, out, sizeof(out), 0, 0, 0);
+	twi_async_submit(&TEST_BUS, &a);
+	twi_async_submit(&TEST_BUS, &b);
+	twi_async_submit(&TEST_BUS, &c);
+	CHECK_EQ(twi_async_wait_all(all, 3), TWI_STATUS_OK);
+	CHECK_EQ(other.regs[0x60], 0x01);
+	CHECK_EQ(TWI_M_BAUD(TEST_TWI), TWI_BAUD(F_CPU, BAUD_400K));
+	CHECK(sim.isr_max * 1000000000ULL / F_CPU < 10000);	//shorter than a bit at 100 kHz
+	
+	//the speed can't change while another master has the bus, the transaction waits for it
+	sim_other_master(TEST_TWI, 200000);
+	twi_async_submit(&TEST_BUS, &b);
+	CHECK_EQ(TWI_M_BAUD(TEST_TWI), TWI_BAUD(F_CPU, BAUD_400K));
+	CHECK_EQ(twi_async_done(&b), 0);
+	CHECK_EQ(twi_async_wait(&b), TWI_STATUS_OK);
+	CHECK_EQ(TWI_M_BAUD(TEST_TWI), TWI_BAUD(F_CPU, BAUD_100K));
+	CHECK_EQ(sim_counters(TEST_TWI)->violations, 0);
+}
+
+static uint8_t job_order[8];
+static uint8_t jobs_done;
+
+static void job_finished(twi_job_t *job){
+	job_order[jobs_done++] = job->addr;
+}
+
+static void test_sched(void){
+	twi_sched_t sched;
+	twi_job_t first, a, b, c, urgent;
+	twi_job_t *const equal[3] = { &a, &b, &c };
+	uint8_t buf[32];
+	uint8_t small[2];
+	sim_regfile_t more[3];
+	uint8_t i;
+	
+	setup();
+	sim_regfile_init(&more[0], 0x42);
+	sim_regfile_init(&more[1], 0x43);
+	sim_regfile_init(&more[2], 0x44);
+	for(i = 0; i < 3; i++) sim_attach(TEST_TWI, &more[i].dev);
+	twi_sched_init(&sched, &TEST_BUS);
+	jobs_done = 0;
+	
+	//a deadline past half a turn of the timer is refused
+	twi_sched_prepare(&a, 0x42, 0x00, 1, small, sizeof(small), WRITE, 0);
+	CHECK_EQ(twi_sched_submit(&sched, &a, TWI_PRIO_NORMAL, TWI_SCHED_DEADLINE_MAX_US + 1, job_finished), TWI_OUT_OF_RANGE);
+	CHECK_EQ(a.status, TWI_OUT_OF_RANGE);
+	
+	//jobs with the same class and deadline go in the order they were submitted
+	twi_sched_prepare(&first, 0x40, 0x00, 1, buf, sizeof(buf), WRITE, 8);
+	twi_sched_submit(&sched, &first, TWI_PRIO_BULK, 2000, job_finished);
+	for(i = 0; i < 3; i++) twi_sched_prepare(equal[i], 0x42 + i, 0x00, 1, small, sizeof(small), WRITE, 0);
+	
+	cli();
+	twi_sched_submit(&sched, &a, TWI_PRIO_NORMAL, 1000, job_finished);
+	twi_sched_submit(&sched, &b, TWI_PRIO_NORMAL, 1000, job_finished);
+	twi_sched_submit(&sched, &c, TWI_PRIO_NORMAL, 1000, job_finished);
+	b.deadline = a.deadline;	//the timer may have moved on between the calls
+	c.deadline = a.deadline;
+	
+	//a critical job goes before them, after the chunk of the bulk job that is on the bus
+	twi_sched_prepare(&urgent, 0x41, 0x10, 1, small, sizeof(small), READ, 0);
+	twi_sched_submit(&sched, &urgent, TWI_PRIO_CRITICAL, 1000, job_finished);
+	sei();
+	
+	while(jobs_done < 5) sim_run_ns(10000);
+	CHECK_EQ(job_order[0], 0x41);
+	CHECK_EQ(job_order[1], 0x42);
+	CHECK_EQ(job_order[2], 0x43);
+	CHECK_EQ(job_order[3], 0x44);
+	CHECK_EQ(job_order[4], 0x40);
+	CHECK_EQ(first.status, TWI_STATUS_OK);
+	CHECK_EQ(urgent.status, TWI_STATUS_OK);
+	CHECK_EQ(twi_sched_missed(&sched), 0);
+	CHECK_EQ(sim_counters(TEST_TWI)->violations, 0);
+}
+
+//one turn of the deadline timer in ns, 16.4 ms on the Xmega and 6.5 ms on the tinyAVR
+#define TIMER_TURN_NS	(65536ULL * TWI_TIMER_DIV * 1000000000ULL / F_CPU)
+
+//jobs that wait between half and a whole turn of the timer past their deadline
+static void test_sched_late(void){
+	twi_sched_t sched;
+	twi_job_t first, old, new;
+	uint8_t small[2];
+	sim_regfile_t more[2];
+	
+	setup();
+	sim_regfile_init(&more[0], 0x42);
+	sim_regfile_init(&more[1], 0x43);
+	sim_attach(TEST_TWI, &more[0].dev);
+	sim_attach(TEST_TWI, &more[1].dev);
+	twi_sched_init(&sched, &TEST_BUS);
+	jobs_done = 0;
+	
+	//the bus is held, the first job waits on it and the old one waits behind it
+	twi_async_claim(TEST_TWI);
+	twi_sched_prepare(&first, 0x43, 0x00, 1, small, sizeof(small), WRITE, 0);
+	twi_sched_submit(&sched, &first, TWI_PRIO_NORMAL, 1000, job_finished);
+	twi_sched_prepare(&old, 0x40, 0x00, 1, small, sizeof(small), WRITE, 0);
+	twi_sched_submit(&sched, &old, TWI_PRIO_NORMAL, 1000, job_finished);
+	sim_run_ns(1000000UL + TIMER_TURN_NS * 3 / 4);
+	
+	//a new job with the same deadline goes after the overdue one
+	twi_sched_prepare(&new, 0x42, 0x00, 1, small, sizeof(small), WRITE, 0);
+	twi_sched_submit(&sched, &new, TWI_PRIO_NORMAL, 1000, job_finished);
+	twi_async_release(TEST_TWI);
+	
+	while(jobs_done < 3) sim_run_ns(10000);
+	CHECK_EQ(job_order[0], 0x43);
+	CHECK_EQ(job_order[1], 0x40);
+	CHECK_EQ(job_order[2], 0x42);
+	CHECK_EQ(first.missed, 1);
+	CHECK_EQ(old.missed, 1);
+	CHECK_EQ(new.missed, 0);
+	CHECK_EQ(old.status, TWI_STATUS_OK);
+	CHECK_EQ(twi_sched_missed(&sched), 2);
+	CHECK_EQ(sim_counters(TEST_TWI)->violations, 0);
+}
+
+static void test_polled(void){
+	twi_async_bus_t polled;
+	uint8_t out[2] = { 0x50, 0x34 };
+	twi_transaction_t t;
+	
+	setup();
+	cli();
+	twi_async_init(&polled, TEST_TWI, TWI_ASYNC_POLLED);
+	
+	//waiting steps the bus, nothing else would
+	twi_async_prepare(&t, 0x40, out, sizeof(out), 0, 0, 0);
+	CHECK_EQ(twi_async_transfer(&polled, &t), TWI_STATUS_OK);
+	CHECK_EQ(dev.regs[0x50], 0x34);
+	
+	dev.dev.stretch_ns = SIM_STUCK;
+	CHECK_EQ(twi_async_transfer(&polled, &t), DATA_NOT_SEND);
+}
+
+int main(void){
+	sim_init();
+	
+	RUN(test_queue);
+	RUN(test_smart_mode);
+	RUN(test_timeout);
+	RUN(test_blocking);
+	RUN(test_claim);
+	RUN(test_sched);
+	RUN(test_sched_late);
+	RUN(test_polled);
+	RUN(test_device_speed);
+	RUN(test_smbus);
+	
+	return test_result(TEST_FAMILY);
+}
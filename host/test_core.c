@@ -0,0 +1,601 @@
+/*
+ * File test_core.c
+ * Author: Tycho Jöbsis
+ * Date: 16-10-2026
+ */ 
+
+/*
+*	MIT License
+*
+*	Copyright (c) 2021 TychoJ
+*
+*	Permission is hereby granted, free of charge, to any person obtaining a copy
+*	of this software and associated documentation files (the "Software"), to deal
+*	in the Software without restriction, including without limitation the rights
+*	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*	copies of the Software, and to permit persons to whom the Software is
+*	furnished to do so, subject to the following conditions:
+*
+*	The above copyright notice and this permission notice shall be included in all
+*	copies or substantial portions of the Software.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*	SOFTWARE.
+*/
+
+#include <string.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "twi.h"
+#include "twi_stats.h"
+#include "sim.h"
+#include "sim_devices.h"
+#include "test.h"
+
+/*
+ * Blocking functions of twi.c against the virtual slaves
+ */
+
+static sim_regfile_t dev;
+
+ISR(TEST_TWIM_vect){
+	twi_sleep_wake(TEST_TWI);
+}
+
+static void setup(uint32_t speed){
+	sim_regfile_init(&dev, 0x40);
+	sim_attach(TEST_TWI, &dev.dev);
+	set_deadline_timer_TWI(0);
+	set_deadline_TWI(TWI_DEADLINE_DEFAULT_US);
+	set_retries_TWI(0, 0);
+	set_multi_master_TWI(0);
+	enable_TWI(TEST_TWI, speed, TIMEOUT_DIS);
+}
+
+static void test_enable(void){
+	setup(BAUD_100K);
+	
+	CHECK_EQ(bus_state(TEST_TWI), BUS_NOT_IN_USE);
+	CHECK_EQ(TWI_M_BAUD(TEST_TWI), TWI_BAUD(F_CPU, BAUD_100K));
+	
+	//the SCL period follows the baud register
+	CHECK(sim_bit_ns(TEST_TWI) >= 10000);
+	CHECK(sim_bit_ns(TEST_TWI) < 10500);
+	
+	CHECK_EQ(set_baud(TEST_TWI, 10), TWI_INVALID_BAUD);
+}
+
+static void test_write_read_register(void){
+	uint8_t data = 0;
+	
+	setup(BAUD_400K);
+	
+	CHECK_EQ(write_8bit_register_TWI(TEST_TWI, 0x40, 0xA5, 0x10), TWI_STATUS_OK);
+	CHECK_EQ(dev.regs[0x10], 0xA5);
+	
+	dev.regs[0x20] = 0x5A;
+	CHECK_EQ(read_8bit_register_TWI(TEST_TWI, 0x40, &data, 0x20), TWI_STATUS_OK);
+	CHECK_EQ(data, 0x5A);
+	
+	CHECK_EQ(send_8bit_TWI(TEST_TWI, 0x40, 0x33), TWI_STATUS_OK);
+	CHECK_EQ(dev.ptr, 0x33);
+	
+	CHECK_EQ(sim_counters(TEST_TWI)->starts, 3);
+	CHECK_EQ(sim_counters(TEST_TWI)->stops, 3);
+	CHECK_EQ(sim_counters(TEST_TWI)->violations, 0);
+	CHECK_EQ(bus_state(TEST_TWI), BUS_NOT_IN_USE);
+}
+
+static void test_registers(void){
+	uint8_t out[8] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+	uint8_t in[8];
+	
+	setup(BAUD_400K);
+	
+	CHECK_EQ(write_registers_TWI(TEST_TWI, 0x40, out, 0x80, sizeof(out)), TWI_STATUS_OK);
+	CHECK(memcmp(&dev.regs[0x80], out, sizeof(out)) == 0);
+	
+	memset(in, 0, sizeof(in));
+	CHECK_EQ(read_registers_TWI(TEST_TWI, 0x40, in, 0x80, sizeof(in)), TWI_STATUS_OK);
+	CHECK(memcmp(in, out, sizeof(in)) == 0);
+	
+	//the master ACKs every byte but the last
+	CHECK_EQ(dev.dev.bytes_out, sizeof(in));
+	CHECK_EQ(sim_counters(TEST_TWI)->violations, 0);
+}
+
+static void test_smart_mode(void){
+	uint8_t in[6];
+	uint8_t i;
+	
+	sim_regfile_init(&dev, 0x40);
+	sim_attach(TEST_TWI, &dev.dev);
+	enable_TWI(TEST_TWI, BAUD_400K, TIMEOUT_DIS | TWI_SMART_MODE);
+	
+	for(i = 0; i < sizeof(in); i++) dev.regs[i] = 0x30 + i;
+	
+	CHECK_EQ(read_registers_TWI(TEST_TWI, 0x40, in, 0, sizeof(in)), TWI_STATUS_OK);
+	for(i = 0; i < sizeof(in); i++) CHECK_EQ(in[i], 0x30 + i);
+	
+	//no byte past the last one is clocked
+	CHECK_EQ(dev.dev.bytes_out, sizeof(in));
+	CHECK_EQ(sim_counters(TEST_TWI)->violations, 0);
+}
+
+static void test_smart_transfer(void){
+	uint8_t reg = 0x08;
+	uint8_t a[2];
+	uint8_t b[3];
+	twi_segment_t seg[3] = {
+		{ 0x40, WRITE, &reg, 1 },
+		{ 0x40, READ, a, sizeof(a) },
+		{ 0x40, READ, b, sizeof(b) },
+	};
+	uint8_t i;
+	
+	sim_regfile_init(&dev, 0x40);
+	sim_attach(TEST_TWI, &dev.dev);
+	enable_TWI(TEST_TWI, BAUD_400K, TIMEOUT_DIS | TWI_SMART_MODE);
+	for(i = 0; i < 8; i++) dev.regs[0x08 + i] = i + 1;
+	
+	//the NACK that ends a segment is not left behind for the next one
+	CHECK_EQ(transfer_TWI(TEST_TWI, seg, 3), TWI_STATUS_OK);
+	CHECK_EQ(a[0], 1);
+	CHECK_EQ(a[1], 2);
+	CHECK_EQ(b[0], 3);
+	CHECK_EQ(b[1], 4);
+	CHECK_EQ(b[2], 5);
+	CHECK_EQ(dev.dev.bytes_out, 5);
+	CHECK_EQ(TWI_M_CMD(TEST_TWI) & TWI_M_ACKACT_bm, 0);
+	CHECK_EQ(sim_counters(TEST_TWI)->violations, 0);
+}
+
+static void test_quick_command(void){
+	uint8_t data = 0;
+	
+	setup(BAUD_400K);
+	dev.regs[0x02] = 0x5A;
+	
+	//quick command is only on for its own transaction
+	CHECK_EQ(quick_command_TWI(TEST_TWI, 0x40, READ), ACK);
+	CHECK_EQ(dev.dev.bytes_out, 0);
+	CHECK_EQ(TWI_M_MODE(TEST_TWI) & TWI_M_QCEN_bm, 0);
+	CHECK_EQ(quick_command_TWI(TEST_TWI, 0x41, READ), NACK);
+	CHECK_EQ(TWI_M_MODE(TEST_TWI) & TWI_M_QCEN_bm, 0);
+	
+	//a lost address isn't stopped, the flag is cleared for the next transaction
+	sim_inject(TEST_TWI, SIM_INJECT_ARBLOST);
+	CHECK_EQ(probe_TWI(TEST_TWI, 0x40), TWI_ARB_LOST);
+	CHECK_EQ(sim_counters(TEST_TWI)->stops, 2);
+	CHECK_EQ(TWI_M_STATUS(TEST_TWI) & TWI_M_ARBLOST_bm, 0);
+	CHECK_EQ(TWI_M_MODE(TEST_TWI) & TWI_M_QCEN_bm, 0);
+	sim_run_ns(100000);
+	
+	sim_inject(TEST_TWI, SIM_INJECT_BUSERR);
+	CHECK_EQ(probe_TWI(TEST_TWI, 0x40), TWI_BUS_ERROR);
+	CHECK_EQ(TWI_M_STATUS(TEST_TWI) & TWI_M_BUSERR_bm, 0);
+	sim_run_ns(100000);
+	
+	CHECK_EQ(probe_TWI(TEST_TWI, 0x40), ACK);
+	CHECK_EQ(sim_counters(TEST_TWI)->stops, 3);
+	CHECK_EQ(bus_state(TEST_TWI), BUS_NOT_IN_USE);
+	
+	CHECK_EQ(read_8bit_register_TWI(TEST_TWI, 0x40, &data, 0x02), TWI_STATUS_OK);
+	CHECK_EQ(data, 0x5A);
+	
+	//enable_TWI doesn't turn it on for the whole module
+	disable_TWI(TEST_TWI);
+	enable_TWI(TEST_TWI, BAUD_400K, TIMEOUT_DIS | TWI_QUICK_COMMAND);
+	CHECK_EQ(TWI_M_MODE(TEST_TWI) & TWI_M_QCEN_bm, 0);
+	CHECK_EQ(read_8bit_register_TWI(TEST_TWI, 0x40, &data, 0x02), TWI_STATUS_OK);
+	CHECK_EQ(data, 0x5A);
+	CHECK_EQ(sim_counters(TEST_TWI)->violations, 0);
+}
+
+static void test_transfer(void){
+	uint8_t reg = 0x08;
+	uint8_t a[2];
+	uint8_t b[3];
+	twi_segment_t seg[3] = {
+		{ 0x40, WRITE, &reg, 1 },
+		{ 0x40, READ, a, sizeof(a) },
+		{ 0x40, READ, b, sizeof(b) },
+	};
+	uint8_t i;
+	
+	setup(BAUD_100K);
+	for(i = 0; i < 8; i++) dev.regs[0x08 + i] = i + 1;
+	
+	CHECK_EQ(transfer_TWI(TEST_TWI, seg, 3), TWI_STATUS_OK);
+	CHECK_EQ(a[0], 1);
+	CHECK_EQ(a[1], 2);
+	CHECK_EQ(b[0], 3);
+	CHECK_EQ(b[2], 5);
+	CHECK_EQ(sim_counters(TEST_TWI)->rstarts, 2);
+	CHECK_EQ(sim_counters(TEST_TWI)->stops, 1);
+	CHECK_EQ(sim_counters(TEST_TWI)->violations, 0);
+}
+
+static void test_nack(void){
+	sim_nack_t nack;
+	
+	setup(BAUD_400K);
+	sim_nack_init(&nack, 0x21, 0);
+	sim_attach(TEST_TWI, &nack.dev);
+	
+	CHECK_EQ(send_8bit_TWI(TEST_TWI, 0x21, 0x00), NACK);
+	CHECK_EQ(probe_TWI(TEST_TWI, 0x21), NACK);
+	CHECK_EQ(probe_TWI(TEST_TWI, 0x40), ACK);
+	CHECK_EQ(probe_TWI(TEST_TWI, 0x55), NACK);
+	
+	CHECK_EQ(bus_state(TEST_TWI), BUS_NOT_IN_USE);
+	CHECK_EQ(write_8bit_register_TWI(TEST_TWI, 0x40, 0x77, 0x01), TWI_STATUS_OK);
+	CHECK_EQ(dev.regs[0x01], 0x77);
+}
+
+static void test_arbitration(void){
+	setup(BAUD_400K);
+	
+	sim_inject(TEST_TWI, SIM_INJECT_ARBLOST);
+	CHECK_EQ(start_TWI(TEST_TWI, 0x40, WRITE), TWI_ARB_LOST);
+	
+	//the other master is done after a while, a retry wins the bus
+	sim_run_ns(1000000);
+	set_retries_TWI(2, 50);
+	sim_inject(TEST_TWI, SIM_INJECT_ARBLOST);
+	set_multi_master_TWI(1);
+	CHECK_EQ(start_TWI(TEST_TWI, 0x40, WRITE), ACK);
+	stop_TWI(TEST_TWI);
+	
+	sim_run_ns(100000);
+	sim_inject(TEST_TWI, SIM_INJECT_BUSERR);
+	CHECK_EQ(start_TWI(TEST_TWI, 0x40, WRITE), TWI_BUS_ERROR);
+}
+
+static void test_other_master(void){
+	setup(BAUD_400K);
+	
+	sim_other_master(TEST_TWI, 200000);
+	CHECK_EQ(start_TWI(TEST_TWI, 0x40, WRITE), BUS_IN_USE);
+	
+	//with more masters start waits for the bus within the deadline
+	set_multi_master_TWI(1);
+	set_deadline_TWI(1000);
+	CHECK_EQ(write_8bit_register_TWI(TEST_TWI, 0x40, 0x11, 0x02), TWI_STATUS_OK);
+	CHECK_EQ(dev.regs[0x02], 0x11);
+}
+
+static void test_stuck(void){
+	uint64_t start;
+	
+	setup(BAUD_400K);
+	set_deadline_timer_TWI(TEST_TC);
+	set_deadline_TWI(500);
+	
+	dev.dev.stretch_ns = SIM_STUCK;
+	start = sim_time_ns();
+	CHECK_EQ(start_TWI(TEST_TWI, 0x40, WRITE), DATA_NOT_SEND);
+	
+	//the deadline ends the wait
+	CHECK(sim_time_ns() - start >= 500000);
+	CHECK(sim_time_ns() - start < 600000);
+	
+	stop_TWI(TEST_TWI);
+	dev.dev.stretch_ns = 0;
+	CHECK_EQ(write_8bit_register_TWI(TEST_TWI, 0x40, 0x22, 0x03), TWI_STATUS_OK);
+}
+
+static void test_long_deadline(void){
+	static const uint16_t deadlines[] = {25000, 30000, 65535};
+	uint64_t start, waited;
+	uint8_t i;
+	
+	setup(BAUD_400K);
+	set_deadline_timer_TWI(TEST_TC);
+	dev.dev.stretch_ns = SIM_STUCK;
+	
+	//the deadlines are longer than a turn of the timer
+	for(i = 0; i < sizeof(deadlines) / sizeof(deadlines[0]); i++){
+		set_deadline_TWI(deadlines[i]);
+		start = sim_time_ns();
+		CHECK_EQ(start_TWI(TEST_TWI, 0x40, WRITE), DATA_NOT_SEND);
+		
+		waited = sim_time_ns() - start;
+		CHECK(waited >= (uint64_t)deadlines[i] * 1000);
+		CHECK(waited < (uint64_t)deadlines[i] * 1000 + 100000);
+		stop_TWI(TEST_TWI);
+	}
+}
+
+static void test_start_errors(void){
+	uint8_t data = 0;
+	
+	setup(BAUD_400K);
+	set_deadline_timer_TWI(TEST_TC);
+	set_deadline_TWI(200);
+	
+	//a start that is not acknowledged in time is stopped
+	dev.dev.stretch_ns = SIM_STUCK;
+	CHECK_EQ(send_8bit_TWI(TEST_TWI, 0x40, 0x01), DATA_NOT_SEND);
+	CHECK_EQ(bus_state(TEST_TWI), BUS_NOT_IN_USE);
+	CHECK_EQ(write_registers_TWI(TEST_TWI, 0x40, &data, 0x00, 1), DATA_NOT_SEND);
+	CHECK_EQ(read_registers_TWI(TEST_TWI, 0x40, &data, 0x00, 1), DATA_NOT_SEND);
+	CHECK_EQ(bus_state(TEST_TWI), BUS_NOT_IN_USE);
+	dev.dev.stretch_ns = 0;
+	
+	//a bus that is still owned is not used for another transaction
+	CHECK_EQ(start_TWI(TEST_TWI, 0x40, WRITE), ACK);
+	CHECK_EQ(write_8bit_register_TWI(TEST_TWI, 0x40, 0x66, 0x06), OWNER_OF_BUS);
+	CHECK_EQ(read_8bit_register_TWI(TEST_TWI, 0x40, &data, 0x06), OWNER_OF_BUS);
+	CHECK_EQ(send_8bit_TWI(TEST_TWI, 0x40, 0x06), OWNER_OF_BUS);
+	CHECK_EQ(dev.regs[0x06], 0);
+	stop_TWI(TEST_TWI);
+	CHECK_EQ(sim_counters(TEST_TWI)->violations, 0);
+}
+
+//a register file that gets stuck once it is addressed for a read
+static uint8_t stuck_read_start(sim_dev_t *d, uint8_t rw){
+	if(rw == READ) d->stretch_ns = SIM_STUCK;
+	return 1;
+}
+
+//a register file that gets stuck after the first byte it sends
+static void stuck_after_ack(sim_dev_t *d, uint8_t ack){
+	if(ack) d->stretch_ns = SIM_STUCK;
+}
+
+static void test_burst_errors(void){
+	uint8_t out[4] = { 1, 2, 3, 4 };
+	uint8_t in[4];
+	sim_nack_t nack;
+	
+	setup(BAUD_400K);
+	set_deadline_timer_TWI(TEST_TC);
+	set_deadline_TWI(200);
+	sim_nack_init(&nack, 0x21, 3);
+	sim_attach(TEST_TWI, &nack.dev);
+	
+	//a NACKed data byte stops the bus
+	CHECK_EQ(write_registers_TWI(TEST_TWI, 0x21, out, 0x00, sizeof(out)), NACK);
+	CHECK_EQ(bus_state(TEST_TWI), BUS_NOT_IN_USE);
+	CHECK_EQ(write_8bit_register_TWI(TEST_TWI, 0x21, 0x01, 0x00), TWI_STATUS_OK);
+	nack.nack_after = 1;
+	CHECK_EQ(write_8bit_register_TWI(TEST_TWI, 0x21, 0x01, 0x00), NACK);
+	CHECK_EQ(bus_state(TEST_TWI), BUS_NOT_IN_USE);
+	CHECK_EQ(read_registers_TWI(TEST_TWI, 0x21, in, 0x00, sizeof(in)), NACK);
+	CHECK_EQ(bus_state(TEST_TWI), BUS_NOT_IN_USE);
+	
+	//the first byte of a read is part of the repeated start, it never arrives
+	dev.dev.start = stuck_read_start;
+	CHECK_EQ(read_registers_TWI(TEST_TWI, 0x40, in, 0x00, sizeof(in)), DATA_NOT_SEND);
+	CHECK_EQ(bus_state(TEST_TWI), BUS_NOT_IN_USE);
+	dev.dev.stretch_ns = 0;
+	CHECK_EQ(read_8bit_register_TWI(TEST_TWI, 0x40, in, 0x00), DATA_NOT_SEND);
+	CHECK_EQ(bus_state(TEST_TWI), BUS_NOT_IN_USE);
+	dev.dev.stretch_ns = 0;
+	
+	//a later byte never arrives
+	sim_regfile_init(&dev, 0x40);
+	dev.dev.ack = stuck_after_ack;
+	CHECK_EQ(read_registers_TWI(TEST_TWI, 0x40, in, 0x00, sizeof(in)), DATA_NOT_RECEIVED);
+	CHECK_EQ(bus_state(TEST_TWI), BUS_NOT_IN_USE);
+	CHECK_EQ(sim_counters(TEST_TWI)->violations, 0);
+}
+
+static void test_stretch(void){
+	uint64_t start;
+	uint64_t plain;
+	
+	setup(BAUD_400K);
+	
+	start = sim_time_ns();
+	CHECK_EQ(write_8bit_register_TWI(TEST_TWI, 0x40, 0x01, 0x00), TWI_STATUS_OK);
+	plain = sim_time_ns() - start;
+	
+	//every byte is held 50 us longer
+	dev.dev.stretch_ns = 50000;
+	start = sim_time_ns();
+	CHECK_EQ(write_8bit_register_TWI(TEST_TWI, 0x40, 0x01, 0x00), TWI_STATUS_OK);
+	CHECK(sim_time_ns() - start >= plain + 3 * 50000);
+}
+
+static void test_eeprom(void){
+	static uint8_t mem[4096];
+	sim_eeprom_t eeprom;
+	uint8_t page[4] = { 9, 8, 7, 6 };
+	uint8_t cmd[2] = { 0x01, 0xFE };
+	uint8_t first[2] = { 0xFE, 0x55 };
+	uint8_t in[4];
+	twi_segment_t seg[2] = {
+		{ 0x50, WRITE, cmd, 2 },
+		{ 0x50, READ, in, 4 },
+	};
+	uint8_t i;
+	
+	setup(BAUD_400K);
+	sim_eeprom_init(&eeprom, 0x50, mem, sizeof(mem), 32, 2, 5000);
+	sim_attach(TEST_TWI, &eeprom.dev);
+	
+	//the high address byte is the register, the device is busy after the stop
+	CHECK_EQ(write_registers_TWI(TEST_TWI, 0x50, first, 0x01, 2), TWI_STATUS_OK);
+	CHECK_EQ(mem[0x01FE], 0x55);
+	CHECK_EQ(start_TWI(TEST_TWI, 0x50, WRITE), NACK);
+	CHECK_EQ(eeprom.busy_nacks, 1);
+	sim_run_ns(5000000);
+	
+	//the page ends after 2 bytes, the rest wraps around to its start	
+	CHECK_EQ(start_TWI(TEST_TWI, 0x50, WRITE), ACK);
+	CHECK_EQ(send_TWI(TEST_TWI, 0x01), ACK);
+	CHECK_EQ(send_TWI(TEST_TWI, 0xFE), ACK);
+	for(i = 0; i < sizeof(page); i++) CHECK_EQ(send_TWI(TEST_TWI, page[i]), ACK);
+	stop_TWI(TEST_TWI);
+	
+	CHECK_EQ(eeprom.wraps, 1);
+	CHECK_EQ(mem[0x01FE], 9);
+	CHECK_EQ(mem[0x01FF], 8);
+	CHECK_EQ(mem[0x01E0], 7);
+	
+	sim_run_ns(5000000);
+	CHECK_EQ(transfer_TWI(TEST_TWI, seg, 2), TWI_STATUS_OK);
+	CHECK_EQ(in[0], 9);
+	CHECK_EQ(in[1], 8);
+}
+
+static void test_recover(void){
+#ifdef SIM_TINY
+	PORT_t *port = &PORTB;
+#else
+	PORT_t *port = &PORTE;
+#endif
+	
+	setup(BAUD_100K);
+	CHECK_EQ(recover_bus_TWI(TEST_TWI, port, PIN0_bm, PIN1_bm), TWI_STATUS_OK);
+	CHECK_EQ(bus_state(TEST_TWI), BUS_NOT_IN_USE);
+	CHECK_EQ(write_8bit_register_TWI(TEST_TWI, 0x40, 0x44, 0x04), TWI_STATUS_OK);
+}
+
+static void test_device_speed(void){
+	sim_regfile_t fast;
+	
+	setup(BAUD_100K);
+	sim_regfile_init(&fast, 0x41);
+	sim_attach(TEST_TWI, &fast.dev);
+	
+	CHECK_EQ(set_device_speed_TWI(TEST_TWI, 0x41, BAUD_400K), TWI_STATUS_OK);
+	CHECK_EQ(write_8bit_register_TWI(TEST_TWI, 0x41, 0x01, 0x00), TWI_STATUS_OK);
+	CHECK_EQ(TWI_M_BAUD(TEST_TWI), TWI_BAUD(F_CPU, BAUD_400K));
+	CHECK_EQ(write_8bit_register_TWI(TEST_TWI, 0x40, 0x01, 0x00), TWI_STATUS_OK);
+	CHECK_EQ(TWI_M_BAUD(TEST_TWI), TWI_BAUD(F_CPU, BAUD_100K));
+	CHECK_EQ(sim_counters(TEST_TWI)->violations, 0);
+}
+
+//another master may take the bus while start_TWI changes the speed
+static void test_speed_race(void){
+	sim_regfile_t fast;
+	uint32_t starts;
+	uint64_t t;
+	uint8_t refused = 0;
+	uint8_t won = 0;
+	uint8_t err;
+	uint8_t k;
+	
+	setup(BAUD_100K);
+	sim_regfile_init(&fast, 0x41);
+	sim_attach(TEST_TWI, &fast.dev);
+	CHECK_EQ(set_device_speed_TWI(TEST_TWI, 0x41, BAUD_400K), TWI_STATUS_OK);
+	
+	for(k = 0; k < 150; k++){
+		//back at the speed of the module
+		CHECK_EQ(write_8bit_register_TWI(TEST_TWI, 0x40, 0x01, 0x00), TWI_STATUS_OK);
+		sim_run_ns(100000);
+		
+		starts = sim_counters(TEST_TWI)->starts;
+		t = sim_time_ns();
+		sim_other_master_at(TEST_TWI, t + 20 * k, 20000);
+		err = start_TWI(TEST_TWI, 0x41, WRITE);
+		
+		//a start is never made at the speed of another device
+		if(err == ACK){
+			CHECK_EQ(TWI_M_BAUD(TEST_TWI), TWI_BAUD(F_CPU, BAUD_400K));
+			stop_TWI(TEST_TWI);
+			won++;
+		}
+		else{
+			CHECK_EQ(err, BUS_IN_USE);
+			CHECK_EQ(sim_counters(TEST_TWI)->starts, starts);
+			refused++;
+		}
+		sim_run_ns(50000);
+	}
+	
+	CHECK(refused > 0);
+	CHECK(won > 0);
+	CHECK_EQ(sim_counters(TEST_TWI)->violations, 0);
+}
+
+static void test_invalid_speed(void){
+	twi_speed_t speed;
+	
+	//the module stays off when the baud value doesn't fit
+	CHECK_EQ(enable_TWI(TEST_TWI, 5000, TIMEOUT_DIS), TWI_INVALID_BAUD);
+	CHECK_EQ(TWI_M_CTRL(TEST_TWI) & TWI_M_ENABLE_bm, 0);
+	CHECK_EQ(enable_TWI(TEST_TWI, BAUD_400K, TIMEOUT_DIS), TWI_STATUS_OK);
+	CHECK(TWI_M_CTRL(TEST_TWI) & TWI_M_ENABLE_bm);
+	
+	CHECK_EQ(make_speed_TWI(&speed, 0), TWI_INVALID_BAUD);
+	CHECK_EQ(make_speed_TWI(&speed, 2000000), TWI_INVALID_BAUD);
+	CHECK_EQ(make_speed_TWI(&speed, BAUD_1M), TWI_HAS_FMPLUS ? TWI_STATUS_OK : TWI_INVALID_BAUD);
+}
+
+static void test_sleep(void){
+	uint8_t in[4];
+	
+	setup(BAUD_100K);
+	dev.regs[0x10] = 0x99;
+	set_sleep_TWI(1, TWI_INTLVL_LO);
+	
+	//without interrupts enabled the CPU doesn't sleep
+	CHECK_EQ(read_registers_TWI(TEST_TWI, 0x40, in, 0x10, sizeof(in)), TWI_STATUS_OK);
+	CHECK_EQ(sim.sleep_time, 0);
+	
+	//the master interrupt wakes it for every byte
+	sei();
+	CHECK_EQ(read_registers_TWI(TEST_TWI, 0x40, in, 0x10, sizeof(in)), TWI_STATUS_OK);
+	CHECK_EQ(in[0], 0x99);
+	CHECK(sim.sleep_time > 0);
+	CHECK(sim.isr_calls >= sizeof(in));
+	
+	cli();
+	set_sleep_TWI(0, TWI_INTLVL_LO);
+	CHECK_EQ(sim_counters(TEST_TWI)->violations, 0);
+}
+
+static void test_stats(void){
+	twi_stats_t *stats;
+	uint8_t data;
+	
+	setup(BAUD_400K);
+	twi_stats_reset(TEST_TWI);
+	
+	CHECK_EQ(write_8bit_register_TWI(TEST_TWI, 0x40, 0x01, 0x00), TWI_STATUS_OK);
+	CHECK_EQ(read_8bit_register_TWI(TEST_TWI, 0x40, &data, 0x00), TWI_STATUS_OK);
+	CHECK_EQ(probe_TWI(TEST_TWI, 0x12), NACK);
+	
+	stats = twi_stats_get(TEST_TWI);
+	CHECK_EQ(stats->bytes_out, 3);
+	CHECK_EQ(stats->bytes_in, 1);
+}
+
+int main(void){
+	sim_init();
+	
+	RUN(test_enable);
+	RUN(test_write_read_register);
+	RUN(test_registers);
+	RUN(test_smart_mode);
+	RUN(test_smart_transfer);
+	RUN(test_quick_command);
+	RUN(test_transfer);
+	RUN(test_nack);
+	RUN(test_arbitration);
+	RUN(test_other_master);
+	RUN(test_stuck);
+	RUN(test_long_deadline);
+	RUN(test_start_errors);
+	RUN(test_burst_errors);
+	RUN(test_stretch);
+	RUN(test_eeprom);
+	RUN(test_recover);
+	RUN(test_device_speed);
+	RUN(test_speed_race);
+	RUN(test_invalid_speed);
+	RUN(test_sleep);
+	RUN(test_stats);
+	
+	return test_result(TEST_FAMILY);
+}
@@ -0,0 +1,338 @@
+/*
+ * File test_eeprom.c
+ * Author: Tycho Jöbsis
+ * Date: 16-10-2026
+ */ 
+
+/*
+*	MIT License
+*
+*	Copyright (c) 2021 TychoJ
+*
+*	Permission is hereby granted, free of charge, to any person obtaining a copy
+*	of this software and associated documentation files (the "Software"), to deal
+*	in the Software without restriction, including without limitation the rights
+*	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*	copies of the Software, and to permit persons to whom the Software is
+*	furnished to do so, subject to the following conditions:
+*
+*	The above copyright notice and this permission notice shall be included in all
+*	copies or substantial portions of the Software.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*	SOFTWARE.
+*/
+
+#include <string.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "twi.h"
+#include "twi_async.h"
+#include "twi_eeprom.h"
+#include "sim.h"
+#include "sim_devices.h"
+#include "test.h"
+
+/*
+ * EEPROM driver of twi_eeprom.c against a virtual 24C32
+ */
+
+#ifdef SIM_TINY
+#define TEST_BUS twi0_bus
+#else
+#define TEST_BUS twie_bus
+#endif
+
+#define WRITE_US 2000
+
+static uint8_t mem[4096];
+static sim_eeprom_t eeprom;
+static twi_eeprom_t ee;
+
+//callbacks of the virtual EEPROM, faults are added in front of them
+static uint8_t (*eeprom_start)(sim_dev_t *d, uint8_t rw);
+static uint8_t (*eeprom_write)(sim_dev_t *d, uint8_t data);
+static uint8_t (*eeprom_read)(sim_dev_t *d);
+
+//the device holds SCL forever from its read address (stick_rstart), after the first byte it sends (stick_read)
+//or after byte fault_after of a write
+//with lose set the byte after byte fault_after of a write is lost to another master instead
+static uint8_t stick_rstart;
+static uint8_t stick_read;
+static uint8_t fault_after;
+static uint8_t lose;
+static uint8_t written;
+
+static uint8_t faulty_start(sim_dev_t *d, uint8_t rw){
+	if( (rw == READ) && stick_rstart ){
+		stick_rstart = 0;
+		d->stretch_ns = SIM_STUCK;
+	}
+	written = 0;
+	return eeprom_start(d, rw);
+}
+
+static uint8_t faulty_write(sim_dev_t *d, uint8_t data){
+	if( (fault_after != 0) && (++written == fault_after) ){
+		fault_after = 0;
+		if(lose) sim_inject(TEST_TWI, SIM_INJECT_ARBLOST);
+		else d->stretch_ns = SIM_STUCK;
+	}
+	return eeprom_write(d, data);
+}
+
+static uint8_t faulty_read(sim_dev_t *d){
+	if(stick_read){
+		stick_read = 0;
+		d->stretch_ns = SIM_STUCK;
+	}
+	return eeprom_read(d);
+}
+
+static void setup(void){
+	memset(mem, 0xFF, sizeof(mem));
+	sim_eeprom_init(&eeprom, 0x50, mem, sizeof(mem), 32, 2, WRITE_US);
+	eeprom_start = eeprom.dev.start;
+	eeprom_write = eeprom.dev.write;
+	eeprom.dev.start = faulty_start;
+	eeprom_read = eeprom.dev.read;
+	eeprom.dev.write = faulty_write;
+	eeprom.dev.read = faulty_read;
+	stick_rstart = stick_read = fault_after = lose = 0;
+	
+	sim_attach(TEST_TWI, &eeprom.dev);
+	set_deadline_timer_TWI(TEST_TC);
+	set_deadline_TWI(500);
+	enable_TWI(TEST_TWI, BAUD_400K, TIMEOUT_DIS);
+	twi_eeprom_init(&ee, TEST_TWI, 0x50, TWI_EEPROM_24C32);
+}
+
+//after an error the bus is free and the EEPROM works again
+static void check_recovered(void){
+	uint8_t out[3] = { 0x31, 0x32, 0x33 };
+	uint8_t in[3];
+	
+	eeprom.dev.stretch_ns = 0;
+	sim_run_ns(100000);
+	CHECK_EQ(bus_state(TEST_TWI), BUS_NOT_IN_USE);
+	
+	CHECK_EQ(twi_eeprom_write(&ee, 0x0400, out, sizeof(out)), TWI_STATUS_OK);
+	CHECK_EQ(twi_eeprom_read(&ee, 0x0400, in, sizeof(in)), TWI_STATUS_OK);
+	CHECK(memcmp(in, out, sizeof(in)) == 0);
+	CHECK_EQ(bus_state(TEST_TWI), BUS_NOT_IN_USE);
+}
+
+static void test_pages(void){
+	uint8_t out[70];
+	uint8_t in[70];
+	uint64_t start;
+	uint8_t i;
+	
+	setup();
+	for(i = 0; i < sizeof(out); i++) out[i] = i + 1;
+	
+	//16 bytes up to the end of the first page, a full page and 22 bytes of the next one
+	start = sim_time_ns();
+	CHECK_EQ(twi_eeprom_write(&ee, 0x01F0, out, sizeof(out)), TWI_STATUS_OK);
+	CHECK(sim_time_ns() - start >= 2 * WRITE_US * 1000ULL);
+	CHECK_EQ(eeprom.cycles, 3);
+	CHECK_EQ(eeprom.wraps, 0);
+	
+	//the pages after the first one polled the address
+	CHECK(eeprom.busy_nacks >= 2);
+	CHECK_EQ(mem[0x01EF], 0xFF);
+	CHECK(memcmp(&mem[0x01F0], out, sizeof(out)) == 0);
+	CHECK_EQ(mem[0x01F0 + sizeof(out)], 0xFF);
+	
+	//the read waits for the last write cycle
+	memset(in, 0, sizeof(in));
+	CHECK_EQ(twi_eeprom_read(&ee, 0x01F0, in, sizeof(in)), TWI_STATUS_OK);
+	CHECK(memcmp(in, out, sizeof(in)) == 0);
+	CHECK_EQ(sim_counters(TEST_TWI)->violations, 0);
+}
+
+static void test_wait(void){
+	uint8_t data = 0xA5;
+	uint32_t nacks;
+	uint64_t start;
+	
+	setup();
+	
+	start = sim_time_ns();
+	CHECK_EQ(twi_eeprom_write(&ee, 0x0010, &data, 1), TWI_STATUS_OK);
+	CHECK_EQ(twi_eeprom_wait(&ee), TWI_STATUS_OK);
+	CHECK(sim_time_ns() - start >= WRITE_US * 1000ULL);
+	CHECK(eeprom.busy_nacks > 0);
+	
+	//the write cycle is done, the next start is acknowledged right away
+	nacks = eeprom.busy_nacks;
+	CHECK_EQ(twi_eeprom_wait(&ee), TWI_STATUS_OK);
+	CHECK_EQ(eeprom.busy_nacks, nacks);
+	CHECK_EQ(mem[0x0010], 0xA5);
+	CHECK_EQ(bus_state(TEST_TWI), BUS_NOT_IN_USE);
+}
+
+static void test_range(void){
+	uint8_t buf[16];
+	
+	setup();
+	memset(buf, 0x11, sizeof(buf));
+	
+	CHECK_EQ(twi_eeprom_write(&ee, 4096, buf, 1), TWI_OUT_OF_RANGE);
+	CHECK_EQ(twi_eeprom_write(&ee, 4090, buf, 7), TWI_OUT_OF_RANGE);
+	CHECK_EQ(twi_eeprom_read(&ee, 4090, buf, 7), TWI_OUT_OF_RANGE);
+	CHECK_EQ(sim_counters(TEST_TWI)->starts, 0);
+	
+	//up to the last byte
+	CHECK_EQ(twi_eeprom_write(&ee, 4090, buf, 6), TWI_STATUS_OK);
+	CHECK_EQ(mem[4095], 0x11);
+	CHECK_EQ(twi_eeprom_read(&ee, 4090, buf, 6), TWI_STATUS_OK);
+}
+
+static void test_busy(void){
+	sim_nack_t absent;
+	uint8_t data = 0;
+	uint64_t start;
+	
+	setup();
+	sim_detach(TEST_TWI, &eeprom.dev);
+	sim_nack_init(&absent, 0x50, 0);
+	sim_attach(TEST_TWI, &absent.dev);
+	
+	//a device that never answers is polled for the longest write cycle
+	start = sim_time_ns();
+	CHECK_EQ(twi_eeprom_write(&ee, 0, &data, 1), TWI_BUSY);
+	CHECK(sim_time_ns() - start >= TWI_EEPROM_WRITE_US * 1000ULL);
+	CHECK_EQ(twi_eeprom_wait(&ee), TWI_BUSY);
+	CHECK_EQ(twi_eeprom_read(&ee, 0, &data, 1), TWI_BUSY);
+	CHECK_EQ(bus_state(TEST_TWI), BUS_NOT_IN_USE);
+	CHECK_EQ(sim_counters(TEST_TWI)->starts, sim_counters(TEST_TWI)->stops);
+}
+
+static void test_protected(void){
+	sim_nack_t locked;
+	uint8_t data = 0;
+	
+	setup();
+	sim_detach(TEST_TWI, &eeprom.dev);
+	
+	//the address bytes are acknowledged, the data isn't
+	sim_nack_init(&locked, 0x50, 3);
+	sim_attach(TEST_TWI, &locked.dev);
+	CHECK_EQ(twi_eeprom_write(&ee, 0, &data, 1), DATA_NOT_SEND);
+	CHECK_EQ(bus_state(TEST_TWI), BUS_NOT_IN_USE);
+	
+	//the memory address isn't acknowledged
+	sim_nack_init(&locked, 0x50, 1);
+	CHECK_EQ(twi_eeprom_read(&ee, 0, &data, 1), DATA_NOT_SEND);
+	CHECK_EQ(bus_state(TEST_TWI), BUS_NOT_IN_USE);
+	CHECK_EQ(sim_counters(TEST_TWI)->starts, sim_counters(TEST_TWI)->stops);
+}
+
+static void test_stuck(void){
+	uint8_t out[4] = { 1, 2, 3, 4 };
+	uint8_t in[4];
+	
+	setup();
+	
+	//a read byte that never comes, the stop frees the bus right away
+	stick_read = 1;
+	CHECK_EQ(twi_eeprom_read(&ee, 0x0010, in, sizeof(in)), DATA_NOT_RECEIVED);
+	CHECK_EQ(bus_state(TEST_TWI), BUS_NOT_IN_USE);
+	check_recovered();
+	
+	//the read address after the repeated start
+	stick_rstart = 1;
+	CHECK_EQ(twi_eeprom_read(&ee, 0x0010, in, sizeof(in)), DATA_NOT_SEND);
+	CHECK_EQ(bus_state(TEST_TWI), BUS_NOT_IN_USE);
+	check_recovered();
+	
+	//the memory address
+	fault_after = 1;
+	CHECK_EQ(twi_eeprom_write(&ee, 0x0020, out, sizeof(out)), DATA_NOT_SEND);
+	CHECK_EQ(bus_state(TEST_TWI), BUS_NOT_IN_USE);
+	check_recovered();
+	
+	//the data
+	fault_after = 3;
+	CHECK_EQ(twi_eeprom_write(&ee, 0x0020, out, sizeof(out)), DATA_NOT_SEND);
+	CHECK_EQ(bus_state(TEST_TWI), BUS_NOT_IN_USE);
+	check_recovered();
+	
+	fault_after = 1;
+	CHECK_EQ(twi_eeprom_read(&ee, 0x0020, in, sizeof(in)), DATA_NOT_SEND);
+	CHECK_EQ(bus_state(TEST_TWI), BUS_NOT_IN_USE);
+	check_recovered();
+	CHECK_EQ(sim_counters(TEST_TWI)->violations, 0);
+}
+
+static void test_arbitration(void){
+	uint8_t out[4] = { 1, 2, 3, 4 };
+	uint32_t stops;
+	
+	setup();
+	
+	//the bus belongs to the other master, no stop is send
+	fault_after = 2;
+	lose = 1;
+	stops = sim_counters(TEST_TWI)->stops;
+	CHECK_EQ(twi_eeprom_write(&ee, 0x0020, out, sizeof(out)), TWI_ARB_LOST);
+	CHECK_EQ(sim_counters(TEST_TWI)->stops, stops);
+	check_recovered();
+}
+
+//a blocking transfer on a module of the interrupt engine gives the module back after an error
+static void test_async_release(void){
+	uint8_t reg[2] = { 0x00, 0x40 };
+	uint8_t in[4];
+	twi_transaction_t t;
+	
+	setup();
+	twi_async_init(&TEST_BUS, TEST_TWI, TWI_INTLVL_LO);
+	sei();
+	
+	//while the module is claimed the driver runs blocking
+	twi_async_claim(TEST_TWI);
+	stick_read = 1;
+	CHECK_EQ(twi_eeprom_read(&ee, 0x0010, in, sizeof(in)), DATA_NOT_RECEIVED);
+	CHECK_EQ(TEST_BUS.blocking, 0);
+	eeprom.dev.stretch_ns = 0;
+	
+	twi_async_claim(TEST_TWI);
+	fault_after = 2;
+	lose = 1;
+	CHECK_EQ(twi_eeprom_write(&ee, 0x0020, in, sizeof(in)), TWI_ARB_LOST);
+	CHECK_EQ(TEST_BUS.blocking, 0);
+	sim_run_ns(100000);
+	
+	//a module that is still claimed would never start the transaction
+	if(TEST_BUS.blocking) return;
+	
+	//the engine runs again
+	twi_async_prepare(&t, 0x50, reg, sizeof(reg), in, sizeof(in), 0);
+	twi_async_submit(&TEST_BUS, &t);
+	CHECK_EQ(twi_async_wait(&t), TWI_STATUS_OK);
+	check_recovered();
+}
+
+int main(void){
+	sim_init();
+	
+	RUN(test_pages);
+	RUN(test_wait);
+	RUN(test_range);
+	RUN(test_busy);
+	RUN(test_protected);
+	RUN(test_stuck);
+	RUN(test_arbitration);
+	
+	//the bus stays registered, so this one runs last
+	RUN(test_async_release);
+	
+	return test_result(TEST_FAMILY);
+}
@@ -0,0 +1,59 @@
+/*
+ * File test_hpp.cpp
+ * Author: Tycho Jöbsis
+ * Date: 16-10-2026
+ */ 
+
+/*
+*	MIT License
+*
+*	Copyright (c) 2021 TychoJ
+*
+*	Permission is hereby granted, free of charge, to any person obtaining a copy
+*	of this software and associated documentation files (the "Software"), to deal
+*	in the Software without restriction, including without limitation the rights
+*	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*	copies of the Software, and to permit persons to whom the Software is
+*	furnished to do so, subject to the following conditions:
+*
+*	The above copyright notice and this permission notice shall be included in all
+*	copies or substantial portions of the Software.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*	SOFTWARE.
+*/
+
+#include "twi.hpp"
+
+/*
+ * Compile check of the C++ front-end, the template calls the C functions so only the build is checked
+ * built with -std=c++20 -Werror=volatile by make check
+ */
+
+#ifdef SIM_TINY
+typedef Twi<TwiModule::Twi0, 400000> Bus;
+#else
+typedef Twi<TwiModule::E, 400000> Bus;
+#endif
+
+uint8_t twi_hpp_check(void){
+	const uint8_t out[2] = { 0x01, 0x02 };
+	uint8_t in[6];
+	uint8_t data;
+	
+	if(Bus::enable() != TWI_STATUS_OK) return TWI_INVALID_BAUD;
+	if(Bus::start(0x1D, WRITE) == ACK){
+		Bus::write(0x28);
+		Bus::repeated_start(0x1D, READ);
+		Bus::read(&data, true);
+	}
+	Bus::write_registers(0x1D, 0x20, out);
+	Bus::write_register(0x1D, 0x20, 0x47);
+	Bus::read_register(0x1D, 0x0F, &data);
+	return Bus::read_registers(0x1D, 0x28, in);
+}
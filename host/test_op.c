@@ -0,0 +1,226 @@
+/*
+ * File test_op.c
+ * Author: Tycho Jöbsis
+ * Date: 16-10-2026
+ */ 
+
+/*
+*	MIT License
+*
+*	Copyright (c) 2021 TychoJ
+*
+*	Permission is hereby granted, free of charge, to any person obtaining a copy
+*	of this software and associated documentation files (the "Software"), to deal
+*	in the Software without restriction, including without limitation the rights
+*	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*	copies of the Software, and to permit persons to whom the Software is
+*	furnished to do so, subject to the following conditions:
+*
+*	The above copyright notice and this permission notice shall be included in all
+*	copies or substantial portions of the Software.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*	SOFTWARE.
+*/
+
+#include <string.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "twi.h"
+#include "twi_async.h"
+#include "twi_op.h"
+#include "sim.h"
+#include "sim_devices.h"
+#include "test.h"
+
+/*
+ * Non-blocking operations of twi_op.c on a polled bus and on a bus of the interrupt engine
+ */
+
+#ifdef SIM_TINY
+#define TEST_BUS twi0_bus
+#else
+#define TEST_BUS twie_bus
+#endif
+
+static sim_regfile_t dev;
+static twi_async_bus_t polled;
+
+//calls of done, with the operation and its status at that moment
+static uint8_t done_calls;
+static twi_op_t *done_op;
+static uint8_t done_status;
+static uint8_t done_in_isr;
+
+static void on_done(twi_op_t *op){
+	done_calls++;
+	done_op = op;
+	done_status = op->t.status;
+	done_in_isr = !(SREG & CPU_I_bm);
+}
+
+static void setup(uint8_t intlvl){
+	sim_regfile_init(&dev, 0x40);
+	sim_attach(TEST_TWI, &dev.dev);
+	set_deadline_timer_TWI(TEST_TC);
+	set_deadline_TWI(1000);
+	enable_TWI(TEST_TWI, BAUD_400K, TIMEOUT_DIS);
+	if(intlvl == TWI_ASYNC_POLLED) twi_async_init(&polled, TEST_TWI, TWI_ASYNC_POLLED);
+	else twi_async_init(&TEST_BUS, TEST_TWI, intlvl);
+	sei();
+	done_calls = 0;
+	done_op = 0;
+}
+
+//calls twi_op_status until the operation is finished, at most n times
+static uint8_t finish(twi_op_t *op, uint16_t n){
+	uint8_t status = TWI_BUSY;
+	
+	while( (n-- != 0) && ((status = twi_op_status(op)) == TWI_BUSY) );
+	return status;
+}
+
+//every function on the bus, a polled bus is stepped with twi_op_status
+static void run_all(twi_async_bus_t *bus, uint8_t polled_bus){
+	const uint8_t out[3] = { 0xB1, 0xB2, 0xB3 };
+	uint8_t in[3];
+	uint8_t data = 0;
+	twi_op_t op;
+	
+	CHECK_EQ(twi_op_write_8bit_register(&op, bus, 0x40, 0xA5, 0x10), TWI_BUSY);
+	if(polled_bus) CHECK_EQ(finish(&op, 1000), TWI_STATUS_OK);
+	else sim_run_ns(200000);
+	CHECK_EQ(twi_op_status(&op), TWI_STATUS_OK);
+	CHECK_EQ(dev.regs[0x10], 0xA5);
+	
+	dev.regs[0x20] = 0x5A;
+	CHECK_EQ(twi_op_read_8bit_register(&op, bus, 0x40, &data, 0x20), TWI_BUSY);
+	if(polled_bus) CHECK_EQ(finish(&op, 1000), TWI_STATUS_OK);
+	else sim_run_ns(200000);
+	CHECK_EQ(twi_op_status(&op), TWI_STATUS_OK);
+	CHECK_EQ(data, 0x5A);
+	
+	CHECK_EQ(twi_op_write_registers(&op, bus, 0x40, out, 0x30, sizeof(out)), TWI_BUSY);
+	if(polled_bus) CHECK_EQ(finish(&op, 1000), TWI_STATUS_OK);
+	else sim_run_ns(200000);
+	CHECK_EQ(twi_op_status(&op), TWI_STATUS_OK);
+	CHECK(memcmp(&dev.regs[0x30], out, sizeof(out)) == 0);
+	
+	memset(in, 0, sizeof(in));
+	CHECK_EQ(twi_op_read_registers(&op, bus, 0x40, in, 0x30, sizeof(in)), TWI_BUSY);
+	if(polled_bus) CHECK_EQ(finish(&op, 1000), TWI_STATUS_OK);
+	else sim_run_ns(200000);
+	CHECK_EQ(twi_op_status(&op), TWI_STATUS_OK);
+	CHECK(memcmp(in, out, sizeof(in)) == 0);
+	
+	CHECK_EQ(twi_op_send_8bit(&op, bus, 0x40, 0x07), TWI_BUSY);
+	if(polled_bus) CHECK_EQ(finish(&op, 1000), TWI_STATUS_OK);
+	else sim_run_ns(200000);
+	CHECK_EQ(twi_op_status(&op), TWI_STATUS_OK);
+	CHECK_EQ(dev.ptr, 0x07);
+	
+	//the status of a failed operation
+	CHECK_EQ(twi_op_send_8bit(&op, bus, 0x41, 0x07), TWI_BUSY);
+	if(polled_bus) CHECK_EQ(finish(&op, 1000), NACK);
+	else sim_run_ns(200000);
+	CHECK_EQ(twi_op_status(&op), NACK);
+	
+	CHECK_EQ(bus_state(TEST_TWI), BUS_NOT_IN_USE);
+	CHECK_EQ(sim_counters(TEST_TWI)->violations, 0);
+}
+
+static void test_polled(void){
+	twi_op_t op;
+	
+	setup(TWI_ASYNC_POLLED);
+	run_all(&polled, 1);
+	
+	//nothing happens between two calls of twi_op_status
+	CHECK_EQ(twi_op_write_8bit_register(&op, &polled, 0x40, 0x3C, 0x11), TWI_BUSY);
+	sim_run_ns(200000);
+	CHECK_EQ(dev.regs[0x11], 0);
+	CHECK_EQ(twi_op_status(&op), TWI_BUSY);
+	
+	//done is called by the twi_op_status that finishes the operation
+	CHECK_EQ(twi_op_set_done(&op, on_done, &dev), 1);
+	CHECK_EQ(done_calls, 0);
+	CHECK_EQ(finish(&op, 1000), TWI_STATUS_OK);
+	CHECK_EQ(done_calls, 1);
+	CHECK(done_op == &op);
+	CHECK(op.user == &dev);
+	CHECK_EQ(done_status, TWI_STATUS_OK);
+	CHECK_EQ(done_in_isr, 0);
+	CHECK_EQ(dev.regs[0x11], 0x3C);
+	
+	//too late, the operation has finished
+	CHECK_EQ(twi_op_set_done(&op, on_done, 0), 0);
+	CHECK_EQ(done_calls, 1);
+	CHECK(op.user == &dev);
+}
+
+static void test_interrupt(void){
+	twi_op_t op;
+	
+	setup(TWI_INTLVL_LO);
+	run_all(&TEST_BUS, 0);
+	
+	//the interrupt finishes the operation and calls done without twi_op_status
+	CHECK_EQ(twi_op_write_8bit_register(&op, &TEST_BUS, 0x40, 0x3C, 0x11), TWI_BUSY);
+	CHECK_EQ(twi_op_set_done(&op, on_done, &dev), 1);
+	sim_run_ns(200000);
+	CHECK_EQ(done_calls, 1);
+	CHECK(done_op == &op);
+	CHECK_EQ(done_status, TWI_STATUS_OK);
+	CHECK_EQ(done_in_isr, 1);
+	CHECK_EQ(dev.regs[0x11], 0x3C);
+	CHECK_EQ(twi_op_set_done(&op, on_done, 0), 0);
+}
+
+//twi_op_set_done at every moment around the end of the operation, done is called once or never
+static void test_set_done_race(void){
+	twi_op_t op;
+	uint8_t waiting;
+	uint8_t early = 0;
+	uint8_t late = 0;
+	uint16_t k;
+	
+	setup(TWI_INTLVL_LO);
+	
+	for(k = 0; k < 200; k++){
+		done_calls = 0;
+		CHECK_EQ(twi_op_write_8bit_register(&op, &TEST_BUS, 0x40, k, 0x12), TWI_BUSY);
+		sim_run_ns(500UL * k);
+		waiting = twi_op_set_done(&op, on_done, &dev);
+		sim_run_ns(200000);
+		
+		CHECK_EQ(twi_op_status(&op), TWI_STATUS_OK);
+		CHECK_EQ(done_calls, waiting);
+		if(waiting){
+			CHECK_EQ(done_status, TWI_STATUS_OK);
+			early++;
+		}
+		else late++;
+	}
+	
+	//both sides of the end have been hit
+	CHECK(early > 0);
+	CHECK(late > 0);
+	CHECK_EQ(dev.regs[0x12], 199);
+	CHECK_EQ(sim_counters(TEST_TWI)->violations, 0);
+}
+
+int main(void){
+	sim_init();
+	
+	//a polled bus is never registered, so it goes first
+	RUN(test_polled);
+	RUN(test_interrupt);
+	RUN(test_set_done_race);
+	
+	return test_result(TEST_FAMILY);
+}
@@ -0,0 +1,190 @@
+/*
+ * File test_op_hpp.cpp
+ * Author: Tycho Jöbsis
+ * Date: 16-10-2026
+ */ 
+
+/*
+*	MIT License
+*
+*	Copyright (c) 2021 TychoJ
+*
+*	Permission is hereby granted, free of charge, to any person obtaining a copy
+*	of this software and associated documentation files (the "Software"), to deal
+*	in the Software without restriction, including without limitation the rights
+*	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*	copies of the Software, and to permit persons to whom the Software is
+*	furnished to do so, subject to the following conditions:
+*
+*	The above copyright notice and this permission notice shall be included in all
+*	copies or substantial portions of the Software.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*	SOFTWARE.
+*/
+
+#include <string.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "twi.h"
+#include "twi_async.h"
+#include "twi_op.hpp"
+#include "sim.h"
+#include "sim_devices.h"
+#include "test.h"
+
+/*
+ * The TwiOp awaitable of twi_op.hpp in a coroutine, on a polled bus and on a bus of the interrupt engine
+ * built with -std=c++20 against the C library by make check
+ */
+
+#ifndef TWI_OP_COROUTINES
+#error "the toolchain has no <coroutine>"
+#endif
+
+#ifdef SIM_TINY
+#define TEST_BUS twi0_bus
+#else
+#define TEST_BUS twie_bus
+#endif
+
+//a coroutine that starts right away and frees its frame when it ends
+struct Task {
+	struct promise_type {
+		Task get_return_object(){ return {}; }
+		std::suspend_never initial_suspend() noexcept { return {}; }
+		std::suspend_never final_suspend() noexcept { return {}; }
+		void return_void(){}
+		void unhandled_exception(){}
+	};
+};
+
+static sim_regfile_t dev;
+static twi_async_bus_t polled;
+
+//what the coroutine saw after every co_await
+struct Trace {
+	uint8_t steps;
+	uint8_t status[3];
+	uint8_t in_isr[3];
+	uint8_t data[3];
+	uint8_t ended;
+};
+
+static void setup(uint8_t intlvl){
+	sim_regfile_init(&dev, 0x40);
+	sim_attach(TEST_TWI, &dev.dev);
+	set_deadline_timer_TWI(TEST_TC);
+	set_deadline_TWI(1000);
+	enable_TWI(TEST_TWI, BAUD_400K, TIMEOUT_DIS);
+	if(intlvl == TWI_ASYNC_POLLED) twi_async_init(&polled, TEST_TWI, TWI_ASYNC_POLLED);
+	else twi_async_init(&TEST_BUS, TEST_TWI, intlvl);
+	sei();
+}
+
+static void seen(Trace *trace, uint8_t status, uint8_t data){
+	trace->status[trace->steps] = status;
+	trace->in_isr[trace->steps] = !(SREG & CPU_I_bm);
+	trace->data[trace->steps] = data;
+	trace->steps++;
+}
+
+//a write, a read of the same register and a write to an absent device, one after the other
+static Task write_read(twi_async_bus_t *bus, Trace *trace){
+	twi_op_t op;
+	uint8_t data = 0;
+	
+	twi_op_write_8bit_register(&op, bus, 0x40, 0x66, 0x10);
+	seen(trace, co_await TwiOp(&op), 0);
+	
+	twi_op_read_8bit_register(&op, bus, 0x40, &data, 0x10);
+	seen(trace, co_await TwiOp(&op), data);
+	
+	twi_op_send_8bit(&op, bus, 0x41, 0x00);
+	seen(trace, co_await TwiOp(&op), 0);
+	
+	trace->ended = 1;
+}
+
+//awaits an operation that has already finished
+static Task finished(twi_op_t *op, Trace *trace){
+	seen(trace, co_await TwiOp(op), 0);
+	trace->ended = 1;
+}
+
+static void check_trace(const Trace *trace, uint8_t in_isr){
+	CHECK_EQ(trace->ended, 1);
+	CHECK_EQ(trace->steps, 3);
+	CHECK_EQ(trace->status[0], TWI_STATUS_OK);
+	CHECK_EQ(trace->status[1], TWI_STATUS_OK);
+	CHECK_EQ(trace->data[1], 0x66);
+	CHECK_EQ(trace->status[2], NACK);
+	for(uint8_t i = 0; i < 3; i++) CHECK_EQ(trace->in_isr[i], in_isr);
+	CHECK_EQ(dev.regs[0x10], 0x66);
+	CHECK_EQ(bus_state(TEST_TWI), BUS_NOT_IN_USE);
+	CHECK_EQ(sim_counters(TEST_TWI)->violations, 0);
+}
+
+static void test_polled(void){
+	Trace trace;
+	uint16_t n = 3000;
+	
+	memset(&trace, 0, sizeof(trace));
+	setup(TWI_ASYNC_POLLED);
+	
+	//suspended on the first operation, nothing happens without twi_async_poll
+	write_read(&polled, &trace);
+	sim_run_ns(200000);
+	CHECK_EQ(trace.steps, 0);
+	
+	//every co_await continues from twi_async_poll
+	while( (n-- != 0) && !trace.ended ) twi_async_poll(&polled);
+	check_trace(&trace, 0);
+}
+
+static void test_interrupt(void){
+	Trace trace;
+	
+	memset(&trace, 0, sizeof(trace));
+	setup(TWI_INTLVL_LO);
+	
+	//the interrupt resumes the coroutine, which starts the next operation from there
+	write_read(&TEST_BUS, &trace);
+	CHECK_EQ(trace.steps, 0);
+	sim_run_ns(600000);
+	check_trace(&trace, 1);
+}
+
+static void test_ready(void){
+	Trace trace;
+	twi_op_t op;
+	
+	memset(&trace, 0, sizeof(trace));
+	setup(TWI_INTLVL_LO);
+	
+	//await_ready sees the status, the coroutine doesn't suspend
+	CHECK_EQ(twi_op_write_8bit_register(&op, &TEST_BUS, 0x40, 0x3C, 0x11), TWI_BUSY);
+	sim_run_ns(200000);
+	finished(&op, &trace);
+	CHECK_EQ(trace.ended, 1);
+	CHECK_EQ(trace.steps, 1);
+	CHECK_EQ(trace.status[0], TWI_STATUS_OK);
+	CHECK_EQ(trace.in_isr[0], 0);
+	CHECK_EQ(dev.regs[0x11], 0x3C);
+}
+
+int main(void){
+	sim_init();
+	
+	//a polled bus is never registered, so it goes first
+	RUN(test_polled);
+	RUN(test_interrupt);
+	RUN(test_ready);
+	
+	return test_result(TEST_FAMILY);
+}
@@ -0,0 +1,214 @@
+/*
+ * File test_regmap.c
+ * Author: Tycho Jöbsis
+ * Date: 16-10-2026
+ */ 
+
+/*
+*	MIT License
+*
+*	Copyright (c) 2021 TychoJ
+*
+*	Permission is hereby granted, free of charge, to any person obtaining a copy
+*	of this software and associated documentation files (the "Software"), to deal
+*	in the Software without restriction, including without limitation the rights
+*	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*	copies of the Software, and to permit persons to whom the Software is
+*	furnished to do so, subject to the following conditions:
+*
+*	The above copyright notice and this permission notice shall be included in all
+*	copies or substantial portions of the Software.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*	SOFTWARE.
+*/
+
+#include <string.h>
+#include <avr/io.h>
+#include "twi.h"
+#include "twi_regmap.h"
+#include "sim.h"
+#include "sim_devices.h"
+#include "test.h"
+
+/*
+ * Register cache of twi_regmap.c against a virtual register file
+ */
+
+static sim_regfile_t dev;
+
+TWI_REGMAP_DEFINE(map, 0x20, 0x10);
+
+static void setup(void){
+	sim_regfile_init(&dev, 0x40);
+	sim_attach(TEST_TWI, &dev.dev);
+	set_deadline_timer_TWI(0);
+	set_deadline_TWI(TWI_DEADLINE_DEFAULT_US);
+	enable_TWI(TEST_TWI, BAUD_400K, TIMEOUT_DIS);
+	
+	//the volatile marks survive twi_regmap_init
+	memset(map_flags, 0, sizeof(map_flags));
+	twi_regmap_init(&map, TEST_TWI, 0x40, 0, 0);
+}
+
+static void test_cache(void){
+	uint8_t data = 0;
+	
+	setup();
+	dev.regs[0x21] = 0x11;
+	
+	//only the first read uses the bus
+	CHECK_EQ(twi_regmap_read(&map, 0x21, &data), TWI_STATUS_OK);
+	CHECK_EQ(data, 0x11);
+	dev.regs[0x21] = 0x22;
+	CHECK_EQ(twi_regmap_read(&map, 0x21, &data), TWI_STATUS_OK);
+	CHECK_EQ(data, 0x11);
+	CHECK_EQ(sim_counters(TEST_TWI)->starts, 1);
+	
+	twi_regmap_invalidate(&map);
+	CHECK_EQ(twi_regmap_read(&map, 0x21, &data), TWI_STATUS_OK);
+	CHECK_EQ(data, 0x22);
+	CHECK_EQ(sim_counters(TEST_TWI)->starts, 2);
+	
+	//registers outside the map always go to the device
+	dev.regs[0x30] = 0x33;
+	CHECK_EQ(twi_regmap_read(&map, 0x30, &data), TWI_STATUS_OK);
+	CHECK_EQ(twi_regmap_read(&map, 0x30, &data), TWI_STATUS_OK);
+	CHECK_EQ(data, 0x33);
+	CHECK_EQ(sim_counters(TEST_TWI)->starts, 4);
+	
+	//a read that fails caches nothing
+	sim_detach(TEST_TWI, &dev.dev);
+	CHECK_EQ(twi_regmap_read(&map, 0x22, &data), NACK);
+	sim_attach(TEST_TWI, &dev.dev);
+	dev.regs[0x22] = 0x44;
+	CHECK_EQ(twi_regmap_read(&map, 0x22, &data), TWI_STATUS_OK);
+	CHECK_EQ(data, 0x44);
+	CHECK_EQ(sim_counters(TEST_TWI)->violations, 0);
+}
+
+static void test_flush(void){
+	uint8_t data = 0;
+	
+	setup();
+	
+	//writes stay in the cache
+	CHECK_EQ(twi_regmap_write(&map, 0x22, 1), TWI_STATUS_OK);
+	CHECK_EQ(twi_regmap_write(&map, 0x23, 2), TWI_STATUS_OK);
+	CHECK_EQ(twi_regmap_write(&map, 0x24, 3), TWI_STATUS_OK);
+	CHECK_EQ(twi_regmap_write(&map, 0x27, 4), TWI_STATUS_OK);
+	CHECK_EQ(sim_counters(TEST_TWI)->starts, 0);
+	CHECK_EQ(dev.regs[0x22], 0);
+	
+	//a written register reads from the cache
+	CHECK_EQ(twi_regmap_read(&map, 0x23, &data), TWI_STATUS_OK);
+	CHECK_EQ(data, 2);
+	CHECK_EQ(sim_counters(TEST_TWI)->starts, 0);
+	
+	//0x22 up to 0x24 in one burst, 0x27 on its own
+	CHECK_EQ(twi_regmap_flush(&map), TWI_STATUS_OK);
+	CHECK_EQ(sim_counters(TEST_TWI)->starts, 2);
+	CHECK_EQ(dev.dev.bytes_in, (1 + 3) + (1 + 1));
+	CHECK_EQ(dev.regs[0x22], 1);
+	CHECK_EQ(dev.regs[0x23], 2);
+	CHECK_EQ(dev.regs[0x24], 3);
+	CHECK_EQ(dev.regs[0x27], 4);
+	
+	//nothing is dirty anymore and the same value isn't written again
+	CHECK_EQ(twi_regmap_write(&map, 0x23, 2), TWI_STATUS_OK);
+	CHECK_EQ(twi_regmap_flush(&map), TWI_STATUS_OK);
+	CHECK_EQ(sim_counters(TEST_TWI)->starts, 2);
+	
+	//a failed flush keeps the registers dirty
+	CHECK_EQ(twi_regmap_write(&map, 0x2F, 5), TWI_STATUS_OK);
+	sim_detach(TEST_TWI, &dev.dev);
+	CHECK_EQ(twi_regmap_flush(&map), NACK);
+	sim_attach(TEST_TWI, &dev.dev);
+	CHECK_EQ(twi_regmap_flush(&map), TWI_STATUS_OK);
+	CHECK_EQ(dev.regs[0x2F], 5);
+	CHECK_EQ(sim_counters(TEST_TWI)->violations, 0);
+}
+
+static void test_update_bits(void){
+	uint8_t data = 0;
+	
+	setup();
+	dev.regs[0x25] = 0xF0;
+	
+	//the register is read once, the new value waits for the flush
+	CHECK_EQ(twi_regmap_update_bits(&map, 0x25, 0x0F, 0x05), TWI_STATUS_OK);
+	CHECK_EQ(twi_regmap_read(&map, 0x25, &data), TWI_STATUS_OK);
+	CHECK_EQ(data, 0xF5);
+	CHECK_EQ(dev.regs[0x25], 0xF0);
+	CHECK_EQ(sim_counters(TEST_TWI)->starts, 1);
+	
+	CHECK_EQ(twi_regmap_flush(&map), TWI_STATUS_OK);
+	CHECK_EQ(dev.regs[0x25], 0xF5);
+	CHECK_EQ(sim_counters(TEST_TWI)->starts, 2);
+	
+	//bits outside the mask and bits that are already set change nothing
+	CHECK_EQ(twi_regmap_update_bits(&map, 0x25, 0x0F, 0xF5), TWI_STATUS_OK);
+	CHECK_EQ(twi_regmap_flush(&map), TWI_STATUS_OK);
+	CHECK_EQ(sim_counters(TEST_TWI)->starts, 2);
+}
+
+static void test_volatile(void){
+	uint8_t data = 0;
+	
+	setup();
+	
+	//a pending value is written before the register stops being cached
+	CHECK_EQ(twi_regmap_write(&map, 0x26, 0x42), TWI_STATUS_OK);
+	CHECK_EQ(twi_regmap_set_volatile(&map, 0x26, 1), TWI_STATUS_OK);
+	CHECK_EQ(dev.regs[0x26], 0x42);
+	CHECK_EQ(sim_counters(TEST_TWI)->starts, 1);
+	CHECK_EQ(twi_regmap_flush(&map), TWI_STATUS_OK);
+	CHECK_EQ(sim_counters(TEST_TWI)->starts, 1);
+	
+	//every access goes to the device
+	dev.regs[0x26] = 0x99;
+	CHECK_EQ(twi_regmap_read(&map, 0x26, &data), TWI_STATUS_OK);
+	CHECK_EQ(data, 0x99);
+	CHECK_EQ(twi_regmap_write(&map, 0x26, 0x77), TWI_STATUS_OK);
+	CHECK_EQ(dev.regs[0x26], 0x77);
+	CHECK_EQ(sim_counters(TEST_TWI)->starts, 3);
+	
+	//the marks survive an invalidate
+	twi_regmap_invalidate(&map);
+	CHECK_EQ(twi_regmap_read(&map, 0x26, &data), TWI_STATUS_OK);
+	CHECK_EQ(twi_regmap_read(&map, 0x26, &data), TWI_STATUS_OK);
+	CHECK_EQ(sim_counters(TEST_TWI)->starts, 5);
+	
+	//a failed write keeps the register cached and dirty
+	CHECK_EQ(twi_regmap_write(&map, 0x28, 0x18), TWI_STATUS_OK);
+	sim_detach(TEST_TWI, &dev.dev);
+	CHECK_EQ(twi_regmap_set_volatile(&map, 0x28, 1), NACK);
+	sim_attach(TEST_TWI, &dev.dev);
+	CHECK_EQ(twi_regmap_flush(&map), TWI_STATUS_OK);
+	CHECK_EQ(dev.regs[0x28], 0x18);
+	
+	//registers past 0xFF don't wrap around into the map
+	CHECK_EQ(twi_regmap_set_volatile(&map, 0xFE, 0x30), TWI_STATUS_OK);
+	dev.regs[0x20] = 0x20;
+	CHECK_EQ(twi_regmap_read(&map, 0x20, &data), TWI_STATUS_OK);
+	dev.regs[0x20] = 0x21;
+	CHECK_EQ(twi_regmap_read(&map, 0x20, &data), TWI_STATUS_OK);
+	CHECK_EQ(data, 0x20);
+	CHECK_EQ(sim_counters(TEST_TWI)->violations, 0);
+}
+
+int main(void){
+	sim_init();
+	
+	RUN(test_cache);
+	RUN(test_flush);
+	RUN(test_update_bits);
+	RUN(test_volatile);
+	
+	return test_result(TEST_FAMILY);
+}
@@ -0,0 +1,189 @@
+/*
+ * File test_sampler.c
+ * Author: Tycho Jöbsis
+ * Date: 16-10-2026
+ */ 
+
+/*
+*	MIT License
+*
+*	Copyright (c) 2021 TychoJ
+*
+*	Permission is hereby granted, free of charge, to any person obtaining a copy
+*	of this software and associated documentation files (the "Software"), to deal
+*	in the Software without restriction, including without limitation the rights
+*	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*	copies of the Software, and to permit persons to whom the Software is
+*	furnished to do so, subject to the following conditions:
+*
+*	The above copyright notice and this permission notice shall be included in all
+*	copies or substantial portions of the Software.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*	SOFTWARE.
+*/
+
+#include <string.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "twi.h"
+#include "twi_async.h"
+#include "twi_sampler.h"
+#include "sim.h"
+#include "sim_devices.h"
+#include "test.h"
+
+/*
+ * Periodic sampler of twi_sampler.c with the timer of twi_regs.h
+ */
+
+#ifdef SIM_TINY
+#define TEST_BUS twi0_bus
+#else
+#define TEST_BUS twie_bus
+#endif
+
+//1 ms ticks
+#define TICK_PERIOD (F_CPU / TWI_TICK_DIV / 1000UL)
+
+static sim_regfile_t accel_dev;
+static sim_regfile_t gyro_dev;
+static twi_sampler_t sampler;
+static twi_sample_source_t accel, gyro;
+static twi_sample_t ring[16];
+static twi_sample_t samples[16];
+
+ISR(TEST_TICK_vect){
+	twi_sampler_tick(&sampler);
+}
+
+static void setup(uint8_t size){
+	uint8_t i;
+	
+	sim_regfile_init(&accel_dev, 0x40);
+	sim_regfile_init(&gyro_dev, 0x41);
+	for(i = 0; i < 6; i++) accel_dev.regs[0x28 + i] = 0x80 + i;
+	gyro_dev.regs[0x22] = 0x5A;
+	gyro_dev.regs[0x23] = 0xA5;
+	sim_attach(TEST_TWI, &accel_dev.dev);
+	sim_attach(TEST_TWI, &gyro_dev.dev);
+	
+	set_deadline_timer_TWI(TEST_TC);
+	set_deadline_TWI(500);
+	enable_TWI(TEST_TWI, BAUD_400K, TIMEOUT_DIS);
+	twi_async_init(&TEST_BUS, TEST_TWI, TWI_INTLVL_LO);
+	
+	twi_sampler_init(&sampler, &TEST_BUS, ring, size);
+	twi_sampler_add(&sampler, &accel, 0x40, 0x28, 6, 1, 0);
+	twi_sampler_add(&sampler, &gyro, 0x41, 0x22, 2, 4, 1);
+}
+
+static void test_rates(void){
+	uint8_t n, i;
+	uint8_t accels = 0;
+	uint8_t gyros = 0;
+	uint64_t start;
+	
+	setup(16);
+	twi_sampler_timer(&sampler, TEST_TICK_TC, TICK_PERIOD);
+	sei();
+	
+	//the ticks come every ms from the timer
+	start = sim_time_ns();
+	sim_run_ns(8500000);
+	CHECK_EQ(sampler.ticks, 8);
+	CHECK(sim_time_ns() - start >= 8500000);
+	
+	n = twi_sampler_read(&sampler, samples, 16);
+	CHECK_EQ(n, 10);
+	for(i = 0; i < n; i++){
+		if(samples[i].id == 0){
+			accels++;
+			CHECK_EQ(samples[i].len, 6);
+			CHECK_EQ(samples[i].data[0], 0x80);
+			CHECK_EQ(samples[i].data[5], 0x85);
+		}
+		else{
+			gyros++;
+			CHECK_EQ(samples[i].len, 2);
+			CHECK_EQ(samples[i].data[0], 0x5A);
+			CHECK_EQ(samples[i].data[1], 0xA5);
+			CHECK_EQ(samples[i].time % 4, 0);
+		}
+	}
+	CHECK_EQ(accels, 8);
+	CHECK_EQ(gyros, 2);
+	CHECK_EQ(sampler.overruns, 0);
+	CHECK_EQ(sampler.missed, 0);
+	
+	//nothing new until the next tick
+	CHECK_EQ(twi_sampler_read(&sampler, samples, 16), 0);
+	CHECK_EQ(sim_counters(TEST_TWI)->violations, 0);
+}
+
+static void test_overrun(void){
+	setup(4);
+	twi_sampler_timer(&sampler, TEST_TICK_TC, TICK_PERIOD);
+	sei();
+	
+	//three entries fit, the rest is counted
+	sim_run_ns(4500000);
+	CHECK_EQ(twi_sampler_read(&sampler, samples, 16), 3);
+	CHECK_EQ(sampler.overruns, 2);
+	
+	sim_run_ns(1000000);
+	CHECK_EQ(twi_sampler_read(&sampler, samples, 16), 1);
+	CHECK_EQ(samples[0].time, 5);
+}
+
+static void test_missed(void){
+	setup(16);
+	
+	//a read takes longer than a tick, the tick after it is skipped
+	accel_dev.dev.stretch_ns = 300000;
+	twi_sampler_timer(&sampler, TEST_TICK_TC, TICK_PERIOD);
+	sei();
+	sim_run_ns(4500000);
+	CHECK(sampler.missed > 0);
+	
+	//every due read is a sample, missed or still on the bus
+	CHECK_EQ(twi_sampler_read(&sampler, samples, 16) + sampler.missed + (accel.t.status == TWI_BUSY) + (gyro.t.status == TWI_BUSY), 5);
+}
+
+static void test_errors(void){
+	sim_nack_t absent;
+	twi_sample_source_t gone, never;
+	
+	setup(16);
+	
+	//a period of 0 is refused
+	CHECK_EQ(twi_sampler_add(&sampler, &never, 0x40, 0x28, 6, 0, 3), TWI_OUT_OF_RANGE);
+	CHECK_EQ(twi_sampler_timer(&sampler, TEST_TICK_TC, 0), TWI_OUT_OF_RANGE);
+	
+	//a device that doesn't answer is counted every read
+	sim_nack_init(&absent, 0x42, 0);
+	sim_attach(TEST_TWI, &absent.dev);
+	CHECK_EQ(twi_sampler_add(&sampler, &gone, 0x42, 0x00, 1, 2, 2), TWI_STATUS_OK);
+	CHECK_EQ(twi_sampler_timer(&sampler, TEST_TICK_TC, TICK_PERIOD), TWI_STATUS_OK);
+	sei();
+	sim_run_ns(4500000);
+	CHECK_EQ(sampler.errors, 2);
+	CHECK_EQ(twi_sampler_read(&sampler, samples, 16), 5);
+	CHECK_EQ(sampler.ticks, 4);
+}
+
+int main(void){
+	sim_init();
+	
+	RUN(test_rates);
+	RUN(test_overrun);
+	RUN(test_missed);
+	RUN(test_errors);
+	
+	return test_result(TEST_FAMILY);
+}
@@ -0,0 +1,195 @@
+/*
+ * File test_slave.c
+ * Author: Tycho Jöbsis
+ * Date: 16-10-2026
+ */ 
+
+/*
+*	MIT License
+*
+*	Copyright (c) 2021 TychoJ
+*
+*	Permission is hereby granted, free of charge, to any person obtaining a copy
+*	of this software and associated documentation files (the "Software"), to deal
+*	in the Software without restriction, including without limitation the rights
+*	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*	copies of the Software, and to permit persons to whom the Software is
+*	furnished to do so, subject to the following conditions:
+*
+*	The above copyright notice and this permission notice shall be included in all
+*	copies or substantial portions of the Software.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*	SOFTWARE.
+*/
+
+#include <string.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "twi.h"
+#include "twi_slave.h"
+#include "sim.h"
+#include "test.h"
+
+/*
+ * Register file slaves of twi_slave.c, addressed by the external master of the simulator
+ */
+
+static twi_slave_t first, second, third;
+static uint8_t regs_a[16], regs_b[16], regs_c[8];
+static uint8_t wp_a[2];
+
+static uint8_t commits;
+static uint8_t commit_first;
+static uint8_t commit_count;
+static twi_slave_t *commit_slave;
+
+ISR(TEST_TWIS_vect){
+	twi_slave_isr(&first);
+}
+
+static void on_commit(twi_slave_t *slave, uint8_t reg, uint8_t count){
+	commits++;
+	commit_slave = slave;
+	commit_first = reg;
+	commit_count = count;
+}
+
+static void setup(void){
+	memset(regs_a, 0, sizeof(regs_a));
+	memset(regs_b, 0, sizeof(regs_b));
+	memset(regs_c, 0, sizeof(regs_c));
+	commits = 0;
+	commit_slave = 0;
+	
+	twi_slave_init(&first, TEST_TWI, 0x50, regs_a, sizeof(regs_a), wp_a, TWI_INTLVL_LO);
+	sei();
+}
+
+//writes the register pointer and reads len registers after a repeated start
+static int read_regs(uint8_t addr, uint8_t reg, uint8_t *data, uint8_t len){
+	if(sim_master_write(TEST_TWI, addr, &reg, 1, 0) != 1) return -1;
+	return sim_master_read(TEST_TWI, addr, data, len, 1);
+}
+
+static void test_register_file(void){
+	const uint8_t out[3] = { 0x02, 0xAA, 0xBB };
+	uint8_t in[2] = { 0, 0 };
+	
+	setup();
+	twi_slave_set_commit(&first, on_commit);
+	
+	CHECK_EQ(sim_master_write(TEST_TWI, 0x50, out, sizeof(out), 1), 3);
+	CHECK_EQ(regs_a[2], 0xAA);
+	CHECK_EQ(regs_a[3], 0xBB);
+	CHECK_EQ(commits, 1);
+	CHECK_EQ(commit_first, 2);
+	CHECK_EQ(commit_count, 2);
+	
+	CHECK_EQ(read_regs(0x50, 0x02, in, 2), 2);
+	CHECK_EQ(in[0], 0xAA);
+	CHECK_EQ(in[1], 0xBB);
+	
+	//a read doesn't commit and other addresses are not answered
+	CHECK_EQ(commits, 1);
+	CHECK_EQ(sim_master_write(TEST_TWI, 0x51, out, sizeof(out), 1), -1);
+}
+
+static void test_protect(void){
+	const uint8_t out[4] = { 0x04, 0x11, 0x22, 0x33 };
+	
+	setup();
+	twi_slave_protect(&first, 0x05, 1);
+	regs_a[5] = 0x99;
+	
+	//the protected register is acknowledged but keeps its value
+	CHECK_EQ(sim_master_write(TEST_TWI, 0x50, out, sizeof(out), 1), 4);
+	CHECK_EQ(regs_a[4], 0x11);
+	CHECK_EQ(regs_a[5], 0x99);
+	CHECK_EQ(regs_a[6], 0x33);
+}
+
+static void test_second_address(void){
+	const uint8_t out_a[2] = { 0x01, 0x5A };
+	const uint8_t out_b[2] = { 0x01, 0xA5 };
+	uint8_t in = 0;
+	
+	setup();
+	twi_slave_add(&first, &second, 0x68, regs_b, sizeof(regs_b), 0);
+	twi_slave_set_commit(&second, on_commit);
+	
+	//two unrelated addresses use the second address, not the mask
+	CHECK(TWI_S_ADDRMASK(TEST_TWI) & TWI_S_ADDREN_bm);
+	
+	CHECK_EQ(sim_master_write(TEST_TWI, 0x50, out_a, sizeof(out_a), 1), 2);
+	CHECK_EQ(sim_master_write(TEST_TWI, 0x68, out_b, sizeof(out_b), 1), 2);
+	CHECK_EQ(regs_a[1], 0x5A);
+	CHECK_EQ(regs_b[1], 0xA5);
+	CHECK_EQ(commits, 1);
+	CHECK(commit_slave == &second);
+	
+	//every address has its own register pointer
+	CHECK_EQ(read_regs(0x68, 0x01, &in, 1), 1);
+	CHECK_EQ(in, 0xA5);
+	CHECK_EQ(read_regs(0x50, 0x01, &in, 1), 1);
+	CHECK_EQ(in, 0x5A);
+	CHECK_EQ(sim_master_write(TEST_TWI, 0x51, out_a, sizeof(out_a), 1), -1);
+}
+
+static void test_mask(void){
+	const uint8_t out[2] = { 0x03, 0x00 };
+	uint8_t msg[2];
+	uint8_t in = 0;
+	uint8_t i;
+	static const uint8_t addrs[3] = { 0x50, 0x52, 0x54 };
+	
+	setup();
+	twi_slave_add(&first, &second, 0x52, regs_b, sizeof(regs_b), 0);
+	twi_slave_add(&first, &third, 0x54, regs_c, sizeof(regs_c), 0);
+	
+	//three addresses need the mask
+	CHECK( !(TWI_S_ADDRMASK(TEST_TWI) & TWI_S_ADDREN_bm) );
+	
+	//every address reaches its own register file
+	for(i = 0; i < 3; i++){
+		msg[0] = out[0];
+		msg[1] = 0x10 + i;
+		CHECK_EQ(sim_master_write(TEST_TWI, addrs[i], msg, sizeof(msg), 1), 2);
+	}
+	CHECK_EQ(regs_a[3], 0x10);
+	CHECK_EQ(regs_b[3], 0x11);
+	CHECK_EQ(regs_c[3], 0x12);
+	
+	for(i = 0; i < 3; i++){
+		CHECK_EQ(read_regs(addrs[i], 0x03, &in, 1), 1);
+		CHECK_EQ(in, 0x10 + i);
+	}
+	
+	//0x56 matches the mask but isn't added, it is not acknowledged
+	CHECK_EQ(sim_master_write(TEST_TWI, 0x56, out, sizeof(out), 1), -1);
+	CHECK_EQ(sim_master_write(TEST_TWI, 0x51, out, sizeof(out), 1), -1);
+	
+	//a register past the end of a smaller file is acknowledged and dropped
+	msg[0] = 0x08;
+	msg[1] = 0x77;
+	CHECK_EQ(sim_master_write(TEST_TWI, 0x54, msg, sizeof(msg), 1), 2);
+	CHECK_EQ(regs_b[8], 0);
+	CHECK_EQ(read_regs(0x54, 0x08, &in, 1), 1);
+	CHECK_EQ(in, 0xFF);
+}
+
+int main(void){
+	sim_init();
+	
+	RUN(test_register_file);
+	RUN(test_protect);
+	RUN(test_second_address);
+	RUN(test_mask);
+	
+	return test_result(TEST_FAMILY);
+}
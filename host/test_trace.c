@@ -0,0 +1,211 @@
+/*
+ * File test_trace.c
+ * Author: Tycho Jöbsis
+ * Date: 16-10-2026
+ */ 
+
+/*
+*	MIT License
+*
+*	Copyright (c) 2021 TychoJ
+*
+*	Permission is hereby granted, free of charge, to any person obtaining a copy
+*	of this software and associated documentation files (the "Software"), to deal
+*	in the Software without restriction, including without limitation the rights
+*	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*	copies of the Software, and to permit persons to whom the Software is
+*	furnished to do so, subject to the following conditions:
+*
+*	The above copyright notice and this permission notice shall be included in all
+*	copies or substantial portions of the Software.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*	SOFTWARE.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <avr/io.h>
+#include "twi.h"
+#include "twi_trace.h"
+#include "sim.h"
+#include "sim_devices.h"
+#include "test.h"
+
+/*
+ * Event trace of twi_trace.c, the dump is decoded by tools/twi_trace_decode (TEST_DECODER)
+ */
+
+static sim_regfile_t dev;
+
+//the dump of twi_trace_dump
+static uint8_t dump[9 + 4 * TWI_TRACE_SIZE];
+static uint16_t dump_len;
+
+static void put(uint8_t c){
+	if(dump_len < sizeof(dump)) dump[dump_len++] = c;
+}
+
+static void setup(void){
+	sim_regfile_init(&dev, 0x40);
+	sim_attach(TEST_TWI, &dev.dev);
+	set_deadline_timer_TWI(TEST_TC);
+	set_deadline_TWI(TWI_DEADLINE_DEFAULT_US);
+	enable_TWI(TEST_TWI, BAUD_100K, TIMEOUT_DIS);
+	twi_trace_clear();
+	dump_len = 0;
+}
+
+//returns 1 when event n of the buffer is type with arg
+static uint8_t event_is(uint8_t n, uint8_t type, uint8_t arg){
+	return (twi_trace_buf[n].type == type) && (twi_trace_buf[n].arg == arg);
+}
+
+static void test_record(void){
+	uint8_t data = 0;
+	uint16_t ticks;
+	
+	setup();
+	dev.regs[0x20] = 0x5A;
+	
+	CHECK_EQ(write_8bit_register_TWI(TEST_TWI, 0x40, 0xA5, 0x10), TWI_STATUS_OK);
+	CHECK_EQ(read_8bit_register_TWI(TEST_TWI, 0x40, &data, 0x20), TWI_STATUS_OK);
+	CHECK_EQ(twi_trace_head, 12);
+	CHECK_EQ(twi_trace_full, 0);
+	
+	CHECK(event_is(0, TWI_EV_START, 0x40 << 1));
+	CHECK(event_is(1, TWI_EV_ACK, 0));
+	CHECK(event_is(2, TWI_EV_BYTE_OUT, 0x10));
+	CHECK(event_is(3, TWI_EV_BYTE_OUT, 0xA5));
+	CHECK(event_is(4, TWI_EV_STOP, 0));
+	CHECK(event_is(5, TWI_EV_START, 0x40 << 1));
+	CHECK(event_is(8, TWI_EV_RSTART, (0x40 << 1) | READ));
+	CHECK(event_is(10, TWI_EV_BYTE_IN, 0x5A));
+	CHECK(event_is(11, TWI_EV_STOP, 0));
+	
+	//the address and 2 bytes at 100 kHz are at least 270 us between the start and the stop
+	ticks = twi_trace_buf[4].time - twi_trace_buf[0].time;
+	CHECK(ticks >= (F_CPU / TWI_TIMER_DIV / 1000UL) * 270 / 1000);
+	CHECK(ticks < (F_CPU / TWI_TIMER_DIV / 1000UL) * 400 / 1000);
+	
+	//a NACK and the stop it causes
+	CHECK_EQ(start_TWI(TEST_TWI, 0x41, WRITE), NACK);
+	CHECK(event_is(13, TWI_EV_NACK, 0));
+	CHECK(event_is(14, TWI_EV_STOP, 0));
+	
+	twi_trace_clear();
+	CHECK_EQ(twi_trace_head, 0);
+	CHECK_EQ(twi_trace_full, 0);
+}
+
+static void test_dump(void){
+	uint8_t i;
+	uint8_t *e;
+	uint16_t ticks_per_ms = F_CPU / TWI_TIMER_DIV / 1000;
+	
+	setup();
+	
+	//every write is 5 events, the oldest ones are overwritten
+	for(i = 0; i < 20; i++) CHECK_EQ(write_8bit_register_TWI(TEST_TWI, 0x40, i, 0x10), TWI_STATUS_OK);
+	CHECK_EQ(twi_trace_full, 1);
+	
+	twi_trace_dump(put);
+	CHECK_EQ(dump_len, 9 + 4 * TWI_TRACE_SIZE);
+	CHECK(memcmp(dump, TWI_TRACE_MAGIC, 4) == 0);
+	CHECK_EQ(dump[4], TWI_TRACE_VERSION);
+	CHECK_EQ(dump[5] | (dump[6] << 8), ticks_per_ms);
+	CHECK_EQ(dump[7] | (dump[8] << 8), TWI_TRACE_SIZE);
+	
+	//100 events were recorded, the dump starts with event 36: the ACK of write 7
+	e = &dump[9];
+	CHECK_EQ(e[2], TWI_EV_ACK);
+	e = &dump[9 + 4 * 2];
+	CHECK_EQ(e[2], TWI_EV_BYTE_OUT);
+	CHECK_EQ(e[3], 7);
+	e = &dump[9 + 4 * (TWI_TRACE_SIZE - 1)];
+	CHECK_EQ(e[2], TWI_EV_STOP);
+}
+
+//runs the decoder on the dump and returns its output
+static char *decode(void){
+	static char out[8192];
+	char path[] = "/tmp/twi_traceXXXXXX";
+	char cmd[512];
+	FILE *f;
+	size_t n;
+	int fd;
+	
+	fd = mkstemp(path);
+	if(fd < 0) return 0;
+	if(write(fd, dump, dump_len) != dump_len){
+		close(fd);
+		unlink(path);
+		return 0;
+	}
+	close(fd);
+	
+	snprintf(cmd, sizeof(cmd), "%s %s 2>/dev/null", TEST_DECODER, path);
+	f = popen(cmd, "r");
+	if(f == 0){
+		unlink(path);
+		return 0;
+	}
+	n = fread(out, 1, sizeof(out) - 1, f);
+	out[n] = 0;
+	if(pclose(f) != 0) out[0] = 0;
+	unlink(path);
+	return out;
+}
+
+static void test_decode(void){
+	uint8_t data = 0;
+	char *out;
+	
+	setup();
+	dev.regs[0x20] = 0x5A;
+	
+	CHECK_EQ(write_8bit_register_TWI(TEST_TWI, 0x40, 0xA5, 0x10), TWI_STATUS_OK);
+	CHECK_EQ(read_8bit_register_TWI(TEST_TWI, 0x40, &data, 0x20), TWI_STATUS_OK);
+	CHECK_EQ(start_TWI(TEST_TWI, 0x41, WRITE), NACK);
+	sim_inject(TEST_TWI, SIM_INJECT_ARBLOST);
+	CHECK_EQ(start_TWI(TEST_TWI, 0x40, WRITE), TWI_ARB_LOST);
+	twi_trace_dump(put);
+	
+	out = decode();
+	CHECK(out != 0);
+	if(out == 0) return;
+	
+	CHECK(strstr(out, "  START  0x40 W\n") != 0);
+	CHECK(strstr(out, "  > 0x10\n") != 0);
+	CHECK(strstr(out, "  > 0xA5\n") != 0);
+	CHECK(strstr(out, "  RSTART 0x40 R\n") != 0);
+	CHECK(strstr(out, "  < 0x5A\n") != 0);
+	CHECK(strstr(out, "  START  0x41 W\n") != 0);
+	CHECK(strstr(out, "  ERROR  ARB_LOST\n") != 0);
+	CHECK(strstr(out, "\n4 transactions, bus busy ") != 0);
+	
+	//address, starts, NACKs and bytes
+	CHECK(strstr(out, "  0x40        4      0        4") != 0);
+	CHECK(strstr(out, "  0x41        1      1        0") != 0);
+	
+	//a dump that isn't one is refused
+	dump[0] = 'X';
+	out = decode();
+	CHECK( (out == 0) || (out[0] == 0) );
+}
+
+int main(void){
+	sim_init();
+	
+	RUN(test_record);
+	RUN(test_dump);
+	RUN(test_decode);
+	
+	return test_result(TEST_FAMILY);
+}
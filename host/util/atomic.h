@@ -0,0 +1,58 @@
+/*
+ * File atomic.h
+ * Author: Tycho Jöbsis
+ * Date: 16-10-2026
+ */ 
+
+/*
+*	MIT License
+*
+*	Copyright (c) 2021 TychoJ
+*
+*	Permission is hereby granted, free of charge, to any person obtaining a copy
+*	of this software and associated documentation files (the "Software"), to deal
+*	in the Software without restriction, including without limitation the rights
+*	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*	copies of the Software, and to permit persons to whom the Software is
+*	furnished to do so, subject to the following conditions:
+*
+*	The above copyright notice and this permission notice shall be included in all
+*	copies or substantial portions of the Software.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*	SOFTWARE.
+*/
+
+#ifndef HOST_UTIL_ATOMIC_H_
+#define HOST_UTIL_ATOMIC_H_
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+
+//the same construction as avr-libc, the interrupt flag is restored when the block is left
+
+static __inline__ uint8_t sim_atomic_cli(void){
+	cli();
+	return 1;
+}
+
+static __inline__ void sim_atomic_restore(const uint8_t *sreg){
+	SREG = *sreg;
+}
+
+static __inline__ void sim_atomic_on(const uint8_t *sreg){
+	(void)sreg;
+	sei();
+}
+
+#define ATOMIC_RESTORESTATE		uint8_t sim_sreg_save __attribute__((__cleanup__(sim_atomic_restore))) = SREG
+#define ATOMIC_FORCEON			uint8_t sim_sreg_save __attribute__((__cleanup__(sim_atomic_on))) = 0
+
+#define ATOMIC_BLOCK(type)		for(type, sim_todo = sim_atomic_cli(); sim_todo; sim_todo = 0)
+
+#endif /* HOST_UTIL_ATOMIC_H_ */
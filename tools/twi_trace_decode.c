@@ -0,0 +1,213 @@
+/*
+ * File twi_trace_decode.c
+ * Author: Tycho Jöbsis
+ * Date: 16-10-2026
+ */ 
+
+/*
+*	MIT License
+*
+*	Copyright (c) 2021 TychoJ
+*
+*	Permission is hereby granted, free of charge, to any person obtaining a copy
+*	of this software and associated documentation files (the "Software"), to deal
+*	in the Software without restriction, including without limitation the rights
+*	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*	copies of the Software, and to permit persons to whom the Software is
+*	furnished to do so, subject to the following conditions:
+*
+*	The above copyright notice and this permission notice shall be included in all
+*	copies or substantial portions of the Software.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*	SOFTWARE.
+*/
+
+/*
+ * Turns a dump of twi_trace_dump into a readable transcript and timing statistics.
+ *
+ * Build: cc -O2 -o twi_trace_decode tools/twi_trace_decode.c, or make -C host decoder
+ * Usage: twi_trace_decode [dump file]   (reads stdin without a file)
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#define TWI_EV_START		1
+#define TWI_EV_RSTART		2
+#define TWI_EV_ACK			3
+#define TWI_EV_NACK			4
+#define TWI_EV_BYTE_OUT		5
+#define TWI_EV_BYTE_IN		6
+#define TWI_EV_STOP			7
+#define TWI_EV_ERROR		8
+#define TWI_EV_RECOVERY		9
+
+#define TWI_TRACE_VERSION	1
+
+//status codes of twi.h
+#define DATA_NOT_SEND 10
+#define DATA_NOT_RECEIVED 7
+#define TWI_ARB_LOST 8
+#define TWI_BUS_ERROR 9
+
+typedef struct {
+	uint32_t transactions;
+	uint32_t nacks;
+	uint32_t bytes;
+	double total_us;
+	double max_us;
+} addr_stats_t;
+
+static addr_stats_t addr_stats[128];
+
+static int read_u16(FILE *f, uint16_t *v){
+	int lo = fgetc(f);
+	int hi = fgetc(f);
+	
+	if( (lo == EOF) || (hi == EOF) ) return 0;
+	*v = (uint16_t)(lo | (hi << 8));
+	return 1;
+}
+
+static const char *error_name(uint8_t code){
+	switch(code){
+		case DATA_NOT_SEND: return "DATA_NOT_SEND";
+		case DATA_NOT_RECEIVED: return "DATA_NOT_RECEIVED";
+		case TWI_ARB_LOST: return "ARB_LOST";
+		case TWI_BUS_ERROR: return "BUS_ERROR";
+		default: return "UNKNOWN";
+	}
+}
+
+int main(int argc, char **argv){
+	FILE *f = stdin;
+	char magic[4];
+	int version;
+	uint16_t ticks_per_ms;
+	uint16_t count;
+	uint16_t n;
+	uint16_t last_time = 0;
+	double now_us = 0;
+	double start_us = 0;
+	int cur_addr = -1;
+	uint32_t transactions = 0;
+	double busy_us = 0;
+	int i;
+	
+	if(argc > 1){
+		f = fopen(argv[1], "rb");
+		if(f == NULL){
+			perror(argv[1]);
+			return 1;
+		}
+	}
+	
+	if( (fread(magic, 1, 4, f) != 4) || (memcmp(magic, "TWTR", 4) != 0) ){
+		fprintf(stderr, "not a TWI trace dump\n");
+		return 1;
+	}
+	
+	version = fgetc(f);
+	if(version != TWI_TRACE_VERSION){
+		fprintf(stderr, "unsupported trace version %d\n", version);
+		return 1;
+	}
+	
+	if( !read_u16(f, &ticks_per_ms) || !read_u16(f, &count) || (ticks_per_ms == 0) ){
+		fprintf(stderr, "truncated header\n");
+		return 1;
+	}
+	
+	printf("%12s  %s\n", "time [us]", "event");
+	
+	for(n = 0; n < count; n++){
+		uint16_t time;
+		int type;
+		int arg;
+		
+		if( !read_u16(f, &time) || ((type = fgetc(f)) == EOF) || ((arg = fgetc(f)) == EOF) ){
+			fprintf(stderr, "truncated after %u of %u events\n", n, count);
+			break;
+		}
+		
+		//the timer is 16 bit, every event is assumed to be less than one wrap after the previous one
+		if(n != 0) now_us += (uint16_t)(time - last_time) * 1000.0 / ticks_per_ms;
+		last_time = time;
+		
+		printf("%12.1f  ", now_us);
+		
+		switch(type){
+			case TWI_EV_START:
+			case TWI_EV_RSTART:
+			printf("%s 0x%02X %s\n", (type == TWI_EV_START) ? "START " : "RSTART", arg >> 1, (arg & 1) ? "R" : "W");
+			if(type == TWI_EV_START){
+				start_us = now_us;
+				transactions++;
+			}
+			cur_addr = arg >> 1;
+			addr_stats[cur_addr].transactions++;
+			break;
+			
+			case TWI_EV_ACK:
+			printf("  ACK\n");
+			break;
+			
+			case TWI_EV_NACK:
+			printf("  NACK\n");
+			if(cur_addr >= 0) addr_stats[cur_addr].nacks++;
+			break;
+			
+			case TWI_EV_BYTE_OUT:
+			printf("  > 0x%02X\n", arg);
+			if(cur_addr >= 0) addr_stats[cur_addr].bytes++;
+			break;
+			
+			case TWI_EV_BYTE_IN:
+			printf("  < 0x%02X\n", arg);
+			if(cur_addr >= 0) addr_stats[cur_addr].bytes++;
+			break;
+			
+			case TWI_EV_STOP:
+			printf("STOP   (%.1f us)\n", now_us - start_us);
+			if(cur_addr >= 0){
+				addr_stats[cur_addr].total_us += now_us - start_us;
+				if( (now_us - start_us) > addr_stats[cur_addr].max_us ) addr_stats[cur_addr].max_us = now_us - start_us;
+			}
+			busy_us += now_us - start_us;
+			cur_addr = -1;
+			break;
+			
+			case TWI_EV_ERROR:
+			printf("ERROR  %s\n", error_name(arg));
+			break;
+			
+			case TWI_EV_RECOVERY:
+			printf("RECOVERY\n");
+			break;
+			
+			default:
+			printf("? type %d arg 0x%02X\n", type, arg);
+			break;
+		}
+	}
+	
+	printf("\n%u transactions, bus busy %.1f us of %.1f us\n", transactions, busy_us, now_us);
+	printf("%6s %8s %6s %8s %12s %10s %10s\n", "addr", "starts", "nacks", "bytes", "total [us]", "avg [us]", "max [us]");
+	
+	for(i = 0; i < 128; i++){
+		addr_stats_t *s = &addr_stats[i];
+		
+		if(s->transactions == 0) continue;
+		printf("  0x%02X %8u %6u %8u %12.1f %10.1f %10.1f\n", i, s->transactions, s->nacks, s->bytes, s->total_us, s->total_us / s->transactions, s->max_us);
+	}
+	
+	if(f != stdin) fclose(f);
+	return 0;
+}